@@ -0,0 +1,525 @@
+// Throughput benchmark of the front end: the lexer (src/lexer.cpp) alone,
+//     the lexer feeding the parser (src/parser.cpp) into prolog terms or
+//     native terms, native terms rebuilt from a compiled module
+//     (src/compiled_module.cpp) instead of parsed, and prolog terms written
+//     back out as text (src/serializer.cpp).
+//     synthetic corpora stress one shape of input each. results are printed
+//     one JSON object per line, so that runs can be diffed across commits.
+//     the depth_scaling corpus instead times single statements nested ever
+//     deeper, to show that cost per level stays flat as depth grows.
+//
+// usage: frontend_bench [--label TEXT] [--size MiB] [--warmup N] [--repetitions N] [--corpus NAME]
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <iostream>
+#include <functional>
+#include <sstream>
+#include <filesystem>
+#include <SWI-Prolog.h>
+
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "ast.hpp"
+#include "compiled_module.hpp"
+#include "serializer.hpp"
+#include "json.hpp"
+
+////////////////////////////////
+//// ALLOCATION COUNTING
+////////////////////////////////
+
+// every c++ heap allocation in the process. prolog's own allocations
+//     are made with malloc, and are not counted.
+static std::atomic<size_t> s_allocations{0};
+
+void *operator new(size_t a_size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *l_result = std::malloc(a_size == 0 ? 1 : a_size))
+        return l_result;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t a_size)
+{
+    return operator new(a_size);
+}
+
+void *operator new(size_t a_size, const std::nothrow_t &) noexcept
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(a_size == 0 ? 1 : a_size);
+}
+
+void *operator new[](size_t a_size, const std::nothrow_t &a_tag) noexcept
+{
+    return operator new(a_size, a_tag);
+}
+
+void operator delete(void *a_pointer) noexcept { std::free(a_pointer); }
+void operator delete[](void *a_pointer) noexcept { std::free(a_pointer); }
+void operator delete(void *a_pointer, size_t) noexcept { std::free(a_pointer); }
+void operator delete[](void *a_pointer, size_t) noexcept { std::free(a_pointer); }
+
+////////////////////////////////
+//// CORPORA
+////////////////////////////////
+
+// each generator appends one or more statements, numbered by a_index
+using statement_generator = std::function<void(std::string &, size_t, std::mt19937 &)>;
+
+static std::string make_corpus(const statement_generator &a_generator, size_t a_size)
+{
+    std::mt19937 l_generator(7);
+
+    std::string l_result;
+    l_result.reserve(a_size + 4096);
+
+    for (size_t i = 0; l_result.size() < a_size; i++)
+        a_generator(l_result, i, l_generator);
+
+    return l_result;
+}
+
+// many short atoms in a single flat list
+static void wide_flat(std::string &a_out, size_t a_index, std::mt19937 &a_generator)
+{
+    a_out += "axiom w" + std::to_string(a_index) + " [";
+
+    for (size_t i = 0; i < 64; i++)
+        a_out += "a" + std::to_string(a_generator() % 512) + " ";
+
+    a_out += "];\n";
+}
+
+// lists nested inside lists, as long chains of implications are
+static void deep_nested(std::string &a_out, size_t a_index, std::mt19937 &a_generator)
+{
+    constexpr size_t DEPTH = 256;
+
+    a_out += "axiom d" + std::to_string(a_index) + " ";
+
+    for (size_t i = 0; i < DEPTH; i++)
+        a_out += "[if p" + std::to_string(a_generator() % 16) + " ";
+
+    a_out += "x";
+    a_out.append(DEPTH, ']');
+    a_out += ";\n";
+}
+
+// long quoted atoms, a few of them escaped
+static void long_quoted(std::string &a_out, size_t a_index, std::mt19937 &a_generator)
+{
+    a_out += "axiom q" + std::to_string(a_index) + " [claim '";
+
+    for (size_t i = 0; i < 512; i++)
+        a_out.push_back("abcdefghijklmnopqrstuvwxyz ./+-"[a_generator() % 31]);
+
+    a_out += a_index % 4 == 0 ? "\\x41\\n' \"" : "' \"";
+
+    for (size_t i = 0; i < 256; i++)
+        a_out.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123"[a_generator() % 30]);
+
+    a_out += "\"];\n";
+}
+
+// short statements buried in comments
+static void comment_heavy(std::string &a_out, size_t a_index, std::mt19937 &a_generator)
+{
+    for (size_t i = 0; i < 6; i++)
+    {
+        a_out += "# ";
+
+        for (size_t j = 0; j < 72; j++)
+            a_out.push_back("abcdefghijklmnopqrstuvwxyz [];'|"[a_generator() % 32]);
+
+        a_out += "\n";
+    }
+
+    a_out += "axiom c" + std::to_string(a_index) + " [if y x]; # trailing comment\n";
+}
+
+// statements made mostly of variables, repeated and fresh
+static void variable_heavy(std::string &a_out, size_t a_index, std::mt19937 &a_generator)
+{
+    a_out += "redir r" + std::to_string(a_index) + " [g";
+
+    for (size_t i = 0; i < 48; i++)
+        a_out += " [V" + std::to_string(a_generator() % 24) + " _ | Tail" + std::to_string(i % 8) + "]";
+
+    a_out += "];\n";
+}
+
+////////////////////////////////
+//// MEASUREMENT
+////////////////////////////////
+
+struct options
+{
+    std::string m_label = "";
+    size_t m_size = 4 * 1024 * 1024;
+    int m_warmup = 2;
+    int m_repetitions = 15;
+    std::string m_corpus = "";
+};
+
+struct counts
+{
+    size_t m_lexemes = 0;
+    size_t m_statements = 0;
+};
+
+static counts lex_corpus(const std::string &a_corpus)
+{
+    counts l_result;
+
+    unilog::lexer l_lexer(a_corpus);
+
+    for (unilog::lexeme l_lexeme; l_lexer >> l_lexeme; ++l_result.m_lexemes)
+        if (std::holds_alternative<unilog::eol>(l_lexeme))
+            ++l_result.m_statements;
+
+    return l_result;
+}
+
+static counts parse_corpus(const std::string &a_corpus)
+{
+    counts l_result;
+
+    unilog::lexer l_lexer(a_corpus);
+
+    for (;;)
+    {
+        // terms of one statement are dropped before the next is parsed
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::statement l_statement;
+        bool l_extracted = static_cast<bool>(l_lexer >> l_statement);
+
+        PL_discard_foreign_frame(l_frame);
+
+        if (!l_extracted)
+            break;
+
+        ++l_result.m_statements;
+    }
+
+    return l_result;
+}
+
+// value at quantile a_quantile of sorted samples (nearest rank)
+static double quantile(const std::vector<double> &a_sorted, double a_quantile)
+{
+    size_t l_rank = static_cast<size_t>(a_quantile * a_sorted.size() + 0.999999);
+    return a_sorted[std::clamp<size_t>(l_rank, 1, a_sorted.size()) - 1];
+}
+
+static void measure(const options &a_options,
+                    const std::string &a_corpus_name,
+                    const std::string &a_stage,
+                    const std::string &a_corpus,
+                    size_t a_lexemes,
+                    const std::function<counts(const std::string &)> &a_run)
+{
+    for (int i = 0; i < a_options.m_warmup; i++)
+        a_run(a_corpus);
+
+    std::vector<double> l_seconds;
+    size_t l_allocations = 0;
+    counts l_counts;
+
+    for (int i = 0; i < a_options.m_repetitions; i++)
+    {
+        size_t l_allocations_before = s_allocations.load(std::memory_order_relaxed);
+
+        auto l_start = std::chrono::steady_clock::now();
+
+        l_counts = a_run(a_corpus);
+
+        std::chrono::duration<double> l_elapsed = std::chrono::steady_clock::now() - l_start;
+
+        l_allocations += s_allocations.load(std::memory_order_relaxed) - l_allocations_before;
+        l_seconds.push_back(l_elapsed.count());
+    }
+
+    std::sort(l_seconds.begin(), l_seconds.end());
+
+    // rates at the median time, and at the 95th percentile (slowest) time
+    double l_median = quantile(l_seconds, 0.5);
+    double l_p95 = quantile(l_seconds, 0.95);
+    double l_mb = a_corpus.size() / 1e6;
+
+    double l_allocations_per_statement =
+        l_counts.m_statements == 0 ? 0 : double(l_allocations) / a_options.m_repetitions / l_counts.m_statements;
+
+    std::cout << "{\"bench\":\"frontend\""
+              << ",\"label\":" << unilog::json(a_options.m_label).dump()
+              << ",\"corpus\":\"" << a_corpus_name << "\""
+              << ",\"stage\":\"" << a_stage << "\""
+              << ",\"bytes\":" << a_corpus.size()
+              << ",\"statements\":" << l_counts.m_statements
+              << ",\"lexemes\":" << a_lexemes
+              << ",\"warmup\":" << a_options.m_warmup
+              << ",\"repetitions\":" << a_options.m_repetitions
+              << ",\"seconds_median\":" << l_median
+              << ",\"seconds_p95\":" << l_p95
+              << ",\"mb_per_sec_median\":" << l_mb / l_median
+              << ",\"mb_per_sec_p95\":" << l_mb / l_p95
+              << ",\"lexemes_per_sec_median\":" << a_lexemes / l_median
+              << ",\"lexemes_per_sec_p95\":" << a_lexemes / l_p95
+              << ",\"statements_per_sec_median\":" << l_counts.m_statements / l_median
+              << ",\"statements_per_sec_p95\":" << l_counts.m_statements / l_p95
+              << ",\"allocations_per_statement\":" << l_allocations_per_statement
+              << "}" << std::endl;
+}
+
+// one statement of a_depth nested [mp ...] lists, as generated guides are
+static std::string make_deep_statement(size_t a_depth)
+{
+    std::string l_result = "infer i ";
+
+    for (size_t i = 0; i < a_depth; i++)
+        l_result += "[mp ";
+
+    l_result += "x";
+    l_result.append(a_depth, ']');
+    l_result += ";\n";
+
+    return l_result;
+}
+
+static counts parse_ast_corpus(const std::string &a_corpus)
+{
+    counts l_result;
+
+    unilog::ast_arena l_arena;
+    unilog::lexer l_lexer(a_corpus);
+
+    for (unilog::ast_statement l_statement; unilog::parse_statement(l_lexer, l_arena, l_statement); l_arena.clear())
+        ++l_result.m_statements;
+
+    return l_result;
+}
+
+// parses a_corpus natively and writes it out as a compiled module, which
+//     is then opened as the executor would open it
+static std::unique_ptr<unilog::compiled_module> compile_corpus(const std::string &a_corpus)
+{
+    std::filesystem::path l_path = std::filesystem::temp_directory_path() / "unilog_frontend_bench.uc";
+
+    unilog::compiled_module_writer l_writer;
+    unilog::ast_arena l_arena;
+    unilog::lexer l_lexer(a_corpus);
+
+    for (unilog::ast_statement l_statement; unilog::parse_statement(l_lexer, l_arena, l_statement); l_arena.clear())
+        l_writer.add(l_statement);
+
+    unilog::source_stamp l_stamp{.m_size = a_corpus.size()};
+
+    if (!l_writer.write(l_path, l_stamp))
+        return nullptr;
+
+    std::unique_ptr<unilog::compiled_module> l_result = unilog::compiled_module::open(l_path, l_stamp);
+
+    std::filesystem::remove(l_path);
+
+    return l_result;
+}
+
+// rebuilds every statement of a compiled module, as a refer of a fresh
+//     compiled module does instead of lexing and parsing
+static counts rebuild_compiled(const unilog::compiled_module &a_module)
+{
+    counts l_result;
+
+    unilog::ast_arena l_arena;
+    unilog::ast_statement l_statement;
+
+    for (size_t i = 0; i < a_module.statement_count(); ++i, l_arena.clear())
+    {
+        a_module.statement(i, l_arena, l_statement);
+        ++l_result.m_statements;
+    }
+
+    return l_result;
+}
+
+// the statements of a_corpus as prolog terms, on the current frame
+static std::vector<unilog::statement> read_corpus(const std::string &a_corpus)
+{
+    std::vector<unilog::statement> l_result;
+
+    unilog::lexer l_lexer(a_corpus);
+
+    for (unilog::statement l_statement; l_lexer >> l_statement;)
+        l_result.push_back(l_statement);
+
+    return l_result;
+}
+
+// writes statements back out as .u text, as an export of theorems does
+static counts serialize_statements(const std::vector<unilog::statement> &a_statements)
+{
+    counts l_result;
+
+    std::ostringstream l_oss;
+    unilog::serializer l_serializer(l_oss);
+
+    for (const unilog::statement &l_statement : a_statements)
+    {
+        l_serializer.write(l_statement);
+        ++l_result.m_statements;
+    }
+
+    return l_result;
+}
+
+// times parsing one statement at increasing depths, natively and into
+//     prolog terms. a depth that overflowed the call stack would crash here.
+static void measure_depth_scaling(const options &a_options)
+{
+    for (size_t l_depth : {1000, 10000, 100000, 1000000})
+    {
+        std::string l_statement = make_deep_statement(l_depth);
+
+        const std::pair<const char *, counts (*)(const std::string &)> l_stages[] =
+            {
+                {"ast", parse_ast_corpus},
+                {"parse", parse_corpus},
+            };
+
+        for (const auto &[l_stage, l_run] : l_stages)
+        {
+            for (int i = 0; i < a_options.m_warmup; i++)
+                l_run(l_statement);
+
+            std::vector<double> l_seconds;
+
+            for (int i = 0; i < a_options.m_repetitions; i++)
+            {
+                auto l_start = std::chrono::steady_clock::now();
+
+                l_run(l_statement);
+
+                std::chrono::duration<double> l_elapsed = std::chrono::steady_clock::now() - l_start;
+                l_seconds.push_back(l_elapsed.count());
+            }
+
+            std::sort(l_seconds.begin(), l_seconds.end());
+
+            double l_median = quantile(l_seconds, 0.5);
+            double l_p95 = quantile(l_seconds, 0.95);
+
+            std::cout << "{\"bench\":\"frontend_depth\""
+                      << ",\"label\":" << unilog::json(a_options.m_label).dump()
+                      << ",\"stage\":\"" << l_stage << "\""
+                      << ",\"depth\":" << l_depth
+                      << ",\"bytes\":" << l_statement.size()
+                      << ",\"warmup\":" << a_options.m_warmup
+                      << ",\"repetitions\":" << a_options.m_repetitions
+                      << ",\"seconds_median\":" << l_median
+                      << ",\"seconds_p95\":" << l_p95
+                      << ",\"ns_per_level_median\":" << l_median * 1e9 / l_depth
+                      << ",\"ns_per_level_p95\":" << l_p95 * 1e9 / l_depth
+                      << "}" << std::endl;
+        }
+    }
+}
+
+static options parse_options(int argc, char **argv)
+{
+    options l_result;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string l_flag = argv[i];
+        const char *l_value = argv[i + 1];
+
+        if (l_flag == "--label")
+            l_result.m_label = l_value;
+        else if (l_flag == "--size")
+            l_result.m_size = std::strtoull(l_value, nullptr, 10) * 1024 * 1024;
+        else if (l_flag == "--warmup")
+            l_result.m_warmup = std::atoi(l_value);
+        else if (l_flag == "--repetitions")
+            l_result.m_repetitions = std::max(1, std::atoi(l_value));
+        else if (l_flag == "--corpus")
+            l_result.m_corpus = l_value;
+        else
+        {
+            std::cerr << "unknown flag: " << l_flag << std::endl;
+            std::exit(1);
+        }
+    }
+
+    return l_result;
+}
+
+int main(int argc, char **argv)
+{
+    options l_options = parse_options(argc, argv);
+
+    const char *plav[] = {argv[0], "--quiet", "--nosignals"};
+
+    if (!PL_initialise(3, const_cast<char **>(plav)))
+        PL_halt(1);
+
+    std::vector<std::pair<std::string, statement_generator>> l_corpora =
+        {
+            {"wide_flat", wide_flat},
+            {"deep_nested", deep_nested},
+            {"long_quoted", long_quoted},
+            {"comment_heavy", comment_heavy},
+            {"variable_heavy", variable_heavy},
+        };
+
+    for (const auto &[l_name, l_generator] : l_corpora)
+    {
+        if (!l_options.m_corpus.empty() && l_options.m_corpus != l_name)
+            continue;
+
+        std::string l_corpus = make_corpus(l_generator, l_options.m_size);
+
+        size_t l_lexemes = lex_corpus(l_corpus).m_lexemes;
+
+        measure(l_options, l_name, "lex", l_corpus, l_lexemes, lex_corpus);
+        measure(l_options, l_name, "parse", l_corpus, l_lexemes, parse_corpus);
+        measure(l_options, l_name, "ast", l_corpus, l_lexemes, parse_ast_corpus);
+
+        // the mapped module stays open, so only rebuilding is timed
+        if (std::unique_ptr<unilog::compiled_module> l_module = compile_corpus(l_corpus))
+            measure(l_options, l_name, "compiled", l_corpus, l_lexemes,
+                    [&l_module](const std::string &)
+                    { return rebuild_compiled(*l_module); });
+
+        /////////////////////////////////////////
+        // the terms are built once, and only writing them is timed. rates
+        //     are of the corpus as it was read.
+        /////////////////////////////////////////
+        fid_t l_frame = PL_open_foreign_frame();
+
+        std::vector<unilog::statement> l_statements = read_corpus(l_corpus);
+
+        measure(l_options, l_name, "serialize", l_corpus, l_lexemes,
+                [&l_statements](const std::string &)
+                { return serialize_statements(l_statements); });
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    if (l_options.m_corpus.empty() || l_options.m_corpus == "depth_scaling")
+        measure_depth_scaling(l_options);
+
+    PL_halt(0);
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Microbenchmark of the lexer's scanning kernels (src/scan.cpp).
+//     reports bytes/sec for every instruction set this cpu supports,
+//     with speedups over the original lexer's loops, which classified
+//     each char through <cctype>. the scalar kernels are the table-driven
+//     fallback, not that baseline.
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <initializer_list>
+#include <cctype>
+
+#include "scan.hpp"
+
+using unilog::get_scan_kernels;
+using unilog::scan_isa;
+using unilog::scan_kernels;
+
+constexpr size_t CORPUS_SIZE = 16 * 1024 * 1024;
+constexpr int REPETITIONS = 9;
+
+////////////////////////////////
+//// BASELINE
+////////////////////////////////
+
+// the loops of the lexer before the scan kernels, over a buffer
+//     rather than a stream, so that only their classification is timed
+
+static const char *skip_whitespace_cctype(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && std::isspace((unsigned char)*a_pos) != 0)
+        ++a_pos;
+
+    return a_pos;
+}
+
+static const char *skip_identifier_cctype(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && (std::isalnum((unsigned char)*a_pos) != 0 || *a_pos == '_'))
+        ++a_pos;
+
+    return a_pos;
+}
+
+// comments were always ended by comparing each char with '\n'
+static const char *find_newline_cctype(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && *a_pos != '\n')
+        ++a_pos;
+
+    return a_pos;
+}
+
+// runs of a_run_chars with mean length a_mean_run, each ended by a_terminator
+static std::string make_corpus(const std::string &a_run_chars, char a_terminator, size_t a_mean_run)
+{
+    std::mt19937 l_generator(7);
+    std::uniform_int_distribution<size_t> l_run_distribution(a_mean_run / 2, a_mean_run + a_mean_run / 2);
+    std::uniform_int_distribution<size_t> l_char_distribution(0, a_run_chars.size() - 1);
+
+    std::string l_result;
+    l_result.reserve(CORPUS_SIZE);
+
+    while (l_result.size() < CORPUS_SIZE)
+    {
+        size_t l_run = l_run_distribution(l_generator);
+
+        for (size_t i = 0; i < l_run; ++i)
+            l_result.push_back(a_run_chars[l_char_distribution(l_generator)]);
+
+        l_result.push_back(a_terminator);
+    }
+
+    return l_result;
+}
+
+// scans the whole corpus run by run, returning bytes/sec (median of repetitions)
+static double measure(const char *(*a_kernel)(const char *, const char *), const std::string &a_corpus)
+{
+    std::vector<double> l_rates;
+
+    const char *l_end = a_corpus.data() + a_corpus.size();
+
+    for (int i = 0; i < REPETITIONS; ++i)
+    {
+        size_t l_runs = 0;
+
+        auto l_start = std::chrono::steady_clock::now();
+
+        for (const char *l_pos = a_corpus.data(); l_pos < l_end; ++l_pos, ++l_runs)
+            l_pos = a_kernel(l_pos, l_end);
+
+        std::chrono::duration<double> l_elapsed = std::chrono::steady_clock::now() - l_start;
+
+        // keep the loop from being optimized away
+        if (l_runs == 0)
+            std::cerr << "empty corpus" << std::endl;
+
+        l_rates.push_back(a_corpus.size() / l_elapsed.count());
+    }
+
+    std::sort(l_rates.begin(), l_rates.end());
+
+    return l_rates[l_rates.size() / 2];
+}
+
+int main()
+{
+    struct kernel_case
+    {
+        std::string m_name;
+        const char *(*scan_kernels::*m_kernel)(const char *, const char *);
+        const char *(*m_baseline)(const char *, const char *);
+        std::string m_corpus;
+    };
+
+    const std::string l_identifier_chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    const std::string l_comment_chars = l_identifier_chars + " []|;'\"#";
+
+    std::vector<kernel_case> l_cases =
+        {
+            {"whitespace", &scan_kernels::m_skip_whitespace, skip_whitespace_cctype, make_corpus(" \t\n\r", 'x', 32)},
+            {"identifier", &scan_kernels::m_skip_identifier, skip_identifier_cctype, make_corpus(l_identifier_chars, ' ', 24)},
+            {"comment", &scan_kernels::m_find_newline, find_newline_cctype, make_corpus(l_comment_chars, '\n', 72)},
+        };
+
+    std::cout << std::left << std::setw(12) << "kernel"
+              << std::setw(8) << "isa"
+              << std::right << std::setw(14) << "MB/sec"
+              << std::setw(10) << "speedup" << std::endl;
+
+    for (const kernel_case &l_case : l_cases)
+    {
+        double l_baseline_rate = measure(l_case.m_baseline, l_case.m_corpus);
+
+        auto l_report = [&l_case, l_baseline_rate](const char *a_name, double a_rate)
+        {
+            std::cout << std::left << std::setw(12) << l_case.m_name
+                      << std::setw(8) << a_name
+                      << std::right << std::setw(14) << std::fixed << std::setprecision(1) << a_rate / 1e6
+                      << std::setw(9) << std::setprecision(2) << a_rate / l_baseline_rate << "x" << std::endl;
+        };
+
+        l_report("cctype", l_baseline_rate);
+
+        for (auto [l_isa, l_isa_name] : {std::pair{scan_isa::scalar, "scalar"},
+                                         std::pair{scan_isa::sse2, "sse2"},
+                                         std::pair{scan_isa::avx2, "avx2"}})
+        {
+            const scan_kernels *l_kernels = get_scan_kernels(l_isa);
+
+            if (l_kernels == nullptr)
+                continue;
+
+            l_report(l_isa_name, measure(l_kernels->*l_case.m_kernel, l_case.m_corpus));
+        }
+    }
+
+    return 0;
+}
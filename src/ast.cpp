@@ -0,0 +1,919 @@
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+#include "ast.hpp"
+#include "variable_table.hpp"
+#include "err_msg.hpp"
+
+// variables of the statement being parsed, numbered in order of first occurrence
+using variable_indexes = unilog::variable_table<uint32_t>;
+
+// a list being extracted: the slot its next cell (or its tail) goes into,
+//     and what it expects next
+struct open_list
+{
+    enum class state : uint8_t
+    {
+        // elements, a '|', or a ']'
+        elements,
+
+        // the single term after a '|'
+        tail,
+
+        // the ']' after the tail
+        close,
+    };
+
+    unilog::ast_term *m_next;
+    state m_state;
+};
+
+// the lexeme source may be a std::istream or a unilog::lexer.
+//     lists are extracted with an explicit stack of the lists still open,
+//     so nesting depth is bounded by memory, not by the call stack.
+template <typename Source>
+static Source &extract_ast_term(Source &a_source, unilog::ast_arena &a_arena, variable_indexes &a_variables, unilog::ast_term &a_term)
+{
+    using unilog::ast_cons;
+    using unilog::ast_term;
+    using state = open_list::state;
+
+    // kept across calls, so that its capacity is reused
+    static thread_local std::vector<open_list> s_open;
+
+    s_open.clear();
+
+    for (;;)
+    {
+        unilog::lexeme l_lexeme;
+
+        a_source >> l_lexeme;
+
+        if (a_source.fail())
+        {
+            // running out of lexemes between terms is not an error here.
+            //     the caller decides.
+            if (s_open.empty())
+                return a_source;
+
+            throw std::runtime_error(ERR_MSG_NO_LIST_CLOSE);
+        }
+
+        open_list *l_list = s_open.empty() ? nullptr : &s_open.back();
+
+        /////////////////////////////////////////
+        // after a tail, only the list_close may follow
+        /////////////////////////////////////////
+        if (l_list != nullptr && l_list->m_state == state::close)
+        {
+            if (!std::holds_alternative<unilog::list_close>(l_lexeme))
+                throw std::runtime_error(ERR_MSG_NO_LIST_CLOSE);
+
+            s_open.pop_back();
+
+            if (s_open.empty())
+                return a_source;
+
+            continue;
+        }
+
+        bool l_in_elements = l_list != nullptr && l_list->m_state == state::elements;
+
+        if (std::holds_alternative<unilog::list_close>(l_lexeme))
+        {
+            // this basically checks if the list termination was expected
+            if (!l_in_elements)
+                throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
+
+            // default tail is always nil
+            *l_list->m_next = ast_term::make_nil();
+
+            s_open.pop_back();
+
+            if (s_open.empty())
+                return a_source;
+
+            continue;
+        }
+
+        if (std::holds_alternative<unilog::list_separator>(l_lexeme))
+        {
+            // this basically checks if the list termination was expected
+            if (!l_in_elements)
+                throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
+
+            l_list->m_state = state::tail;
+
+            continue;
+        }
+
+        /////////////////////////////////////////
+        // the lexeme begins a term. find the slot it goes into:
+        //     the result, the head of a new cell, or a list's tail.
+        /////////////////////////////////////////
+        ast_term *l_slot = &a_term;
+
+        if (l_in_elements)
+        {
+            ast_cons *l_cons = a_arena.make<ast_cons>();
+
+            *l_list->m_next = ast_term::make_cons(l_cons);
+            l_list->m_next = &l_cons->m_tail;
+
+            l_slot = &l_cons->m_head;
+        }
+        else if (l_list != nullptr)
+        {
+            l_slot = l_list->m_next;
+            l_list->m_state = state::close;
+        }
+
+        if (const unilog::atom *l_atom = std::get_if<unilog::atom>(&l_lexeme))
+        {
+            *l_slot = ast_term::make_atom(l_atom->m_text);
+        }
+        else if (const unilog::variable *l_variable = std::get_if<unilog::variable>(&l_lexeme))
+        {
+            static const unilog::symbol s_singleton("_");
+
+            // singletons never get entries in the table
+            if (l_variable->m_identifier == s_singleton)
+            {
+                *l_slot = ast_term::make_fresh_variable();
+            }
+            else
+            {
+                auto [l_index, l_inserted] = a_variables.try_emplace(l_variable->m_identifier, (uint32_t)a_variables.size());
+
+                *l_slot = ast_term::make_variable(*l_index);
+            }
+        }
+        else if (std::holds_alternative<unilog::list_open>(l_lexeme))
+        {
+            // cells are linked into the slot as their heads are extracted
+            *l_slot = ast_term::make_nil();
+
+            s_open.push_back({l_slot, state::elements});
+
+            continue;
+        }
+        else
+        {
+            // failed to extract a term
+            throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
+        }
+
+        /////////////////////////////////////////
+        // a term outside of any list is the whole result
+        /////////////////////////////////////////
+        if (s_open.empty())
+            return a_source;
+    }
+}
+
+template <typename Source>
+static bool extract_ast_statement(Source &a_source, unilog::ast_arena &a_arena, unilog::ast_statement &a_statement)
+{
+    using unilog::ast_statement;
+    using unilog::symbol;
+
+    /////////////////////////////////////////
+    // extract the command lexeme
+    /////////////////////////////////////////
+    unilog::lexeme l_command;
+    a_source >> l_command;
+
+    // if we fail to extract lexeme, gracefully return
+    if (a_source.fail())
+        return false;
+
+    // atom is expected for the command
+    if (!std::holds_alternative<unilog::atom>(l_command))
+        throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+
+    static const symbol s_axiom("axiom");
+    static const symbol s_redir("redir");
+    static const symbol s_infer("infer");
+    static const symbol s_refer("refer");
+
+    symbol l_command_text = std::get<unilog::atom>(l_command).m_text;
+
+    ast_statement l_result;
+
+    if (l_command_text == s_axiom)
+        l_result.m_kind = ast_statement::kind::axiom;
+    else if (l_command_text == s_redir)
+        l_result.m_kind = ast_statement::kind::redir;
+    else if (l_command_text == s_infer)
+        l_result.m_kind = ast_statement::kind::infer;
+    else if (l_command_text == s_refer)
+        l_result.m_kind = ast_statement::kind::refer;
+    else
+        throw std::runtime_error(ERR_MSG_INVALID_COMMAND);
+
+    /////////////////////////////////////////
+    // every command takes two terms
+    /////////////////////////////////////////
+    // kept across calls, so that its storage is reused
+    static thread_local variable_indexes s_variables;
+
+    s_variables.clear();
+
+    if (!(extract_ast_term(a_source, a_arena, s_variables, l_result.m_tag) &&
+          extract_ast_term(a_source, a_arena, s_variables, l_result.m_body)))
+        throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+
+    /////////////////////////////////////////
+    // extracts the expected eol character.
+    /////////////////////////////////////////
+    unilog::lexeme l_eol;
+    a_source >> l_eol;
+
+    if (a_source.fail() || !std::holds_alternative<unilog::eol>(l_eol))
+        throw std::runtime_error(ERR_MSG_NO_EOL);
+
+    /////////////////////////////////////////
+    // keep the variable names, by index
+    /////////////////////////////////////////
+    symbol *l_names = a_arena.make_array<symbol>(s_variables.size());
+
+    s_variables.for_each([l_names](symbol a_name, uint32_t a_index)
+                         { l_names[a_index] = a_name; });
+
+    l_result.m_variables = l_names;
+    l_result.m_variable_count = s_variables.size();
+
+    l_result.m_span = {
+        .m_begin = unilog::get_span(l_command).m_begin,
+        .m_end = unilog::get_span(l_eol).m_end,
+    };
+
+    a_statement = l_result;
+
+    return true;
+}
+
+namespace unilog
+{
+
+    void *ast_arena::allocate_slow(size_t a_size, size_t a_alignment)
+    {
+        /////////////////////////////////////////
+        // oversized allocations get blocks of their own
+        /////////////////////////////////////////
+        if (a_size + a_alignment > BLOCK_SIZE)
+        {
+            m_large_blocks.push_back(std::make_unique<std::byte[]>(a_size + a_alignment));
+
+            std::byte *l_block = m_large_blocks.back().get();
+
+            return l_block + (-reinterpret_cast<uintptr_t>(l_block) & (a_alignment - 1));
+        }
+
+        /////////////////////////////////////////
+        // otherwise move on to the next block, reusing cleared ones
+        /////////////////////////////////////////
+        if (m_pos != nullptr)
+            ++m_block;
+
+        if (m_block == m_blocks.size())
+            m_blocks.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
+
+        m_pos = m_blocks[m_block].get();
+        m_end = m_pos + BLOCK_SIZE;
+
+        return allocate(a_size, a_alignment);
+    }
+
+    void ast_arena::clear()
+    {
+        m_large_blocks.clear();
+
+        m_block = 0;
+        m_pos = m_blocks.empty() ? nullptr : m_blocks[0].get();
+        m_end = m_blocks.empty() ? nullptr : m_pos + BLOCK_SIZE;
+    }
+
+    size_t ast_arena::capacity() const
+    {
+        return m_blocks.size() * BLOCK_SIZE;
+    }
+
+    bool operator==(const ast_term &a_lhs, const ast_term &a_rhs)
+    {
+        /////////////////////////////////////////
+        // pairs of terms still to compare. list spines are walked in
+        //     place, while heads wait on the stack.
+        /////////////////////////////////////////
+        std::vector<std::pair<const ast_term *, const ast_term *>> l_pending = {{&a_lhs, &a_rhs}};
+
+        while (!l_pending.empty())
+        {
+            auto [l_lhs, l_rhs] = l_pending.back();
+            l_pending.pop_back();
+
+            for (;;)
+            {
+                if (l_lhs->m_kind != l_rhs->m_kind)
+                    return false;
+
+                if (l_lhs->m_kind != ast_term::kind::cons)
+                {
+                    if (l_lhs->m_id != l_rhs->m_id)
+                        return false;
+
+                    break;
+                }
+
+                l_pending.push_back({&l_lhs->m_cons->m_head, &l_rhs->m_cons->m_head});
+
+                l_lhs = &l_lhs->m_cons->m_tail;
+                l_rhs = &l_rhs->m_cons->m_tail;
+            }
+        }
+
+        return true;
+    }
+
+    // identity of a term whose lists are pooled: equal ground lists are
+    //     then the same cells, so no deeper comparison is needed
+    static bool same_term(const ast_term &a_lhs, const ast_term &a_rhs)
+    {
+        return a_lhs.m_kind == a_rhs.m_kind && a_lhs.m_id == a_rhs.m_id && a_lhs.m_cons == a_rhs.m_cons;
+    }
+
+    static size_t hash_term(const ast_term &a_term)
+    {
+        size_t l_result = (size_t(a_term.m_kind) << 32) ^ a_term.m_id;
+        return l_result * 0x9e3779b97f4a7c15ull ^ std::hash<const void *>()(a_term.m_cons);
+    }
+
+    size_t pool_statistics::bytes_saved() const
+    {
+        return (m_ground_cells - m_pooled_cells) * sizeof(ast_cons);
+    }
+
+    size_t pool_statistics::prolog_bytes_saved() const
+    {
+        return (m_cells - m_distinct_cells) * 3 * sizeof(void *);
+    }
+
+    size_t ast_pool::cons_hash::operator()(const ast_cons &a_cons) const
+    {
+        return hash_term(a_cons.m_head) * 31 + hash_term(a_cons.m_tail);
+    }
+
+    bool ast_pool::cons_equal::operator()(const ast_cons &a_lhs, const pooled_cons *a_rhs) const
+    {
+        return same_term(a_lhs.m_head, a_rhs->m_cons.m_head) && same_term(a_lhs.m_tail, a_rhs->m_cons.m_tail);
+    }
+
+    const ast_pool::pooled_cons *ast_pool::intern(const ast_cons &a_cons)
+    {
+        ++m_statistics.m_ground_cells;
+
+        auto l_entry = m_cells.find(a_cons);
+
+        if (l_entry != m_cells.end())
+            return *l_entry;
+
+        /////////////////////////////////////////
+        // a new cell. its head and tail are pooled already, if they are lists.
+        /////////////////////////////////////////
+        auto cells = [](const ast_term &a_term)
+        {
+            if (a_term.m_kind != ast_term::kind::cons)
+                return uint32_t(0);
+
+            return reinterpret_cast<const pooled_cons *>(a_term.m_cons)->m_cells;
+        };
+
+        pooled_cons *l_result = m_arena.make<pooled_cons>(a_cons, 1 + cells(a_cons.m_head) + cells(a_cons.m_tail));
+
+        m_cells.insert(l_result);
+        ++m_statistics.m_pooled_cells;
+
+        return l_result;
+    }
+
+    void ast_pool::intern(ast_term &a_term)
+    {
+        struct frame
+        {
+            ast_term *m_slot;
+            bool m_expanded;
+        };
+
+        /////////////////////////////////////////
+        // cells are interned bottom up, so a cell is ground exactly when
+        //     both its head and its tail are. the groundness of finished
+        //     terms waits on a stack of its own.
+        /////////////////////////////////////////
+        std::vector<frame> l_frames = {{&a_term, false}};
+        std::vector<bool> l_ground;
+
+        while (!l_frames.empty())
+        {
+            frame &l_frame = l_frames.back();
+            ast_term *l_slot = l_frame.m_slot;
+
+            if (l_slot->m_kind != ast_term::kind::cons)
+            {
+                l_ground.push_back(l_slot->m_kind == ast_term::kind::nil || l_slot->m_kind == ast_term::kind::atom);
+                l_frames.pop_back();
+                continue;
+            }
+
+            if (!l_frame.m_expanded)
+            {
+                ++m_statistics.m_cells;
+
+                // the head is finished first, then the tail
+                l_frame.m_expanded = true;
+                l_frames.push_back({&l_slot->m_cons->m_tail, false});
+                l_frames.push_back({&l_slot->m_cons->m_head, false});
+                continue;
+            }
+
+            l_frames.pop_back();
+
+            bool l_tail_ground = l_ground.back();
+            l_ground.pop_back();
+            bool l_head_ground = l_ground.back();
+            l_ground.pop_back();
+
+            if (!(l_head_ground && l_tail_ground))
+            {
+                ++m_statistics.m_distinct_cells;
+                l_ground.push_back(false);
+                continue;
+            }
+
+            const pooled_cons *l_pooled = intern(*l_slot->m_cons);
+
+            *l_slot = ast_term::make_cons(const_cast<ast_cons *>(&l_pooled->m_cons));
+            ++m_occurrences[l_pooled];
+
+            l_ground.push_back(true);
+        }
+    }
+
+    void ast_pool::clear()
+    {
+        m_cells.clear();
+        m_occurrences.clear();
+
+        // the blocks are released, not kept for reuse
+        m_arena = ast_arena();
+    }
+
+    void ast_pool::intern(ast_statement &a_statement, ast_arena &a_arena)
+    {
+        m_occurrences.clear();
+
+        intern(a_statement.m_tag);
+        intern(a_statement.m_body);
+
+        // every pooled cell is built once, however often it occurs
+        m_statistics.m_distinct_cells += m_occurrences.size();
+
+        /////////////////////////////////////////
+        // keep the lists which occur more than once, ordered by address
+        /////////////////////////////////////////
+        size_t l_count = std::count_if(m_occurrences.begin(), m_occurrences.end(),
+                                       [](const auto &a_entry)
+                                       { return a_entry.second > 1; });
+
+        ast_shared_list *l_shared = a_arena.make_array<ast_shared_list>(l_count);
+        size_t i = 0;
+
+        for (const auto &[l_pooled, l_occurrences] : m_occurrences)
+            if (l_occurrences > 1)
+                l_shared[i++] = {&l_pooled->m_cons, l_pooled->m_cells};
+
+        std::sort(l_shared, l_shared + l_count,
+                  [](const ast_shared_list &a_lhs, const ast_shared_list &a_rhs)
+                  { return std::less<const ast_cons *>()(a_lhs.m_cons, a_rhs.m_cons); });
+
+        a_statement.m_shared = l_shared;
+        a_statement.m_shared_count = l_count;
+    }
+
+    bool parse_statement(lexer &a_lexer, ast_arena &a_arena, ast_statement &a_statement)
+    {
+        return extract_ast_statement(a_lexer, a_arena, a_statement);
+    }
+
+    bool parse_statement(std::istream &a_istream, ast_arena &a_arena, ast_statement &a_statement)
+    {
+        return extract_ast_statement(a_istream, a_arena, a_statement);
+    }
+
+    bool parse_term(std::istream &a_istream, ast_arena &a_arena, std::vector<symbol> &a_variables, ast_term &a_term)
+    {
+        variable_indexes l_variables;
+
+        for (uint32_t i = 0; i < a_variables.size(); ++i)
+            l_variables.try_emplace(a_variables[i], i);
+
+        if (extract_ast_term(a_istream, a_arena, l_variables, a_term).fail())
+            return false;
+
+        a_variables.resize(l_variables.size());
+
+        l_variables.for_each([&a_variables](symbol a_name, uint32_t a_index)
+                             { a_variables[a_index] = a_name; });
+
+        return true;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <sstream>
+#include <string>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+static unilog::ast_term parse_body(unilog::ast_arena &a_arena, const std::string &a_text)
+{
+    unilog::ast_statement l_statement;
+
+    unilog::lexer l_lexer(a_text);
+    assert(unilog::parse_statement(l_lexer, a_arena, l_statement));
+
+    return l_statement.m_body;
+}
+
+// a list of the given elements, built by hand
+static unilog::ast_term make_ast_list(unilog::ast_arena &a_arena, std::vector<unilog::ast_term> a_elements, unilog::ast_term a_tail = {})
+{
+    using unilog::ast_cons;
+    using unilog::ast_term;
+
+    ast_term l_result = a_tail;
+
+    for (auto l_it = a_elements.rbegin(); l_it != a_elements.rend(); l_it++)
+        l_result = ast_term::make_cons(a_arena.make<ast_cons>(*l_it, l_result));
+
+    return l_result;
+}
+
+////////////////////////////////
+////////////////////////////////
+
+static void test_ast_arena()
+{
+    unilog::ast_arena l_arena;
+
+    /////////////////////////////////////////
+    // allocations are aligned, and do not overlap
+    /////////////////////////////////////////
+    std::vector<uint64_t *> l_values;
+
+    for (uint64_t i = 0; i < 100000; i++)
+    {
+        l_arena.allocate(1, 1);
+
+        uint64_t *l_value = l_arena.make<uint64_t>(i);
+        assert(reinterpret_cast<uintptr_t>(l_value) % alignof(uint64_t) == 0);
+
+        l_values.push_back(l_value);
+    }
+
+    for (uint64_t i = 0; i < l_values.size(); i++)
+        assert(*l_values[i] == i);
+
+    size_t l_capacity = l_arena.capacity();
+    assert(l_capacity > 0);
+
+    /////////////////////////////////////////
+    // oversized allocations work, and do not take ordinary blocks
+    /////////////////////////////////////////
+    char *l_large = l_arena.make_array<char>(1024 * 1024);
+    l_large[1024 * 1024 - 1] = 'x';
+
+    assert(l_arena.capacity() == l_capacity);
+
+    /////////////////////////////////////////
+    // clearing keeps the blocks, for the next file
+    /////////////////////////////////////////
+    l_arena.clear();
+
+    for (uint64_t i = 0; i < 100000; i++)
+        l_arena.make<uint64_t>(i);
+
+    assert(l_arena.capacity() == l_capacity);
+}
+
+static void test_parse_ast_statement()
+{
+    using unilog::ast_statement;
+    using unilog::ast_term;
+
+    unilog::ast_arena l_arena;
+
+    std::string l_text =
+        "axiom a0 [if Y [f X] X _ _];\n"
+        "redir r0 [g | T];\n"
+        "infer i0 [mp [t a0] [t a1]];\n"
+        "refer m './m.u';\n";
+
+    unilog::lexer l_lexer(l_text);
+
+    ast_statement l_statement;
+
+    /////////////////////////////////////////
+    // variables are numbered by first occurrence, and singletons are fresh
+    /////////////////////////////////////////
+    assert(unilog::parse_statement(l_lexer, l_arena, l_statement));
+    assert(l_statement.m_kind == ast_statement::kind::axiom);
+    assert(l_statement.m_tag == ast_term::make_atom("a0"));
+    assert(l_statement.m_variable_count == 2);
+    assert(l_statement.m_variables[0] == "Y" && l_statement.m_variables[1] == "X");
+    assert(l_statement.m_span.m_begin == 0 && l_statement.m_span.m_end == 28);
+
+    ast_term l_expected = make_ast_list(l_arena, {
+                                                     ast_term::make_atom("if"),
+                                                     ast_term::make_variable(0),
+                                                     make_ast_list(l_arena, {ast_term::make_atom("f"), ast_term::make_variable(1)}),
+                                                     ast_term::make_variable(1),
+                                                     ast_term::make_fresh_variable(),
+                                                     ast_term::make_fresh_variable(),
+                                                 });
+
+    assert(l_statement.m_body == l_expected);
+
+    /////////////////////////////////////////
+    // improper lists keep their tail
+    /////////////////////////////////////////
+    assert(unilog::parse_statement(l_lexer, l_arena, l_statement));
+    assert(l_statement.m_kind == ast_statement::kind::redir);
+    assert(l_statement.m_body == make_ast_list(l_arena, {ast_term::make_atom("g")}, ast_term::make_variable(0)));
+
+    assert(unilog::parse_statement(l_lexer, l_arena, l_statement));
+    assert(l_statement.m_kind == ast_statement::kind::infer);
+    assert(l_statement.m_variable_count == 0);
+
+    assert(unilog::parse_statement(l_lexer, l_arena, l_statement));
+    assert(l_statement.m_kind == ast_statement::kind::refer);
+    assert(l_statement.m_body == ast_term::make_atom("./m.u"));
+
+    assert(!unilog::parse_statement(l_lexer, l_arena, l_statement));
+
+    /////////////////////////////////////////
+    // the stream adapter parses the same
+    /////////////////////////////////////////
+    std::stringstream l_ss(l_text);
+
+    assert(unilog::parse_statement(l_ss, l_arena, l_statement));
+    assert(l_statement.m_body == l_expected);
+}
+
+static void test_parse_ast_errors()
+{
+    data_points<std::string, std::string> l_data_points =
+        {
+            {"[a] b c;", ERR_MSG_MALFORMED_STMT},
+            {"fact a0 x;", ERR_MSG_INVALID_COMMAND},
+            {"axiom a0", ERR_MSG_MALFORMED_STMT},
+            {"axiom a0 x", ERR_MSG_NO_EOL},
+            {"axiom a0 x y;", ERR_MSG_NO_EOL},
+            {"axiom a0 [x;", ERR_MSG_MALFORMED_TERM},
+            {"axiom a0 [x", ERR_MSG_NO_LIST_CLOSE},
+            {"axiom a0 [x | y z];", ERR_MSG_NO_LIST_CLOSE},
+            {"axiom a0 ];", ERR_MSG_MALFORMED_TERM},
+            {"axiom a0 |;", ERR_MSG_MALFORMED_TERM},
+        };
+
+    unilog::ast_arena l_arena;
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        unilog::lexer l_lexer(l_key);
+        unilog::ast_statement l_statement;
+
+        try
+        {
+            unilog::parse_statement(l_lexer, l_arena, l_statement);
+            assert(false);
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            assert(l_err.what() == l_value);
+        }
+    }
+}
+
+static void test_ast_term_equal()
+{
+    using unilog::ast_term;
+
+    unilog::ast_arena l_arena;
+
+    data_points<std::pair<std::string, std::string>, bool> l_data_points =
+        {
+            {{"axiom a x;", "axiom a x;"}, true},
+            {{"axiom a x;", "axiom a y;"}, false},
+            {{"axiom a [];", "axiom a [];"}, true},
+            {{"axiom a [x y];", "axiom a [x y];"}, true},
+            {{"axiom a [x y];", "axiom a [x y z];"}, false},
+            {{"axiom a [x | y];", "axiom a [x y];"}, false},
+            {{"axiom a [X Y];", "axiom a [A B];"}, true},
+            {{"axiom a [X X];", "axiom a [A B];"}, false},
+            {{"axiom a [[a] [b [c]]];", "axiom a [[a] [b [c]]];"}, true},
+            {{"axiom a [[a] [b [c]]];", "axiom a [[a] [b [d]]];"}, false},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+        assert((parse_body(l_arena, l_key.first) == parse_body(l_arena, l_key.second)) == l_value);
+
+    /////////////////////////////////////////
+    // long lists compare without deep recursion
+    /////////////////////////////////////////
+    std::string l_long = "axiom a [";
+
+    for (size_t i = 0; i < 1000000; i++)
+        l_long += "x ";
+
+    l_long += "];";
+
+    assert(parse_body(l_arena, l_long) == parse_body(l_arena, l_long));
+}
+
+static void test_ast_deep_nesting()
+{
+    using unilog::ast_term;
+
+    constexpr size_t DEPTH = 1000000;
+
+    unilog::ast_arena l_arena;
+
+    /////////////////////////////////////////
+    // a chain nested far deeper than the call stack could recurse
+    /////////////////////////////////////////
+    std::string l_text = "infer i ";
+
+    for (size_t i = 0; i < DEPTH; i++)
+        l_text += "[mp ";
+
+    l_text += "x" + std::string(DEPTH, ']') + ";";
+
+    ast_term l_term = parse_body(l_arena, l_text);
+
+    /////////////////////////////////////////
+    // walk down the chain: each level is [mp <next>]
+    /////////////////////////////////////////
+    const ast_term *l_level = &l_term;
+
+    for (size_t i = 0; i < DEPTH; i++)
+    {
+        assert(l_level->m_kind == ast_term::kind::cons);
+        assert(l_level->m_cons->m_head == ast_term::make_atom("mp"));
+
+        const ast_term &l_rest = l_level->m_cons->m_tail;
+        assert(l_rest.m_kind == ast_term::kind::cons);
+        assert(l_rest.m_cons->m_tail == ast_term::make_nil());
+
+        l_level = &l_rest.m_cons->m_head;
+    }
+
+    assert(*l_level == ast_term::make_atom("x"));
+
+    /////////////////////////////////////////
+    // equal chains compare equal, and differ at the bottom
+    /////////////////////////////////////////
+    assert(parse_body(l_arena, l_text) == l_term);
+
+    l_text[l_text.find('x')] = 'y';
+    assert(!(parse_body(l_arena, l_text) == l_term));
+
+    /////////////////////////////////////////
+    // an unclosed chain is still an error
+    /////////////////////////////////////////
+    try
+    {
+        parse_body(l_arena, "infer i " + std::string(DEPTH, '[') + "x;");
+        throw std::runtime_error("Failed test case: expected throw");
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        assert(l_err.what() == std::string(ERR_MSG_MALFORMED_TERM));
+    }
+}
+
+static void test_ast_pool()
+{
+    using unilog::ast_term;
+
+    unilog::ast_arena l_arena;
+    unilog::ast_pool l_pool;
+
+    auto parse_interned = [&](const std::string &a_text)
+    {
+        unilog::ast_statement l_statement;
+
+        unilog::lexer l_lexer(a_text);
+        assert(unilog::parse_statement(l_lexer, l_arena, l_statement));
+
+        l_pool.intern(l_statement, l_arena);
+
+        return l_statement;
+    };
+
+    /////////////////////////////////////////
+    // equal ground lists become the same cells, across statements
+    /////////////////////////////////////////
+    unilog::ast_statement l_first = parse_interned("axiom a0 [if [and p q] [or p q]];");
+    unilog::ast_statement l_second = parse_interned("axiom a1 [if [and p q] r];");
+
+    assert(l_first.m_body == parse_body(l_arena, "axiom a0 [if [and p q] [or p q]];"));
+
+    const ast_term &l_first_and = l_first.m_body.m_cons->m_tail.m_cons->m_head;
+    const ast_term &l_second_and = l_second.m_body.m_cons->m_tail.m_cons->m_head;
+
+    assert(l_first_and.m_cons == l_second_and.m_cons);
+
+    // so do equal suffixes: [p q] ends both [and p q] and [or p q]
+    const ast_term &l_first_or = l_first.m_body.m_cons->m_tail.m_cons->m_tail.m_cons->m_head;
+    assert(l_first_and.m_cons->m_tail.m_cons == l_first_or.m_cons->m_tail.m_cons);
+
+    // which a0 thus repeats, as it does [q]. a1 repeats nothing.
+    assert(l_first.m_shared_count == 2);
+    assert(l_second.m_shared_count == 0);
+
+    /////////////////////////////////////////
+    // lists holding variables are left alone
+    /////////////////////////////////////////
+    unilog::ast_statement l_third = parse_interned("redir r0 [[and X q] [and X q]];");
+
+    assert(l_third.m_body.m_cons->m_head.m_cons != l_third.m_body.m_cons->m_tail.m_cons->m_head.m_cons);
+
+    // though their ground parts are shared: [q] twice
+    assert(l_third.m_shared_count == 1);
+    assert(l_third.m_shared[0].m_cells == 1);
+
+    /////////////////////////////////////////
+    // lists repeated within a statement are listed, with their sizes
+    /////////////////////////////////////////
+    unilog::ast_statement l_fourth = parse_interned("axiom a2 [[and p [not q]] [and p [not q]]];");
+
+    assert(l_fourth.m_body.m_cons->m_head.m_cons == l_fourth.m_body.m_cons->m_tail.m_cons->m_head.m_cons);
+
+    std::vector<uint32_t> l_sizes;
+
+    for (uint32_t i = 0; i < l_fourth.m_shared_count; ++i)
+        l_sizes.push_back(l_fourth.m_shared[i].m_cells);
+
+    std::sort(l_sizes.begin(), l_sizes.end());
+
+    // [and p [not q]], [p [not q]], [[not q]], [not q] and [q]
+    assert((l_sizes == std::vector<uint32_t>{1, 2, 3, 4, 5}));
+
+    /////////////////////////////////////////
+    // statistics: the repeats were neither pooled nor would be built
+    /////////////////////////////////////////
+    const unilog::pool_statistics &l_statistics = l_pool.statistics();
+
+    // cells of a0 (9), a1 (6), r0 (8, of which [q] twice is ground), a2 (12)
+    assert(l_statistics.m_cells == 9 + 6 + 8 + 12);
+    assert(l_statistics.m_ground_cells == 9 + 6 + 2 + 12);
+
+    // a0's [p q], r0's [q] and a2's repeated list are each built once
+    assert(l_statistics.m_distinct_cells == 7 + 6 + 7 + 7);
+    assert(l_statistics.prolog_bytes_saved() == 8 * 3 * sizeof(void *));
+
+    // a0's 7 distinct cells, a1's outer list, nothing new from r0, and
+    //     a2's lists but for [q]
+    assert(l_statistics.m_pooled_cells == 7 + 3 + 0 + 6);
+    assert(l_statistics.bytes_saved() == (l_statistics.m_ground_cells - l_statistics.m_pooled_cells) * sizeof(unilog::ast_cons));
+
+    /////////////////////////////////////////
+    // once cleared, lists are pooled anew, and the totals go on
+    /////////////////////////////////////////
+    l_pool.clear();
+
+    parse_interned("axiom a3 [if [and p q] r];");
+
+    assert(l_statistics.m_pooled_cells == 7 + 3 + 0 + 6 + 6);
+}
+
+void test_ast_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_ast_arena);
+    TEST(test_parse_ast_statement);
+    TEST(test_parse_ast_errors);
+    TEST(test_ast_term_equal);
+    TEST(test_ast_deep_nesting);
+    TEST(test_ast_pool);
+}
+
+#endif
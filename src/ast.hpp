@@ -0,0 +1,264 @@
+#ifndef AST_HPP
+#define AST_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "lexer.hpp"
+
+namespace unilog
+{
+
+    // bump allocator for parsed terms. everything allocated from an arena
+    //     is freed at once, when it is cleared or destroyed, so only
+    //     trivially destructible objects may be allocated from it.
+    class ast_arena
+    {
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+
+        // index of the block being allocated from, and the free range within it
+        size_t m_block = 0;
+        std::byte *m_pos = nullptr;
+        std::byte *m_end = nullptr;
+
+        // blocks larger than BLOCK_SIZE, for oversized allocations
+        std::vector<std::unique_ptr<std::byte[]>> m_large_blocks;
+
+        void *allocate_slow(size_t a_size, size_t a_alignment);
+
+    public:
+        ast_arena() = default;
+
+        ast_arena(const ast_arena &) = delete;
+        ast_arena &operator=(const ast_arena &) = delete;
+
+        ast_arena(ast_arena &&) = default;
+        ast_arena &operator=(ast_arena &&) = default;
+
+        void *allocate(size_t a_size, size_t a_alignment)
+        {
+            size_t l_padding = -reinterpret_cast<uintptr_t>(m_pos) & (a_alignment - 1);
+
+            if (a_size + l_padding > size_t(m_end - m_pos) || m_pos == nullptr)
+                return allocate_slow(a_size, a_alignment);
+
+            std::byte *l_result = m_pos + l_padding;
+            m_pos = l_result + a_size;
+
+            return l_result;
+        }
+
+        template <typename T, typename... Args>
+        T *make(Args &&...a_args)
+        {
+            static_assert(std::is_trivially_destructible_v<T>);
+            return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(a_args)...};
+        }
+
+        template <typename T>
+        T *make_array(size_t a_count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>);
+
+            T *l_result = static_cast<T *>(allocate(sizeof(T) * a_count, alignof(T)));
+            std::uninitialized_value_construct_n(l_result, a_count);
+
+            return l_result;
+        }
+
+        // frees everything allocated, but keeps the blocks for reuse
+        void clear();
+
+        // bytes of blocks held
+        size_t capacity() const;
+    };
+
+    struct ast_cons;
+
+    // a term parsed from source, independent of any prolog engine.
+    //     atoms are interned symbols, and variables are numbered within
+    //     their statement. lists are chains of cons cells, in an arena.
+    struct ast_term
+    {
+        enum class kind : uint8_t
+        {
+            nil,
+            atom,
+            variable,
+
+            // a singleton variable (_), distinct from every other
+            fresh_variable,
+
+            cons,
+        };
+
+        kind m_kind = kind::nil;
+
+        // the symbol id of an atom, or the index of a variable
+        uint32_t m_id = 0;
+
+        // the cell of a cons
+        ast_cons *m_cons = nullptr;
+
+        static ast_term make_nil() { return {}; }
+        static ast_term make_atom(symbol a_text) { return {kind::atom, a_text.id()}; }
+        static ast_term make_variable(uint32_t a_index) { return {kind::variable, a_index}; }
+        static ast_term make_fresh_variable() { return {kind::fresh_variable}; }
+        static ast_term make_cons(ast_cons *a_cons) { return {kind::cons, 0, a_cons}; }
+
+        symbol text() const { return symbol::from_id(m_id); }
+    };
+
+    struct ast_cons
+    {
+        ast_term m_head;
+        ast_term m_tail;
+    };
+
+    // a ground list which occurs more than once in a statement, once its
+    //     ground subterms are shared through an ast_pool
+    struct ast_shared_list
+    {
+        const ast_cons *m_cons;
+
+        // cons cells in the whole list, nested lists included
+        uint32_t m_cells;
+    };
+
+    // a parsed statement, whose terms live in the arena it was parsed into
+    struct ast_statement
+    {
+        enum class kind : uint8_t
+        {
+            axiom,
+            redir,
+            infer,
+            refer,
+        };
+
+        kind m_kind = kind::axiom;
+
+        ast_term m_tag;
+
+        // the theorem of an axiom, the guide of a redir or infer,
+        //     or the file path of a refer
+        ast_term m_body;
+
+        // names of the statement's variables, by index
+        const symbol *m_variables = nullptr;
+        uint32_t m_variable_count = 0;
+
+        // the ground lists occurring more than once, ordered by address.
+        //     only set by ast_pool::intern.
+        const ast_shared_list *m_shared = nullptr;
+        uint32_t m_shared_count = 0;
+
+        span m_span;
+    };
+
+    // totals of hash-consing through an ast_pool
+    struct pool_statistics
+    {
+        // cons cells of the statements interned, and how many of them
+        //     were ground
+        size_t m_cells = 0;
+        size_t m_ground_cells = 0;
+
+        // distinct ground cells, each held once by the pool
+        size_t m_pooled_cells = 0;
+
+        // cells the interned statements still have after sharing, which
+        //     is what building them as prolog terms costs
+        size_t m_distinct_cells = 0;
+
+        // bytes of cells the pool did not have to hold
+        size_t bytes_saved() const;
+
+        // bytes of prolog list cells (three words each) not built
+        size_t prolog_bytes_saved() const;
+    };
+
+    // hash-consing of ground lists. interning a statement replaces each of
+    //     its ground lists with the pool's single copy of it, so that equal
+    //     ground subterms share their cells, within the statement and across
+    //     every statement interned through the same pool, whichever file it
+    //     came from. pooled cells live until the pool is cleared or destroyed.
+    class ast_pool
+    {
+    private:
+        // a pooled cell, which knows the size of the list it heads
+        struct pooled_cons
+        {
+            ast_cons m_cons;
+            uint32_t m_cells;
+        };
+
+        struct cons_hash
+        {
+            using is_transparent = void;
+            size_t operator()(const ast_cons &a_cons) const;
+            size_t operator()(const pooled_cons *a_pooled) const { return (*this)(a_pooled->m_cons); }
+        };
+
+        struct cons_equal
+        {
+            using is_transparent = void;
+            bool operator()(const ast_cons &a_lhs, const pooled_cons *a_rhs) const;
+            bool operator()(const pooled_cons *a_lhs, const ast_cons &a_rhs) const { return (*this)(a_rhs, a_lhs); }
+            bool operator()(const pooled_cons *a_lhs, const pooled_cons *a_rhs) const { return a_lhs == a_rhs; }
+        };
+
+        ast_arena m_arena;
+        std::unordered_set<const pooled_cons *, cons_hash, cons_equal> m_cells;
+
+        // how often each pooled cell occurs in the statement being interned
+        std::unordered_map<const pooled_cons *, uint32_t> m_occurrences;
+
+        pool_statistics m_statistics;
+
+        const pooled_cons *intern(const ast_cons &a_cons);
+        void intern(ast_term &a_term);
+
+    public:
+        ast_pool() = default;
+
+        ast_pool(const ast_pool &) = delete;
+        ast_pool &operator=(const ast_pool &) = delete;
+
+        // shares the ground lists of a_statement, in place. its list of
+        //     shared lists is allocated from a_arena, the arena it was
+        //     parsed into.
+        void intern(ast_statement &a_statement, ast_arena &a_arena);
+
+        // frees every pooled cell, so that statements interned before must
+        //     no longer be used. the statistics are totals, and are kept.
+        void clear();
+
+        const pool_statistics &statistics() const { return m_statistics; }
+    };
+
+    // structural equality. variables are equal if they have the same index.
+    bool operator==(const ast_term &a_lhs, const ast_term &a_rhs);
+
+    // parse the next statement of the input into a_arena, throwing the same
+    //     errors the term_t parser does. returns false at the end of input.
+    bool parse_statement(lexer &a_lexer, ast_arena &a_arena, ast_statement &a_statement);
+    bool parse_statement(std::istream &a_istream, ast_arena &a_arena, ast_statement &a_statement);
+
+    // parse a single term of the input into a_arena. a_variables names the
+    //     variables numbered so far, by index, and is extended with any new
+    //     ones. returns false at the end of input.
+    bool parse_term(std::istream &a_istream, ast_arena &a_arena, std::vector<symbol> &a_variables, ast_term &a_term);
+
+}
+
+#endif
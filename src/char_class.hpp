@@ -0,0 +1,95 @@
+#ifndef CHAR_CLASS_HPP
+#define CHAR_CLASS_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace unilog
+{
+
+    // the lexical class of a single byte. the lexer dispatches on the
+    //     class of the first char of a lexeme, and the scanning loops
+    //     test classes, so neither depends on the locale.
+    enum class char_class : uint8_t
+    {
+        invalid,
+        whitespace,
+        comment,
+        eol,
+        list_separator,
+        list_open,
+        list_close,
+        quote,
+
+        // identifier chars. these must stay last, see is_identifier().
+        digit,
+        variable_start,
+        atom_start,
+    };
+
+    constexpr char_class classify_char(unsigned char a_char)
+    {
+        // the same acceptance rules as <cctype> in the C locale
+        if (a_char == ' ' || (a_char >= '\t' && a_char <= '\r'))
+            return char_class::whitespace;
+
+        if (a_char >= '0' && a_char <= '9')
+            return char_class::digit;
+
+        if ((a_char >= 'A' && a_char <= 'Z') || a_char == '_')
+            return char_class::variable_start;
+
+        if (a_char >= 'a' && a_char <= 'z')
+            return char_class::atom_start;
+
+        switch (a_char)
+        {
+        case '#':
+            return char_class::comment;
+        case ';':
+            return char_class::eol;
+        case '|':
+            return char_class::list_separator;
+        case '[':
+            return char_class::list_open;
+        case ']':
+            return char_class::list_close;
+        case '\'':
+        case '\"':
+            return char_class::quote;
+        default:
+            return char_class::invalid;
+        }
+    }
+
+    constexpr std::array<char_class, 256> make_char_classes()
+    {
+        std::array<char_class, 256> l_result{};
+
+        for (unsigned l_char = 0; l_char < 256; l_char++)
+            l_result[l_char] = classify_char(l_char);
+
+        return l_result;
+    }
+
+    inline constexpr std::array<char_class, 256> CHAR_CLASSES = make_char_classes();
+
+    constexpr char_class get_char_class(char a_char)
+    {
+        return CHAR_CLASSES[static_cast<unsigned char>(a_char)];
+    }
+
+    constexpr bool is_whitespace(char a_char)
+    {
+        return get_char_class(a_char) == char_class::whitespace;
+    }
+
+    // alphanumeric or underscore
+    constexpr bool is_identifier(char a_char)
+    {
+        return get_char_class(a_char) >= char_class::digit;
+    }
+
+}
+
+#endif
@@ -0,0 +1,703 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "compiled_module.hpp"
+
+// every section begins on a multiple of this
+static constexpr size_t SECTION_ALIGNMENT = 8;
+
+static size_t align_section(size_t a_offset)
+{
+    return (a_offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+static uint64_t mix_word(uint64_t a_hash, uint64_t a_word)
+{
+    // the splitmix64 finalizer
+    uint64_t l_result = (a_hash ^ a_word) + 0x9e3779b97f4a7c15ull;
+
+    l_result = (l_result ^ (l_result >> 30)) * 0xbf58476d1ce4e5b9ull;
+    l_result = (l_result ^ (l_result >> 27)) * 0x94d049bb133111ebull;
+
+    return l_result ^ (l_result >> 31);
+}
+
+// hashes a_text a word at a time, so stamping costs little next to parsing
+static uint64_t hash_source(std::string_view a_text)
+{
+    uint64_t l_result = a_text.size();
+
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= a_text.size(); i += sizeof(uint64_t))
+    {
+        uint64_t l_word;
+        std::memcpy(&l_word, a_text.data() + i, sizeof(l_word));
+        l_result = mix_word(l_result, l_word);
+    }
+
+    uint64_t l_last = 0;
+
+    if (i < a_text.size())
+        std::memcpy(&l_last, a_text.data() + i, a_text.size() - i);
+
+    return mix_word(l_result, l_last);
+}
+
+// the records of a section, as raw bytes
+template <typename T>
+static std::string_view section_bytes(const std::vector<T> &a_records)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    return std::string_view(reinterpret_cast<const char *>(a_records.data()), a_records.size() * sizeof(T));
+}
+
+namespace unilog
+{
+
+    source_stamp stamp_source(const std::filesystem::path &a_path, std::string_view a_text)
+    {
+        source_stamp l_result{
+            .m_size = a_text.size(),
+            .m_hash = hash_source(a_text),
+        };
+
+        struct stat l_stat;
+
+        if (::stat(a_path.c_str(), &l_stat) == 0)
+            l_result.m_mtime_ns = (int64_t)l_stat.st_mtim.tv_sec * 1000000000 + l_stat.st_mtim.tv_nsec;
+
+        return l_result;
+    }
+
+    std::filesystem::path compiled_module_path(const std::filesystem::path &a_directory, const std::filesystem::path &a_source_path)
+    {
+        char l_hash[17];
+        std::snprintf(l_hash, sizeof(l_hash), "%016llx", (unsigned long long)hash_source(a_source_path.native()));
+
+        return a_directory / (a_source_path.filename().string() + "." + l_hash + ".uc");
+    }
+
+    ////////////////////////////////
+    //// WRITING
+    ////////////////////////////////
+
+    uint32_t compiled_module_writer::add_symbol(symbol a_symbol)
+    {
+        auto [l_entry, l_inserted] = m_symbol_indexes.try_emplace(a_symbol.id(), m_symbols.size());
+
+        if (l_inserted)
+        {
+            std::string_view l_text = a_symbol.text();
+
+            m_symbols.push_back({(uint32_t)m_text.size(), (uint32_t)l_text.size()});
+            m_text += l_text;
+        }
+
+        return l_entry->second;
+    }
+
+    uint32_t compiled_module_writer::add_leaf(const ast_term &a_term)
+    {
+        compiled_node l_node{.m_kind = (uint32_t)a_term.m_kind, .m_value = 0, .m_head = 0, .m_tail = 0};
+
+        if (a_term.m_kind == ast_term::kind::atom)
+            l_node.m_value = add_symbol(a_term.text());
+        else if (a_term.m_kind == ast_term::kind::variable)
+            l_node.m_value = a_term.m_id;
+
+        m_nodes.push_back(l_node);
+
+        return m_nodes.size() - 1;
+    }
+
+    uint32_t compiled_module_writer::add_term(const ast_term &a_term)
+    {
+        if (a_term.m_kind != ast_term::kind::cons)
+            return add_leaf(a_term);
+
+        /////////////////////////////////////////
+        // write cells after their heads and tails, without recursing.
+        //     a cell stays open until both of its children are written.
+        /////////////////////////////////////////
+        m_open.push_back(a_term.m_cons);
+
+        while (!m_open.empty())
+        {
+            const ast_cons *l_cons = m_open.back();
+
+            if (m_cons_nodes.contains(l_cons))
+            {
+                m_open.pop_back();
+                continue;
+            }
+
+            bool l_ready = true;
+
+            for (const ast_term *l_child : {&l_cons->m_tail, &l_cons->m_head})
+            {
+                if (l_child->m_kind == ast_term::kind::cons && !m_cons_nodes.contains(l_child->m_cons))
+                {
+                    m_open.push_back(l_child->m_cons);
+                    l_ready = false;
+                }
+            }
+
+            if (!l_ready)
+                continue;
+
+            m_open.pop_back();
+
+            auto l_node_of = [this](const ast_term &a_child)
+            {
+                return a_child.m_kind == ast_term::kind::cons ? m_cons_nodes.at(a_child.m_cons) : add_leaf(a_child);
+            };
+
+            uint32_t l_head = l_node_of(l_cons->m_head);
+            uint32_t l_tail = l_node_of(l_cons->m_tail);
+
+            m_nodes.push_back({.m_kind = (uint32_t)ast_term::kind::cons, .m_value = 0, .m_head = l_head, .m_tail = l_tail});
+            m_cons_nodes.emplace(l_cons, m_nodes.size() - 1);
+        }
+
+        return m_cons_nodes.at(a_term.m_cons);
+    }
+
+    void compiled_module_writer::add(const ast_statement &a_statement)
+    {
+        compiled_statement l_statement{
+            .m_kind = (uint32_t)a_statement.m_kind,
+            .m_node_begin = (uint32_t)m_nodes.size(),
+            .m_variable_begin = (uint32_t)m_variables.size(),
+            .m_variable_count = a_statement.m_variable_count,
+            .m_span_begin = a_statement.m_span.m_begin,
+            .m_span_end = a_statement.m_span.m_end,
+        };
+
+        m_cons_nodes.clear();
+
+        l_statement.m_tag = add_term(a_statement.m_tag);
+        l_statement.m_body = add_term(a_statement.m_body);
+        l_statement.m_node_count = m_nodes.size() - l_statement.m_node_begin;
+
+        for (uint32_t i = 0; i < a_statement.m_variable_count; ++i)
+            m_variables.push_back(add_symbol(a_statement.m_variables[i]));
+
+        m_statements.push_back(l_statement);
+    }
+
+    bool compiled_module_writer::write(const std::filesystem::path &a_path, const source_stamp &a_source) const
+    {
+        constexpr size_t MAX_COUNT = std::numeric_limits<uint32_t>::max();
+
+        if (m_nodes.size() > MAX_COUNT || m_variables.size() > MAX_COUNT || m_text.size() > MAX_COUNT)
+            return false;
+
+        compiled_header l_header{
+            .m_version = compiled_header::VERSION,
+            .m_endian_mark = compiled_header::ENDIAN_MARK,
+            .m_source = a_source,
+            .m_symbol_count = (uint32_t)m_symbols.size(),
+            .m_statement_count = (uint32_t)m_statements.size(),
+            .m_node_count = (uint32_t)m_nodes.size(),
+            .m_variable_count = (uint32_t)m_variables.size(),
+            .m_text_size = m_text.size(),
+        };
+
+        std::memcpy(l_header.m_magic, compiled_header::MAGIC, sizeof(l_header.m_magic));
+
+        /////////////////////////////////////////
+        // write beside the destination, then rename over it, so a reader
+        //     never sees a partial module
+        /////////////////////////////////////////
+        std::filesystem::path l_temporary = a_path;
+        l_temporary += ".tmp" + std::to_string(::getpid());
+
+        {
+            std::ofstream l_ofs(l_temporary, std::ios::binary | std::ios::trunc);
+
+            size_t l_offset = 0;
+
+            auto l_write_section = [&l_ofs, &l_offset](std::string_view a_bytes)
+            {
+                static constexpr char s_padding[SECTION_ALIGNMENT] = {};
+
+                l_ofs.write(s_padding, align_section(l_offset) - l_offset);
+                l_ofs.write(a_bytes.data(), a_bytes.size());
+
+                l_offset = align_section(l_offset) + a_bytes.size();
+            };
+
+            l_write_section(std::string_view(reinterpret_cast<const char *>(&l_header), sizeof(l_header)));
+            l_write_section(section_bytes(m_symbols));
+            l_write_section(section_bytes(m_statements));
+            l_write_section(section_bytes(m_nodes));
+            l_write_section(section_bytes(m_variables));
+            l_write_section(m_text);
+
+            l_ofs.flush();
+
+            if (!l_ofs)
+            {
+                std::error_code l_ignored;
+                std::filesystem::remove(l_temporary, l_ignored);
+                return false;
+            }
+        }
+
+        std::error_code l_error;
+        std::filesystem::rename(l_temporary, a_path, l_error);
+
+        if (l_error)
+        {
+            std::filesystem::remove(l_temporary, l_error);
+            return false;
+        }
+
+        return true;
+    }
+
+    ////////////////////////////////
+    //// READING
+    ////////////////////////////////
+
+    bool compiled_module::load()
+    {
+        std::string_view l_bytes = m_file->text();
+
+        if (l_bytes.size() < sizeof(compiled_header) ||
+            reinterpret_cast<uintptr_t>(l_bytes.data()) % SECTION_ALIGNMENT != 0)
+            return false;
+
+        m_header = reinterpret_cast<const compiled_header *>(l_bytes.data());
+
+        if (std::memcmp(m_header->m_magic, compiled_header::MAGIC, sizeof(m_header->m_magic)) != 0 ||
+            m_header->m_version != compiled_header::VERSION ||
+            m_header->m_endian_mark != compiled_header::ENDIAN_MARK)
+            return false;
+
+        /////////////////////////////////////////
+        // locate the sections. counts are 32-bit, so none of this overflows.
+        /////////////////////////////////////////
+        size_t l_offset = sizeof(compiled_header);
+
+        auto l_section = [&l_offset](uint64_t a_size)
+        {
+            size_t l_begin = align_section(l_offset);
+            l_offset = l_begin + a_size;
+            return l_begin;
+        };
+
+        size_t l_symbols = l_section((uint64_t)m_header->m_symbol_count * sizeof(compiled_symbol));
+        size_t l_statements = l_section((uint64_t)m_header->m_statement_count * sizeof(compiled_statement));
+        size_t l_nodes = l_section((uint64_t)m_header->m_node_count * sizeof(compiled_node));
+        size_t l_variables = l_section((uint64_t)m_header->m_variable_count * sizeof(uint32_t));
+
+        if (m_header->m_text_size > l_bytes.size())
+            return false;
+
+        size_t l_text = l_section(m_header->m_text_size);
+
+        if (l_offset != l_bytes.size())
+            return false;
+
+        const compiled_symbol *l_symbol_records = reinterpret_cast<const compiled_symbol *>(l_bytes.data() + l_symbols);
+        m_statements = reinterpret_cast<const compiled_statement *>(l_bytes.data() + l_statements);
+        m_nodes = reinterpret_cast<const compiled_node *>(l_bytes.data() + l_nodes);
+        m_variables = reinterpret_cast<const uint32_t *>(l_bytes.data() + l_variables);
+
+        /////////////////////////////////////////
+        // intern the symbols
+        /////////////////////////////////////////
+        m_symbols.reserve(m_header->m_symbol_count);
+
+        for (uint32_t i = 0; i < m_header->m_symbol_count; ++i)
+        {
+            const compiled_symbol &l_symbol = l_symbol_records[i];
+
+            if ((uint64_t)l_symbol.m_offset + l_symbol.m_length > m_header->m_text_size)
+                return false;
+
+            m_symbols.emplace_back(l_bytes.substr(l_text + l_symbol.m_offset, l_symbol.m_length));
+        }
+
+        for (uint32_t i = 0; i < m_header->m_variable_count; ++i)
+            if (m_variables[i] >= m_header->m_symbol_count)
+                return false;
+
+        /////////////////////////////////////////
+        // check that every statement's nodes are in range, and refer only
+        //     to nodes of the same statement written before them
+        /////////////////////////////////////////
+        for (uint32_t i = 0; i < m_header->m_statement_count; ++i)
+        {
+            const compiled_statement &l_statement = m_statements[i];
+
+            uint64_t l_node_end = (uint64_t)l_statement.m_node_begin + l_statement.m_node_count;
+
+            if (l_statement.m_kind > (uint32_t)ast_statement::kind::refer ||
+                l_node_end > m_header->m_node_count ||
+                (uint64_t)l_statement.m_variable_begin + l_statement.m_variable_count > m_header->m_variable_count ||
+                l_statement.m_tag < l_statement.m_node_begin || l_statement.m_tag >= l_node_end ||
+                l_statement.m_body < l_statement.m_node_begin || l_statement.m_body >= l_node_end ||
+                l_statement.m_span_begin > l_statement.m_span_end)
+                return false;
+
+            for (uint32_t j = l_statement.m_node_begin; j < l_node_end; ++j)
+            {
+                const compiled_node &l_node = m_nodes[j];
+
+                switch ((ast_term::kind)l_node.m_kind)
+                {
+                case ast_term::kind::nil:
+                case ast_term::kind::fresh_variable:
+                    break;
+                case ast_term::kind::atom:
+                    if (l_node.m_value >= m_header->m_symbol_count)
+                        return false;
+                    break;
+                case ast_term::kind::variable:
+                    if (l_node.m_value >= l_statement.m_variable_count)
+                        return false;
+                    break;
+                case ast_term::kind::cons:
+                    if (l_node.m_head < l_statement.m_node_begin || l_node.m_head >= j ||
+                        l_node.m_tail < l_statement.m_node_begin || l_node.m_tail >= j)
+                        return false;
+                    break;
+                default:
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<compiled_module> compiled_module::open(const std::filesystem::path &a_path, const source_stamp &a_source)
+    {
+        std::error_code l_error;
+
+        if (!std::filesystem::is_regular_file(a_path, l_error))
+            return nullptr;
+
+        std::unique_ptr<compiled_module> l_result;
+
+        try
+        {
+            // not shared through load_source_file: a module is only read once
+            l_result.reset(new compiled_module(std::make_shared<const source_file>(a_path)));
+        }
+        catch (const std::runtime_error &)
+        {
+            return nullptr;
+        }
+
+        if (!l_result->load() || !(l_result->m_header->m_source == a_source))
+            return nullptr;
+
+        return l_result;
+    }
+
+    void compiled_module::statement(size_t a_index, ast_arena &a_arena, ast_statement &a_statement) const
+    {
+        const compiled_statement &l_statement = m_statements[a_index];
+
+        /////////////////////////////////////////
+        // rebuild the nodes in order. each cons finds its head and tail
+        //     already built.
+        /////////////////////////////////////////
+        static thread_local std::vector<ast_term> s_terms;
+
+        s_terms.resize(l_statement.m_node_count);
+
+        const compiled_node *l_nodes = m_nodes + l_statement.m_node_begin;
+
+        for (uint32_t i = 0; i < l_statement.m_node_count; ++i)
+        {
+            const compiled_node &l_node = l_nodes[i];
+
+            switch ((ast_term::kind)l_node.m_kind)
+            {
+            case ast_term::kind::nil:
+                s_terms[i] = ast_term::make_nil();
+                break;
+            case ast_term::kind::atom:
+                s_terms[i] = ast_term::make_atom(m_symbols[l_node.m_value]);
+                break;
+            case ast_term::kind::variable:
+                s_terms[i] = ast_term::make_variable(l_node.m_value);
+                break;
+            case ast_term::kind::fresh_variable:
+                s_terms[i] = ast_term::make_fresh_variable();
+                break;
+            case ast_term::kind::cons:
+                s_terms[i] = ast_term::make_cons(a_arena.make<ast_cons>(
+                    s_terms[l_node.m_head - l_statement.m_node_begin],
+                    s_terms[l_node.m_tail - l_statement.m_node_begin]));
+                break;
+            }
+        }
+
+        symbol *l_variables = a_arena.make_array<symbol>(l_statement.m_variable_count);
+
+        for (uint32_t i = 0; i < l_statement.m_variable_count; ++i)
+            l_variables[i] = m_symbols[m_variables[l_statement.m_variable_begin + i]];
+
+        a_statement = ast_statement{
+            .m_kind = (ast_statement::kind)l_statement.m_kind,
+            .m_tag = s_terms[l_statement.m_tag - l_statement.m_node_begin],
+            .m_body = s_terms[l_statement.m_body - l_statement.m_node_begin],
+            .m_variables = l_variables,
+            .m_variable_count = l_statement.m_variable_count,
+            .m_span = {l_statement.m_span_begin, l_statement.m_span_end},
+        };
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <sstream>
+#include <iterator>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+static std::filesystem::path temporary_module_path(const std::string &a_name)
+{
+    return std::filesystem::temp_directory_path() / ("unilog_compiled_module_" + a_name + ".uc");
+}
+
+////////////////////////////////
+//// TESTS
+////////////////////////////////
+
+static void test_compiled_module_path()
+{
+    std::filesystem::path l_main = unilog::compiled_module_path("cache", "/a/b/main.u");
+
+    // kept in the directory given, never beside the source
+    assert(l_main.parent_path() == std::filesystem::path("cache"));
+    assert(l_main.filename().string().starts_with("main.u."));
+    assert(l_main.extension() == ".uc");
+
+    // the same for the same source, and apart for another of the same name
+    assert(unilog::compiled_module_path("cache", "/a/b/main.u") == l_main);
+    assert(unilog::compiled_module_path("cache", "/a/c/main.u") != l_main);
+}
+
+static void test_compiled_module_round_trip()
+{
+    std::string l_text =
+        "axiom a0 [if [claims X Y] [and [p X] [q Y]]];\n"
+        "redir r0 [mp a0 [t x]];\n"
+        "infer i0 [conj [t a0] [r r0] [mp [t a0] _]];\n"
+        "refer lib 'lib/math.u';\n"
+        "axiom 'quoted tag' [a [b [c]] [b [c]] [b [c]] | T];\n"
+        "axiom empty [];\n";
+
+    /////////////////////////////////////////
+    // parse, sharing ground lists through a pool as the executor does
+    /////////////////////////////////////////
+    unilog::ast_pool l_pool;
+    std::vector<std::unique_ptr<unilog::ast_arena>> l_arenas;
+    std::vector<unilog::ast_statement> l_statements;
+
+    unilog::compiled_module_writer l_writer;
+
+    std::stringstream l_ss(l_text);
+
+    for (;;)
+    {
+        l_arenas.push_back(std::make_unique<unilog::ast_arena>());
+
+        unilog::ast_statement l_statement;
+
+        if (!unilog::parse_statement(l_ss, *l_arenas.back(), l_statement))
+            break;
+
+        l_pool.intern(l_statement, *l_arenas.back());
+        l_writer.add(l_statement);
+
+        l_statements.push_back(l_statement);
+    }
+
+    assert(l_statements.size() == 6);
+
+    unilog::source_stamp l_stamp{.m_size = l_text.size(), .m_mtime_ns = 42, .m_hash = 7};
+
+    std::filesystem::path l_path = temporary_module_path("round_trip");
+    assert(l_writer.write(l_path, l_stamp));
+
+    /////////////////////////////////////////
+    // the statements read back are those written
+    /////////////////////////////////////////
+    std::unique_ptr<unilog::compiled_module> l_module = unilog::compiled_module::open(l_path, l_stamp);
+
+    assert(l_module != nullptr);
+    assert(l_module->statement_count() == l_statements.size());
+
+    unilog::ast_arena l_arena;
+
+    for (size_t i = 0; i < l_statements.size(); ++i)
+    {
+        const unilog::ast_statement &l_expected = l_statements[i];
+        unilog::ast_statement l_read;
+
+        l_arena.clear();
+        l_module->statement(i, l_arena, l_read);
+
+        assert(l_read.m_kind == l_expected.m_kind);
+        assert(l_read.m_tag == l_expected.m_tag);
+        assert(l_read.m_body == l_expected.m_body);
+        assert(l_read.m_span.m_begin == l_expected.m_span.m_begin);
+        assert(l_read.m_span.m_end == l_expected.m_span.m_end);
+        assert(l_read.m_variable_count == l_expected.m_variable_count);
+
+        for (uint32_t j = 0; j < l_read.m_variable_count; ++j)
+            assert(l_read.m_variables[j] == l_expected.m_variables[j]);
+    }
+
+    /////////////////////////////////////////
+    // a module compiled from other source is not opened
+    /////////////////////////////////////////
+    for (unilog::source_stamp l_other : {
+             unilog::source_stamp{.m_size = l_text.size() + 1, .m_mtime_ns = 42, .m_hash = 7},
+             unilog::source_stamp{.m_size = l_text.size(), .m_mtime_ns = 43, .m_hash = 7},
+             unilog::source_stamp{.m_size = l_text.size(), .m_mtime_ns = 42, .m_hash = 8},
+         })
+        assert(unilog::compiled_module::open(l_path, l_other) == nullptr);
+
+    std::filesystem::remove(l_path);
+
+    assert(unilog::compiled_module::open(l_path, l_stamp) == nullptr);
+}
+
+static void test_compiled_module_damaged()
+{
+    std::stringstream l_ss("axiom a0 [x [y Z] Z];\naxiom a1 [x];\n");
+
+    unilog::ast_arena l_arena;
+    unilog::ast_statement l_statement;
+    unilog::compiled_module_writer l_writer;
+
+    while (unilog::parse_statement(l_ss, l_arena, l_statement))
+        l_writer.add(l_statement);
+
+    unilog::source_stamp l_stamp{.m_size = 1, .m_mtime_ns = 2, .m_hash = 3};
+
+    std::filesystem::path l_path = temporary_module_path("damaged");
+    assert(l_writer.write(l_path, l_stamp));
+
+    std::string l_bytes;
+
+    {
+        std::ifstream l_ifs(l_path, std::ios::binary);
+        l_bytes.assign(std::istreambuf_iterator<char>(l_ifs), std::istreambuf_iterator<char>());
+    }
+
+    assert(unilog::compiled_module::open(l_path, l_stamp) != nullptr);
+
+    auto l_rewrite = [&l_path](const std::string &a_bytes)
+    {
+        std::ofstream l_ofs(l_path, std::ios::binary | std::ios::trunc);
+        l_ofs << a_bytes;
+    };
+
+    /////////////////////////////////////////
+    // truncated, extended, or with a bad magic number
+    /////////////////////////////////////////
+    for (size_t l_size : {size_t(0), size_t(10), sizeof(unilog::compiled_header), l_bytes.size() - 1})
+    {
+        l_rewrite(l_bytes.substr(0, l_size));
+        assert(unilog::compiled_module::open(l_path, l_stamp) == nullptr);
+    }
+
+    l_rewrite(l_bytes + "x");
+    assert(unilog::compiled_module::open(l_path, l_stamp) == nullptr);
+
+    l_rewrite("X" + l_bytes.substr(1));
+    assert(unilog::compiled_module::open(l_path, l_stamp) == nullptr);
+
+    /////////////////////////////////////////
+    // a cons referring forward, to a node not yet built
+    /////////////////////////////////////////
+    std::string l_forward = l_bytes;
+
+    size_t l_nodes = 0;
+    {
+        unilog::compiled_header l_header;
+        std::memcpy(&l_header, l_bytes.data(), sizeof(l_header));
+
+        l_nodes = align_section(align_section(align_section(sizeof(l_header)) +
+                                              l_header.m_symbol_count * sizeof(unilog::compiled_symbol)) +
+                                l_header.m_statement_count * sizeof(unilog::compiled_statement));
+
+        for (uint32_t i = 0; i < l_header.m_node_count; ++i)
+        {
+            unilog::compiled_node l_node;
+            std::memcpy(&l_node, l_bytes.data() + l_nodes + i * sizeof(l_node), sizeof(l_node));
+
+            if (l_node.m_kind == (uint32_t)unilog::ast_term::kind::cons)
+            {
+                l_node.m_head = i;
+                std::memcpy(l_forward.data() + l_nodes + i * sizeof(l_node), &l_node, sizeof(l_node));
+                break;
+            }
+        }
+    }
+
+    l_rewrite(l_forward);
+    assert(unilog::compiled_module::open(l_path, l_stamp) == nullptr);
+
+    l_rewrite(l_bytes);
+    assert(unilog::compiled_module::open(l_path, l_stamp) != nullptr);
+
+    std::filesystem::remove(l_path);
+}
+
+static void test_stamp_source()
+{
+    std::filesystem::path l_path = std::filesystem::temp_directory_path() / "unilog_compiled_module_stamp.u";
+
+    {
+        std::ofstream l_ofs(l_path);
+        l_ofs << "axiom a0 x;\n";
+    }
+
+    unilog::source_stamp l_stamp = unilog::stamp_source(l_path, "axiom a0 x;\n");
+
+    assert(l_stamp.m_size == 12);
+    assert(l_stamp.m_mtime_ns != 0);
+
+    /////////////////////////////////////////
+    // any change to the text changes the hash
+    /////////////////////////////////////////
+    assert(unilog::stamp_source(l_path, "axiom a0 x;\n") == l_stamp);
+    assert(unilog::stamp_source(l_path, "axiom a0 y;\n").m_hash != l_stamp.m_hash);
+    assert(unilog::stamp_source(l_path, "axiom a0 x;\n ").m_hash != l_stamp.m_hash);
+    assert(unilog::stamp_source(l_path, "").m_hash != unilog::stamp_source(l_path, std::string_view("\0", 1)).m_hash);
+
+    std::filesystem::remove(l_path);
+}
+
+void test_compiled_module_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_compiled_module_path);
+    TEST(test_compiled_module_round_trip);
+    TEST(test_compiled_module_damaged);
+    TEST(test_stamp_source);
+}
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef COMPILED_MODULE_HPP
+#define COMPILED_MODULE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <unordered_map>
+#include "ast.hpp"
+#include "source_file.hpp"
+
+namespace unilog
+{
+
+    // identifies the source text a module was compiled from
+    struct source_stamp
+    {
+        uint64_t m_size = 0;
+        int64_t m_mtime_ns = 0;
+        uint64_t m_hash = 0;
+
+        bool operator==(const source_stamp &) const = default;
+    };
+
+    // stamps a_text, the contents of the file at a_path
+    source_stamp stamp_source(const std::filesystem::path &a_path, std::string_view a_text);
+
+    // where the compiled module of a source file is kept within a_directory:
+    //     named by the source's name and a hash of its whole path, so that
+    //     sources of one name in different directories do not collide
+    //     (/src/main.u compiles to main.<hash>.uc)
+    std::filesystem::path compiled_module_path(const std::filesystem::path &a_directory, const std::filesystem::path &a_source_path);
+
+    /////////////////////////////////////////
+    // the compiled module format. every section is an array of fixed-size
+    //     records, aligned to 8 bytes, in this order:
+    //
+    //     header
+    //     symbols      {offset, length} into the text section
+    //     statements   see compiled_statement
+    //     nodes        see compiled_node
+    //     variables    symbol indexes of each statement's variable names
+    //     text         the symbols' texts, back to back
+    //
+    //     the nodes of a statement are contiguous, and children precede
+    //     their parents, so a statement is rebuilt in a single pass.
+    //     integers are in the byte order of the machine which wrote them.
+    /////////////////////////////////////////
+
+    struct compiled_header
+    {
+        static constexpr char MAGIC[8] = "UNILOGC";
+        static constexpr uint32_t VERSION = 1;
+        static constexpr uint32_t ENDIAN_MARK = 0x01020304;
+
+        char m_magic[8];
+        uint32_t m_version;
+
+        // ENDIAN_MARK, which reads otherwise on a machine of the other byte order
+        uint32_t m_endian_mark;
+
+        source_stamp m_source;
+
+        uint32_t m_symbol_count;
+        uint32_t m_statement_count;
+        uint32_t m_node_count;
+        uint32_t m_variable_count;
+        uint64_t m_text_size;
+    };
+
+    struct compiled_symbol
+    {
+        uint32_t m_offset;
+        uint32_t m_length;
+    };
+
+    struct compiled_statement
+    {
+        uint32_t m_kind;
+        uint32_t m_tag;
+        uint32_t m_body;
+
+        // the statement's nodes
+        uint32_t m_node_begin;
+        uint32_t m_node_count;
+
+        // the statement's variable names
+        uint32_t m_variable_begin;
+        uint32_t m_variable_count;
+
+        uint32_t m_span_begin;
+        uint32_t m_span_end;
+    };
+
+    struct compiled_node
+    {
+        // an ast_term::kind
+        uint32_t m_kind;
+
+        // the symbol index of an atom, or the index of a variable
+        uint32_t m_value;
+
+        // the nodes of a cons
+        uint32_t m_head;
+        uint32_t m_tail;
+    };
+
+    // collects parsed statements, to write them out as a compiled module
+    class compiled_module_writer
+    {
+    private:
+        std::vector<compiled_symbol> m_symbols;
+        std::vector<compiled_statement> m_statements;
+        std::vector<compiled_node> m_nodes;
+        std::vector<uint32_t> m_variables;
+        std::string m_text;
+
+        // symbol ids of the process, to their indexes in the module
+        std::unordered_map<uint32_t, uint32_t> m_symbol_indexes;
+
+        // cells of the statement being added, to their nodes. cells shared
+        //     within a statement are written once.
+        std::unordered_map<const ast_cons *, uint32_t> m_cons_nodes;
+        std::vector<const ast_cons *> m_open;
+
+        uint32_t add_symbol(symbol a_symbol);
+        uint32_t add_leaf(const ast_term &a_term);
+        uint32_t add_term(const ast_term &a_term);
+
+    public:
+        void add(const ast_statement &a_statement);
+
+        // writes the module to a_path, through a temporary file renamed
+        //     into place. returns false if it could not be written.
+        bool write(const std::filesystem::path &a_path, const source_stamp &a_source) const;
+    };
+
+    // a compiled module, mapped read-only. statements are rebuilt from it
+    //     one at a time, without lexing or parsing.
+    class compiled_module
+    {
+    private:
+        std::shared_ptr<const source_file> m_file;
+
+        const compiled_header *m_header = nullptr;
+        const compiled_statement *m_statements = nullptr;
+        const compiled_node *m_nodes = nullptr;
+        const uint32_t *m_variables = nullptr;
+
+        // the module's symbols, interned in this process
+        std::vector<symbol> m_symbols;
+
+        explicit compiled_module(std::shared_ptr<const source_file> a_file) : m_file(std::move(a_file)) {}
+
+        // checks every section, index and kind, so that a damaged file is
+        //     never trusted
+        bool load();
+
+    public:
+        // opens the compiled module at a_path, or returns nullptr if it is
+        //     missing, malformed, or was not compiled from a_source
+        static std::unique_ptr<compiled_module> open(const std::filesystem::path &a_path, const source_stamp &a_source);
+
+        size_t statement_count() const { return m_header->m_statement_count; }
+
+        // rebuilds the a_index'th statement into a_arena
+        void statement(size_t a_index, ast_arena &a_arena, ast_statement &a_statement) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "document.hpp"
+#include "ast.hpp"
+
+// utf-16 code units taken by the utf-8 sequence led by a_byte,
+//     or zero if a_byte continues a sequence
+static size_t utf16_units(unsigned char a_byte)
+{
+    if ((a_byte & 0xC0) == 0x80)
+        return 0;
+
+    // four-byte sequences lie outside the basic plane, and take a surrogate pair
+    return a_byte >= 0xF0 ? 2 : 1;
+}
+
+// appends the atoms of a_term to a_atoms. returns whether it has a variable.
+static bool collect_atoms(const unilog::ast_term &a_term, std::vector<unilog::symbol> &a_atoms)
+{
+    bool l_has_variable = false;
+
+    // lists may nest deeply, so the walk keeps its own stack
+    std::vector<const unilog::ast_term *> l_stack{&a_term};
+
+    while (!l_stack.empty())
+    {
+        const unilog::ast_term *l_term = l_stack.back();
+        l_stack.pop_back();
+
+        switch (l_term->m_kind)
+        {
+        case unilog::ast_term::kind::atom:
+            a_atoms.push_back(l_term->text());
+            break;
+        case unilog::ast_term::kind::variable:
+        case unilog::ast_term::kind::fresh_variable:
+            l_has_variable = true;
+            break;
+        case unilog::ast_term::kind::cons:
+            l_stack.push_back(&l_term->m_cons->m_tail);
+            l_stack.push_back(&l_term->m_cons->m_head);
+            break;
+        case unilog::ast_term::kind::nil:
+            break;
+        }
+    }
+
+    return l_has_variable;
+}
+
+static unilog::document_statement lex_statement(size_t a_begin, std::string_view a_text)
+{
+    unilog::document_statement l_result;
+
+    l_result.m_begin = a_begin;
+    l_result.m_text = a_text;
+
+    const char *l_text_begin = l_result.m_text.data();
+    const char *l_text_end = l_text_begin + l_result.m_text.size();
+
+    l_result.m_content_begin = unilog::skip_whitespace_and_comments(l_text_begin, l_text_end) - l_text_begin;
+
+    /////////////////////////////////////////
+    // lex as far as possible. errors are reported
+    //     when the statement is executed.
+    /////////////////////////////////////////
+    unilog::lexer l_lexer(l_result.m_text);
+
+    try
+    {
+        for (unilog::lexeme l_lexeme; l_lexer >> l_lexeme;)
+            l_result.m_lexemes.push_back(l_lexeme);
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    /////////////////////////////////////////
+    // the tag and the other atoms come from the parsed terms,
+    //     since a tag may be a list, or have variables in it
+    /////////////////////////////////////////
+    unilog::lexer l_parse_lexer(l_result.m_text);
+    unilog::ast_arena l_arena;
+    unilog::ast_statement l_statement;
+
+    try
+    {
+        if (unilog::parse_statement(l_parse_lexer, l_arena, l_statement))
+        {
+            l_result.m_open_tag = collect_atoms(l_statement.m_tag, l_result.m_tag_atoms);
+
+            // the body of an axiom is a theorem, which queries nothing
+            bool l_open_body = collect_atoms(l_statement.m_body, l_result.m_mentioned);
+            l_result.m_open_mentions = l_open_body && l_statement.m_kind != unilog::ast_statement::kind::axiom;
+        }
+    }
+    catch (const std::runtime_error &)
+    {
+        l_result.m_tag_atoms.clear();
+        l_result.m_mentioned.clear();
+        l_result.m_open_tag = false;
+        l_result.m_open_mentions = false;
+    }
+
+    for (std::vector<unilog::symbol> *l_atoms : {&l_result.m_tag_atoms, &l_result.m_mentioned})
+    {
+        std::sort(l_atoms->begin(), l_atoms->end());
+        l_atoms->erase(std::unique(l_atoms->begin(), l_atoms->end()), l_atoms->end());
+    }
+
+    return l_result;
+}
+
+namespace unilog
+{
+
+    document::document(std::string a_text) : m_text(std::move(a_text))
+    {
+        size_t l_resync;
+        m_statements = index(0, m_text.size(), {}, l_resync);
+    }
+
+    std::vector<document_statement> document::index(size_t a_begin, size_t a_end, const std::vector<size_t> &a_old_ends, size_t &a_resync) const
+    {
+        std::vector<document_statement> l_result;
+
+        const char *l_text_begin = m_text.data();
+        const char *l_text_end = l_text_begin + m_text.size();
+
+        size_t l_old_end = 0;
+
+        for (size_t l_pos = a_begin; l_pos < m_text.size();)
+        {
+            size_t l_end = find_statement_end(l_text_begin + l_pos, l_text_end) - l_text_begin;
+
+            l_result.push_back(lex_statement(l_pos, std::string_view(l_text_begin + l_pos, l_end - l_pos)));
+
+            l_pos = l_end;
+
+            if (l_pos < a_end)
+                continue;
+
+            /////////////////////////////////////////
+            // past the edit, statements split the same as before
+            //     as soon as one ends where an old one did
+            /////////////////////////////////////////
+            while (l_old_end < a_old_ends.size() && a_old_ends[l_old_end] < l_pos)
+                ++l_old_end;
+
+            if (l_old_end < a_old_ends.size() && a_old_ends[l_old_end] == l_pos)
+            {
+                a_resync = l_old_end;
+                return l_result;
+            }
+        }
+
+        // every old statement was replaced
+        a_resync = a_old_ends.size();
+
+        return l_result;
+    }
+
+    document_edit document::edit(size_t a_begin, size_t a_end, std::string_view a_text)
+    {
+        a_end = std::min(a_end, m_text.size());
+        a_begin = std::min(a_begin, a_end);
+
+        /////////////////////////////////////////
+        // find the first statement the edit touches. text inserted
+        //     after an unterminated statement extends it.
+        /////////////////////////////////////////
+        size_t l_first = std::upper_bound(m_statements.begin(), m_statements.end(), a_begin,
+                                          [](size_t a_offset, const document_statement &a_statement)
+                                          { return a_offset < a_statement.m_begin + a_statement.m_text.size(); }) -
+                         m_statements.begin();
+
+        if (l_first == m_statements.size() && l_first > 0 && !m_statements.back().m_text.ends_with(';'))
+            --l_first;
+
+        size_t l_region_begin = l_first < m_statements.size() ? m_statements[l_first].m_begin : m_text.size();
+
+        /////////////////////////////////////////
+        // where the old statements end, once shifted by the edit
+        /////////////////////////////////////////
+        ptrdiff_t l_delta = (ptrdiff_t)a_text.size() - (ptrdiff_t)(a_end - a_begin);
+
+        std::vector<size_t> l_old_ends;
+
+        for (size_t i = l_first; i < m_statements.size(); i++)
+            l_old_ends.push_back(m_statements[i].m_begin + m_statements[i].m_text.size() + l_delta);
+
+        m_text.replace(a_begin, a_end - a_begin, a_text);
+        m_lines.reset();
+
+        /////////////////////////////////////////
+        // re-lex from the first touched statement, until boundaries line up again
+        /////////////////////////////////////////
+        size_t l_resync;
+        std::vector<document_statement> l_statements = index(l_region_begin, a_begin + a_text.size(), l_old_ends, l_resync);
+
+        size_t l_removed_end = l_resync < l_old_ends.size() ? l_first + l_resync + 1 : m_statements.size();
+
+        document_edit l_result;
+        l_result.m_first = l_first;
+        l_result.m_count = l_statements.size();
+        l_result.m_removed.assign(std::make_move_iterator(m_statements.begin() + l_first),
+                                  std::make_move_iterator(m_statements.begin() + l_removed_end));
+        l_result.m_kept.assign(l_result.m_removed.size(), false);
+
+        /////////////////////////////////////////
+        // statements which still lex the same keep their execution state
+        /////////////////////////////////////////
+        if (l_statements.size() == l_result.m_removed.size())
+        {
+            for (size_t i = 0; i < l_statements.size(); i++)
+            {
+                document_statement &l_new = l_statements[i];
+                const document_statement &l_old = l_result.m_removed[i];
+
+                if (l_new.m_lexemes != l_old.m_lexemes)
+                    continue;
+
+                l_result.m_kept[i] = true;
+
+                l_new.m_declared = l_old.m_declared;
+                l_new.m_executed = l_old.m_executed;
+                l_new.m_diagnostic = l_old.m_diagnostic;
+
+                // only whitespace or comments changed, so the precise range may have moved
+                l_new.m_diagnostic_begin = l_new.m_text == l_old.m_text ? l_old.m_diagnostic_begin : l_new.m_content_begin;
+                l_new.m_diagnostic_end = l_new.m_text == l_old.m_text ? l_old.m_diagnostic_end : l_new.m_text.size();
+            }
+        }
+
+        /////////////////////////////////////////
+        // splice in the new statements, and shift the ones after them
+        /////////////////////////////////////////
+        for (size_t i = l_removed_end; i < m_statements.size(); i++)
+            m_statements[i].m_begin += l_delta;
+
+        m_statements.erase(m_statements.begin() + l_first, m_statements.begin() + l_removed_end);
+        m_statements.insert(m_statements.begin() + l_first,
+                            std::make_move_iterator(l_statements.begin()),
+                            std::make_move_iterator(l_statements.end()));
+
+        return l_result;
+    }
+
+    const line_index &document::lines() const
+    {
+        if (!m_lines)
+            m_lines.emplace(m_text);
+
+        return *m_lines;
+    }
+
+    size_t document::offset(size_t a_line, size_t a_column) const
+    {
+        const line_index &l_lines = lines();
+
+        size_t l_pos = l_lines.line_begin(a_line);
+        size_t l_line_end = l_lines.line_end(a_line);
+
+        /////////////////////////////////////////
+        // count utf-16 code units along the line, never passing its end
+        /////////////////////////////////////////
+        for (size_t l_column = 0; l_pos != l_line_end; ++l_pos)
+        {
+            size_t l_units = utf16_units(m_text[l_pos]);
+
+            if (l_units != 0 && l_column >= a_column)
+                break;
+
+            l_column += l_units;
+        }
+
+        return l_pos;
+    }
+
+    std::pair<size_t, size_t> document::position(size_t a_offset) const
+    {
+        const line_index &l_lines = lines();
+
+        a_offset = std::min(a_offset, m_text.size());
+
+        size_t l_line = l_lines.line(a_offset);
+        size_t l_column = 0;
+
+        for (size_t l_pos = l_lines.line_begin(l_line); l_pos != a_offset; ++l_pos)
+            l_column += utf16_units(m_text[l_pos]);
+
+        return {l_line, l_column};
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+// the index a fresh document would build for the same text
+static void assert_index_fresh(const unilog::document &a_document)
+{
+    unilog::document l_fresh(a_document.text());
+
+    const auto &l_expected = l_fresh.statements();
+    const auto &l_actual = a_document.statements();
+
+    assert(l_actual.size() == l_expected.size());
+
+    for (size_t i = 0; i < l_actual.size(); i++)
+    {
+        assert(l_actual[i].m_begin == l_expected[i].m_begin);
+        assert(l_actual[i].m_text == l_expected[i].m_text);
+        assert(l_actual[i].m_lexemes == l_expected[i].m_lexemes);
+        assert(l_actual[i].m_content_begin == l_expected[i].m_content_begin);
+        assert(l_actual[i].m_tag_atoms == l_expected[i].m_tag_atoms);
+        assert(l_actual[i].m_mentioned == l_expected[i].m_mentioned);
+        assert(l_actual[i].m_open_tag == l_expected[i].m_open_tag);
+        assert(l_actual[i].m_open_mentions == l_expected[i].m_open_mentions);
+    }
+}
+
+static void test_document_index()
+{
+    unilog::document l_document("# header\naxiom a0 [if y x];\naxiom a1 x; infer i0 [mp [t a0] [t a1]];\n");
+
+    const auto &l_statements = l_document.statements();
+
+    // the trailing newline is a statement of its own, with no lexemes
+    assert(l_statements.size() == 4);
+    assert(l_statements[0].m_text == "# header\naxiom a0 [if y x];");
+    assert(l_statements[0].m_content_begin == 9);
+    assert(l_statements[0].m_lexemes.size() == 8);
+    assert(l_statements[1].m_begin == 27);
+    assert(l_statements[1].m_text == "\naxiom a1 x;");
+    assert(l_statements[2].m_text == " infer i0 [mp [t a0] [t a1]];");
+    assert(l_statements[3].m_text == "\n");
+    assert(l_statements[3].m_lexemes.empty());
+
+    // the declared tag is not among the atoms mentioned
+    const std::vector<unilog::symbol> &l_mentioned = l_statements[2].m_mentioned;
+
+    assert(l_mentioned.size() == 4);
+    assert(std::binary_search(l_mentioned.begin(), l_mentioned.end(), unilog::symbol("a0")));
+    assert(!std::binary_search(l_mentioned.begin(), l_mentioned.end(), unilog::symbol("i0")));
+    assert(l_statements[2].m_tag_atoms == std::vector<unilog::symbol>{unilog::symbol("i0")});
+
+    assert(unilog::document("").statements().empty());
+}
+
+static void test_document_tags()
+{
+    unilog::document l_document("axiom [a0 [b0]] [if a0 x];\naxiom [t X] x;\naxiom a1 [if y;\naxiom a2 [if X X];\ninfer i0 [t X];\n");
+
+    const auto &l_statements = l_document.statements();
+
+    // a list-valued tag declares all of its atoms
+    assert(l_statements[0].m_tag_atoms.size() == 2);
+    assert(std::binary_search(l_statements[0].m_tag_atoms.begin(), l_statements[0].m_tag_atoms.end(), unilog::symbol("b0")));
+    assert(l_statements[0].m_mentioned.size() == 3);
+    assert(std::binary_search(l_statements[0].m_mentioned.begin(), l_statements[0].m_mentioned.end(), unilog::symbol("a0")));
+    assert(!l_statements[0].m_open_tag);
+
+    // a tag with a variable may be anything
+    assert(l_statements[1].m_open_tag);
+    assert(l_statements[1].m_tag_atoms == std::vector<unilog::symbol>{unilog::symbol("t")});
+
+    // a statement which does not parse declares nothing
+    assert(l_statements[2].m_tag_atoms.empty());
+    assert(l_statements[2].m_mentioned.empty());
+    assert(!l_statements[2].m_open_tag);
+
+    // a variable in a guide may query any tag, but one in a theorem queries nothing
+    assert(!l_statements[3].m_open_mentions);
+    assert(l_statements[4].m_open_mentions);
+}
+
+static void test_document_edit()
+{
+    struct edit_case
+    {
+        size_t m_begin;
+        size_t m_end;
+        std::string m_text;
+
+        // expected index of the first replacement, and the number replaced and inserted
+        size_t m_first;
+        size_t m_removed;
+        size_t m_count;
+    };
+
+    const std::string l_text = "axiom a0 x;\naxiom a1 y;\naxiom a2 z;\n";
+
+    std::vector<edit_case> l_cases =
+        {
+            // change an atom of the second statement
+            {19, 20, "w", 1, 1, 1},
+            // insert a whole statement between the first and the second
+            {12, 12, "axiom b0 v;\n", 1, 1, 2},
+            // delete the second statement
+            {12, 24, "", 1, 2, 1},
+            // join the first two statements, by deleting the first ';'
+            {10, 11, "", 0, 2, 1},
+            // split the second statement
+            {18, 18, "w; axiom", 1, 1, 2},
+            // open a quote, which runs to the end of the line, taking the next statement with it
+            {15, 15, "'", 1, 2, 1},
+            // comment out the rest of the first line
+            {6, 6, "# ", 0, 2, 1},
+            // append at the end
+            {36, 36, "axiom a3 q;", 3, 1, 1},
+            // replace everything
+            {0, 36, "axiom b0 v;", 0, 4, 1},
+        };
+
+    for (const edit_case &l_case : l_cases)
+    {
+        unilog::document l_document(l_text);
+
+        unilog::document_edit l_edit = l_document.edit(l_case.m_begin, l_case.m_end, l_case.m_text);
+
+        std::string l_expected_text = l_text;
+        l_expected_text.replace(l_case.m_begin, l_case.m_end - l_case.m_begin, l_case.m_text);
+
+        assert(l_document.text() == l_expected_text);
+        assert(l_edit.m_first == l_case.m_first);
+        assert(l_edit.m_removed.size() == l_case.m_removed);
+        assert(l_edit.m_count == l_case.m_count);
+
+        // incremental re-indexing agrees with indexing from scratch
+        assert_index_fresh(l_document);
+    }
+}
+
+static void test_document_edit_keeps_state()
+{
+    unilog::document l_document("axiom a0 x;\naxiom a1 y;\naxiom a2 z;\n");
+
+    for (unilog::document_statement &l_statement : l_document.statements())
+    {
+        l_statement.m_executed = true;
+        l_statement.m_declared = true;
+    }
+
+    // whitespace inside a statement does not change its lexemes
+    unilog::document_edit l_edit = l_document.edit(18, 18, "   ");
+
+    assert(l_edit.m_count == 1);
+    assert(l_edit.m_kept == std::vector<bool>{true});
+    assert(l_document.statements()[1].m_executed);
+    assert(l_document.statements()[1].m_declared);
+
+    // a changed lexeme does
+    l_edit = l_document.edit(24, 25, "w");
+
+    assert(l_edit.m_kept == std::vector<bool>{false});
+    assert(l_document.statements()[1].m_text == "\naxiom    a1 w;");
+    assert(!l_document.statements()[1].m_executed);
+    assert(!l_document.statements()[1].m_declared);
+
+    // the others were never touched
+    assert(l_document.statements()[0].m_executed);
+    assert(l_document.statements()[2].m_executed);
+    assert(l_document.statements()[2].m_begin == 26);
+}
+
+static void test_document_random_edits()
+{
+    const std::string l_alphabet = "ax ;'\"#\n[]|Xy\\";
+
+    unilog::document l_document("axiom a0 x;\n");
+
+    uint32_t l_state = 42;
+
+    auto l_random = [&l_state](size_t a_bound)
+    {
+        l_state = l_state * 1664525u + 1013904223u;
+        return (l_state >> 8) % a_bound;
+    };
+
+    for (size_t i = 0; i < 2000; i++)
+    {
+        size_t l_size = l_document.text().size();
+        size_t l_begin = l_random(l_size + 1);
+        size_t l_end = std::min(l_size, l_begin + l_random(4));
+
+        std::string l_text;
+
+        for (size_t j = l_random(6); j > 0; j--)
+            l_text.push_back(l_alphabet[l_random(l_alphabet.size())]);
+
+        l_document.edit(l_begin, l_end, l_text);
+
+        assert_index_fresh(l_document);
+    }
+}
+
+static void test_document_positions()
+{
+    // "é" takes one utf-16 unit, and the emoji two
+    unilog::document l_document("ab\n\xC3\xA9x\xF0\x9F\x98\x80y\n\nz");
+
+    data_points<std::pair<size_t, size_t>, size_t> l_data_points =
+        {
+            {{0, 0}, 0},
+            {{0, 2}, 2},
+            {{0, 9}, 2}, // clamped to the end of the line
+            {{1, 0}, 3},
+            {{1, 1}, 5},
+            {{1, 2}, 6},
+            {{1, 4}, 10},
+            {{1, 5}, 11},
+            {{2, 0}, 12},
+            {{3, 1}, 14},
+            {{9, 0}, 14},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        assert(l_document.offset(l_key.first, l_key.second) == l_value);
+
+        // positions convert back, unless they were clamped
+        if (l_key != std::pair<size_t, size_t>{0, 9} && l_key != std::pair<size_t, size_t>{9, 0})
+            assert(l_document.position(l_value) == l_key);
+    }
+}
+
+void test_document_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_document_index);
+    TEST(test_document_tags);
+    TEST(test_document_edit);
+    TEST(test_document_edit_keeps_state);
+    TEST(test_document_random_edits);
+    TEST(test_document_positions);
+}
+
+#endif
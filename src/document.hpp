@@ -0,0 +1,114 @@
+#ifndef DOCUMENT_HPP
+#define DOCUMENT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include "lexer.hpp"
+#include "line_index.hpp"
+
+namespace unilog
+{
+
+    // one statement of a document, from just after the previous statement's
+    //     ';' through its own. the statements of a document cover all of its
+    //     text, so leading whitespace and comments belong to the statement
+    //     which follows them.
+    struct document_statement
+    {
+        // offset of m_text within the document
+        size_t m_begin = 0;
+
+        std::string m_text;
+
+        // the lexemes of m_text, up to the first lexing error if any
+        std::vector<lexeme> m_lexemes;
+
+        // offset within m_text of the first lexeme
+        size_t m_content_begin = 0;
+
+        // atoms of the tag the statement declares, and atoms of the rest
+        //     of it, each sorted and without duplicates. both are empty if
+        //     the statement does not parse.
+        std::vector<symbol> m_tag_atoms;
+        std::vector<symbol> m_mentioned;
+
+        // set when the tag has a variable in it, so that the statement
+        //     may declare any tag at all
+        bool m_open_tag = false;
+
+        // set when the guide of an infer or redir has a variable in it,
+        //     so that it may query any tag at all
+        bool m_open_mentions = false;
+
+        // the diagnostic of the last attempt to execute the statement,
+        //     and its range within m_text. empty if it succeeded.
+        std::string m_diagnostic;
+        size_t m_diagnostic_begin = 0;
+        size_t m_diagnostic_end = 0;
+
+        // set when executing the statement left declarations behind,
+        //     which must be retracted before it is executed again
+        bool m_declared = false;
+
+        // false until the statement has been executed in its current form
+        bool m_executed = false;
+    };
+
+    // the statements that an edit replaced
+    struct document_edit
+    {
+        // index of the first replacement statement, and how many there are
+        size_t m_first = 0;
+        size_t m_count = 0;
+
+        // the statements they replaced, in order
+        std::vector<document_statement> m_removed;
+
+        // for each removed statement, whether its replacement lexed the same,
+        //     and so took over its execution state, declarations included
+        std::vector<bool> m_kept;
+    };
+
+    // the text of a source file being edited, indexed by statement. an edit
+    //     re-lexes only the statements it touches: statements before it keep
+    //     their lexemes, and statements after it are only shifted.
+    class document
+    {
+    private:
+        std::string m_text;
+        std::vector<document_statement> m_statements;
+
+        // built on the first position lookup after an edit
+        mutable std::optional<line_index> m_lines;
+
+        const line_index &lines() const;
+
+        // splits [a_begin, a_end) of m_text into statements, ending at the first
+        //     statement boundary at or after a_end which lies on a_old_ends
+        //     (old statement ends, shifted into the new text). returns the
+        //     statements, and sets a_resync to the index of the boundary hit.
+        std::vector<document_statement> index(size_t a_begin, size_t a_end, const std::vector<size_t> &a_old_ends, size_t &a_resync) const;
+
+    public:
+        document() = default;
+        explicit document(std::string a_text);
+
+        const std::string &text() const { return m_text; }
+
+        const std::vector<document_statement> &statements() const { return m_statements; }
+        std::vector<document_statement> &statements() { return m_statements; }
+
+        // replaces the bytes [a_begin, a_end) with a_text
+        document_edit edit(size_t a_begin, size_t a_end, std::string_view a_text);
+
+        // converts between byte offsets and (line, column) positions, where
+        //     columns count utf-16 code units, as the language server protocol does
+        size_t offset(size_t a_line, size_t a_column) const;
+        std::pair<size_t, size_t> position(size_t a_offset) const;
+    };
+
+}
+
+#endif
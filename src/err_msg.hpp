@@ -7,10 +7,13 @@
 #define ERR_MSG_GET_ATOM_CHARS "Error: failed to get atom chars"
 #define ERR_MSG_PUT_ATOM_CHARS "Error: failed to put atom chars"
 #define ERR_MSG_PUT_NIL "Error: failed to put nil"
+#define ERR_MSG_HASH_TERM "Error: term cannot be hashed"
+#define ERR_MSG_SERIALIZE_TERM "Error: term cannot be serialized"
 
 // lexer errors
 #define ERR_MSG_CLOSING_QUOTE "Error: no closing quote"
 #define ERR_MSG_INVALID_LEXEME "Error: invalid lexeme"
+#define ERR_MSG_INPUT_TOO_LARGE "Error: input of 4 GiB or more"
 
 // parser errors
 #define ERR_MSG_NO_LIST_CLOSE "Error: no list close"
@@ -22,8 +25,16 @@
 // executor errors
 #define ERR_MSG_NOT_A_FILE "Error: not a file"
 #define ERR_MSG_FILE_OPEN "Error: file failed to open"
+#define ERR_MSG_FILE_READ "Error: file failed to read"
 #define ERR_MSG_DECL_THEOREM "Error: failed to declare theorem"
 #define ERR_MSG_DECL_REDIR "Error: failed to declare redirect"
 #define ERR_MSG_INFER "Error: inference failed"
+#define ERR_MSG_RETRACT "Error: failed to retract declarations"
+#define ERR_MSG_EXPORT_FILES "Error: --export takes a single input file"
+
+// language server errors
+#define ERR_MSG_JSON_MALFORMED "Error: malformed json"
+#define ERR_MSG_JSON_TYPE "Error: unexpected json type"
+#define ERR_MSG_LSP_HEADER "Error: malformed message header"
 
 #endif
@@ -1,97 +1,332 @@
 #include <filesystem>
-#include <fstream>
 #include <iterator>
 #include <functional>
+#include <algorithm>
 #include <deque>
+#include <list>
+#include <optional>
+#include <type_traits>
+#include <mutex>
+#include <unordered_map>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
 
 #include "executor.hpp"
+#include "source_file.hpp"
+#include "line_index.hpp"
+#include "parallel_parser.hpp"
+#include "compiled_module.hpp"
+#include "scan.hpp"
 #include "err_msg.hpp"
 
-// custom row+col tracking streambuf for printing
-//     call stack of files on exception throw
-class charpos_streambuf : public std::streambuf
+// a predicate of unilog.pl, looked up by name once. calls are checked
+//     against its arity when compiled, and their arguments are put straight
+//     into the block of term refs handed to prolog, without unifying.
+template <size_t Arity>
+class prolog_predicate
 {
 private:
-    std::streambuf *m_underlying; // The original streambuf
-    int m_row = 1;                // Start row from 1
-    int m_col = 1;                // Start column from 0
+    predicate_t m_predicate;
+
+public:
+    explicit prolog_predicate(const char *a_name) : m_predicate(PL_predicate(a_name, Arity, NULL)) {}
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Arity && (std::is_same_v<Args, term_t> && ...))
+    bool operator()(Args... a_args) const
+    {
+        // prolog must always be given at least 1 ref
+        term_t l_args = PL_new_term_refs(std::max<size_t>(1, Arity));
+        term_t l_arg = l_args;
+
+        // an unbound argument is shared, not copied, so the caller sees its bindings
+        (PL_put_term(l_arg++, a_args), ...);
+
+        bool l_result = PL_call_predicate(NULL, PL_Q_NORMAL, m_predicate, l_args);
+
+        PL_reset_term_refs(l_args);
+
+        return l_result;
+    }
+};
+
+// the predicates the executor calls, looked up on first use, by which
+//     time prolog has been initialised
+struct unilog_predicates
+{
+    prolog_predicate<3> m_decl_theorem{"decl_theorem"};
+    prolog_predicate<3> m_decl_redir{"decl_redir"};
+    prolog_predicate<3> m_query{"query"};
+    prolog_predicate<2> m_retract_theorem{"retract_theorem"};
+    prolog_predicate<2> m_retract_redir{"retract_redir"};
+    prolog_predicate<1> m_retract_module{"retract_module"};
+    prolog_predicate<1> m_module_declared{"module_declared"};
+    prolog_predicate<0> m_wipe_database{"wipe_database"};
+};
+
+static const unilog_predicates &predicates()
+{
+    static const unilog_predicates s_predicates;
+    return s_predicates;
+}
+
+namespace unilog
+{
+    // ground lists shared by the statements of every referred file
+    static ast_pool &refer_pool()
+    {
+        static ast_pool s_pool;
+        return s_pool;
+    }
+
+    // canonical paths resolved, by base directory and referred path
+    struct refer_path_cache
+    {
+        std::mutex m_mutex;
+        std::unordered_map<std::string, std::filesystem::path> m_paths;
+    };
+
+    static refer_path_cache &refer_paths()
+    {
+        static refer_path_cache s_cache;
+        return s_cache;
+    }
 
-protected:
-    // Override underflow to handle character reading
-    int_type underflow() override
+    const pool_statistics &refer_pool_statistics()
     {
-        return m_underlying->sgetc();
+        return refer_pool().statistics();
     }
 
-    // Override uflow to handle consuming a character
-    int_type uflow() override
+    // the statements of a referred file, parsed and interned once
+    struct parsed_module
+    {
+        std::vector<std::unique_ptr<parsed_chunk>> m_chunks;
+    };
+
+    /////////////////////////////////////////
+    // parsed modules, by the canonical path of their file. an entry is
+    //     used while its file has the content it was parsed from, so a
+    //     module referred from many places is parsed at most twice. it is
+    //     only kept from its second refer on, so a file referred once is
+    //     parsed as a stream, in bounded memory. kept modules are counted
+    //     by the size of their source, and the least recently used are
+    //     dropped to stay within the limit.
+    /////////////////////////////////////////
+    class module_cache
     {
-        int_type l_char = m_underlying->sbumpc(); // Consume the current character
+    private:
+        struct entry
+        {
+            // the source last seen with the content hashed. while the file
+            //     is loaded as this same source, it has not changed. only
+            //     its identity and size are used, never its text, so a
+            //     mapping truncated since cannot fault here.
+            std::shared_ptr<const source_file> m_source;
+            uint64_t m_hash = 0;
+
+            std::shared_ptr<const parsed_module> m_module;
+
+            // the entry's place in m_recent
+            std::list<std::string>::iterator m_recent;
+        };
+
+        std::mutex m_mutex;
+        std::unordered_map<std::string, entry> m_entries;
+
+        // paths of the entries, most recently used first
+        std::list<std::string> m_recent;
+
+        // the source bytes of the entries, and the most they may have
+        size_t m_bytes = 0;
+        size_t m_limit = DEFAULT_REFER_CACHE_LIMIT;
+
+        // content hashes of files referred once, and not kept yet
+        std::unordered_map<std::string, uint64_t> m_seen;
+
+        module_cache_statistics m_statistics;
+
+        void erase(std::unordered_map<std::string, entry>::iterator a_entry)
+        {
+            m_bytes -= a_entry->second.m_source->text().size();
+            m_recent.erase(a_entry->second.m_recent);
+            m_entries.erase(a_entry);
+        }
+
+    public:
+        // the module of a_path, if it was parsed from the content of a_source
+        std::shared_ptr<const parsed_module> find(const std::filesystem::path &a_path, const std::shared_ptr<const source_file> &a_source)
+        {
+            std::unique_lock l_lock(m_mutex);
+
+            auto l_entry = m_entries.find(a_path.native());
+
+            /////////////////////////////////////////
+            // a file loaded anew (changed on disk, or only touched) is
+            //     hashed, outside the lock, to tell which
+            /////////////////////////////////////////
+            if (l_entry != m_entries.end() && l_entry->second.m_source != a_source)
+            {
+                uint64_t l_hash = l_entry->second.m_hash;
+
+                l_lock.unlock();
+                bool l_unchanged = stamp_source(a_path, a_source->text()).m_hash == l_hash;
+                l_lock.lock();
+
+                l_entry = m_entries.find(a_path.native());
+
+                if (l_entry == m_entries.end() || l_entry->second.m_hash != l_hash)
+                    l_entry = m_entries.end();
+                else if (!l_unchanged)
+                {
+                    erase(l_entry);
+                    l_entry = m_entries.end();
+                }
+                else
+                {
+                    m_bytes += a_source->text().size() - l_entry->second.m_source->text().size();
+                    l_entry->second.m_source = a_source;
+                }
+            }
+
+            if (l_entry == m_entries.end())
+            {
+                ++m_statistics.m_misses;
+                return nullptr;
+            }
+
+            m_recent.splice(m_recent.begin(), m_recent, l_entry->second.m_recent);
+
+            ++m_statistics.m_hits;
+            m_statistics.m_bytes_saved += a_source->text().size();
 
-        if (l_char == traits_type::eof())
-            return traits_type::eof(); // Pass EOF back
+            return l_entry->second.m_module;
+        }
+
+        // whether the module of a_path, which find did not have, should be
+        //     kept once parsed: when its content was referred before, and
+        //     fits within the limit
+        bool admit(const std::filesystem::path &a_path, uint64_t a_hash, size_t a_bytes)
+        {
+            std::lock_guard l_lock(m_mutex);
+
+            if (a_bytes > m_limit)
+                return false;
+
+            auto [l_seen, l_inserted] = m_seen.try_emplace(a_path.native(), a_hash);
+
+            if (l_inserted || l_seen->second != a_hash)
+            {
+                l_seen->second = a_hash;
+                return false;
+            }
+
+            return true;
+        }
+
+        void insert(const std::filesystem::path &a_path, std::shared_ptr<const source_file> a_source, uint64_t a_hash, std::shared_ptr<const parsed_module> a_module)
+        {
+            std::lock_guard l_lock(m_mutex);
+
+            if (auto l_entry = m_entries.find(a_path.native()); l_entry != m_entries.end())
+                erase(l_entry);
+
+            m_seen.erase(a_path.native());
+
+            size_t l_bytes = a_source->text().size();
+
+            if (l_bytes > m_limit)
+                return;
 
-        // increment column
-        ++m_col;
+            while (m_bytes + l_bytes > m_limit)
+                erase(m_entries.find(m_recent.back()));
 
-        // check for incrementing row
-        if (l_char == '\n')
+            m_recent.push_front(a_path.native());
+            m_bytes += l_bytes;
+
+            m_entries[a_path.native()] = {std::move(a_source), a_hash, std::move(a_module), m_recent.begin()};
+        }
+
+        void set_limit(size_t a_bytes)
+        {
+            std::lock_guard l_lock(m_mutex);
+
+            m_limit = a_bytes;
+
+            while (m_bytes > m_limit)
+                erase(m_entries.find(m_recent.back()));
+        }
+
+        void clear()
         {
-            ++m_row;
-            m_col = 1;
+            std::lock_guard l_lock(m_mutex);
+
+            m_entries.clear();
+            m_recent.clear();
+            m_seen.clear();
+            m_bytes = 0;
+        }
+
+        module_cache_statistics statistics()
+        {
+            std::lock_guard l_lock(m_mutex);
+
+            module_cache_statistics l_result = m_statistics;
+            l_result.m_bytes_kept = m_bytes;
+
+            return l_result;
         }
+    };
 
-        return l_char;
+    static module_cache &refer_module_cache()
+    {
+        static module_cache s_cache;
+        return s_cache;
     }
 
-    // Explicitly disallow seeking
-    std::streampos seekoff(std::streamoff, std::ios_base::seekdir, std::ios_base::openmode) override
+    module_cache_statistics refer_cache_statistics()
     {
-        return std::streampos(-1); // Indicate failure
+        return refer_module_cache().statistics();
     }
 
-    std::streampos seekpos(std::streampos, std::ios_base::openmode) override
+    void clear_refer_cache()
     {
-        return std::streampos(-1); // Indicate failure
+        refer_module_cache().clear();
     }
 
-public:
-    charpos_streambuf(std::streambuf *buf) : m_underlying(buf) {}
+    void set_refer_cache_limit(size_t a_bytes)
+    {
+        refer_module_cache().set_limit(a_bytes);
+    }
 
-    // Getters for row and column
-    int row() const { return m_row; }
-    int col() const { return m_col; }
-};
+    void clear_refer_state()
+    {
+        // the kept modules point into the pool, so they go first
+        refer_module_cache().clear();
+        refer_pool().clear();
 
-static int call_predicate(const std::string &a_functor, const std::vector<term_t> &a_args)
-{
-    /////////////////////////////////////////
-    // define predicate we wish to call
-    /////////////////////////////////////////
-    predicate_t l_predicate = PL_predicate(a_functor.c_str(), a_args.size(), NULL);
+        std::lock_guard l_lock(refer_paths().m_mutex);
+        refer_paths().m_paths.clear();
+    }
 
-    /////////////////////////////////////////
-    // construct contiguous term refs for args (must always declare at least 1)
-    /////////////////////////////////////////
-    term_t l_contiguous_args = PL_new_term_refs(std::max(1, (int)a_args.size()));
+    // threads parsing each referred file
+    static size_t s_parse_threads = 1;
 
-    /////////////////////////////////////////
-    // unify supplied args with contiguous refs
-    /////////////////////////////////////////
-    for (int i = 0; i < (int)a_args.size(); ++i)
+    void set_parse_threads(size_t a_threads)
     {
-        if (!PL_unify(l_contiguous_args + i, a_args[i]))
-            throw std::runtime_error(ERR_MSG_UNIFY);
+        s_parse_threads = a_threads;
     }
 
-    /////////////////////////////////////////
-    // call the predicate finally, and return the result.
-    /////////////////////////////////////////
-    return PL_call_predicate(NULL, PL_Q_NORMAL, l_predicate, l_contiguous_args);
-}
+    // where compiled modules are kept, if anywhere
+    static std::filesystem::path s_module_cache_directory;
+
+    void set_module_cache_directory(const std::filesystem::path &a_directory)
+    {
+        s_module_cache_directory = a_directory;
+    }
 
-namespace unilog
-{
     void execute(const axiom_statement &a_axiom_statement, term_t a_module_path)
     {
         fid_t l_frame = PL_open_foreign_frame();
@@ -99,7 +334,7 @@ namespace unilog
         /////////////////////////////////////////
         // execute decl_theorem
         /////////////////////////////////////////
-        if (!call_predicate("decl_theorem", {a_module_path, a_axiom_statement.m_tag, a_axiom_statement.m_theorem}))
+        if (!predicates().m_decl_theorem(a_module_path, a_axiom_statement.m_tag, a_axiom_statement.m_theorem))
             throw std::runtime_error(ERR_MSG_DECL_THEOREM);
 
         PL_discard_foreign_frame(l_frame);
@@ -112,7 +347,7 @@ namespace unilog
         /////////////////////////////////////////
         // execute decl_redir
         /////////////////////////////////////////
-        if (!call_predicate("decl_redir", {a_module_path, a_redir_statement.m_tag, a_redir_statement.m_guide}))
+        if (!predicates().m_decl_redir(a_module_path, a_redir_statement.m_tag, a_redir_statement.m_guide))
             throw std::runtime_error(ERR_MSG_DECL_REDIR);
 
         PL_discard_foreign_frame(l_frame);
@@ -127,19 +362,63 @@ namespace unilog
         /////////////////////////////////////////
         // first, query to get the theorem produced by the guide
         /////////////////////////////////////////
-        if (!call_predicate("query", {a_module_path, a_infer_statement.m_guide, l_theorem}))
+        if (!predicates().m_query(a_module_path, a_infer_statement.m_guide, l_theorem))
             throw std::runtime_error(ERR_MSG_INFER);
 
         /////////////////////////////////////////
         // declare the theorem with the provided tag
         /////////////////////////////////////////
-        if (!call_predicate("decl_theorem", {a_module_path, a_infer_statement.m_tag, l_theorem}))
+        if (!predicates().m_decl_theorem(a_module_path, a_infer_statement.m_tag, l_theorem))
             throw std::runtime_error(ERR_MSG_DECL_THEOREM);
 
         PL_discard_foreign_frame(l_frame);
     }
 
-    void execute(const refer_statement &a_refer_statement, term_t a_module_path)
+    std::filesystem::path resolve_refer_path(const std::filesystem::path &a_base_directory, std::string_view a_file_path)
+    {
+        namespace fs = std::filesystem;
+
+        refer_path_cache &l_cache = refer_paths();
+
+        fs::path l_base_directory = a_base_directory.empty() ? fs::current_path() : a_base_directory;
+
+        // the base and the path, which cannot contain a nul
+        std::string l_key = l_base_directory.native();
+        l_key.push_back('\0');
+        l_key.append(a_file_path);
+
+        {
+            std::lock_guard l_lock(l_cache.m_mutex);
+
+            if (auto l_entry = l_cache.m_paths.find(l_key); l_entry != l_cache.m_paths.end())
+                return l_entry->second;
+        }
+
+        /////////////////////////////////////////
+        // resolved outside the lock. paths which fail to resolve are not
+        //     cached, so a file created later is found.
+        /////////////////////////////////////////
+        fs::path l_result = fs::canonical(l_base_directory / a_file_path);
+
+        std::lock_guard l_lock(l_cache.m_mutex);
+
+        return l_cache.m_paths.try_emplace(std::move(l_key), std::move(l_result)).first->second;
+    }
+
+    void execute(const statement &a_statement, term_t a_module_path, const std::filesystem::path &a_base_directory)
+    {
+        std::visit(
+            [a_module_path, &a_base_directory](const auto &a_alternative)
+            {
+                if constexpr (std::is_same_v<std::decay_t<decltype(a_alternative)>, refer_statement>)
+                    execute(a_alternative, a_module_path, a_base_directory);
+                else
+                    execute(a_alternative, a_module_path);
+            },
+            a_statement);
+    }
+
+    void execute(const refer_statement &a_refer_statement, term_t a_module_path, const std::filesystem::path &a_base_directory)
     {
         fid_t l_frame = PL_open_foreign_frame();
 
@@ -158,12 +437,12 @@ namespace unilog
             throw std::runtime_error(ERR_MSG_GET_ATOM_CHARS);
 
         /////////////////////////////////////////
-        // construct fs path objects
+        // construct fs path objects. refers within the file are relative
+        //     to its directory.
         /////////////////////////////////////////
         namespace fs = std::filesystem;
-        fs::path l_canonical_file_path = fs::canonical(l_file_path_c_str);
+        fs::path l_canonical_file_path = resolve_refer_path(a_base_directory, l_file_path_c_str);
         fs::path l_file_parent_path = l_canonical_file_path.parent_path();
-        fs::path l_cwd = fs::current_path();
 
         /////////////////////////////////////////
         // ensure file_path is to a file
@@ -172,107 +451,498 @@ namespace unilog
             throw std::runtime_error(ERR_MSG_NOT_A_FILE);
 
         /////////////////////////////////////////
-        // open filestream
+        // load the file (mapped, and shared with other refers of it)
         /////////////////////////////////////////
-        std::ifstream l_ifs(l_canonical_file_path);
-
-        if (!l_ifs.good())
-            throw std::runtime_error(std::string(ERR_MSG_FILE_OPEN) + ": " + l_file_path_c_str);
+        std::shared_ptr<const source_file> l_source = load_source_file(l_canonical_file_path);
 
         /////////////////////////////////////////
-        // set cwd to parent path of the referee
+        // a file which is not regular (a pipe, say) is read and parsed on
+        //     every refer. a regular one referred again is kept parsed for
+        //     later refers. failing that, a fresh compiled module of it is
+        //     rebuilt instead of parsed, where a directory is given for them.
         /////////////////////////////////////////
-        fs::current_path(l_file_parent_path);
+        bool l_compilable = fs::is_regular_file(l_canonical_file_path);
+
+        std::shared_ptr<const parsed_module> l_cached;
+
+        if (l_compilable)
+            l_cached = refer_module_cache().find(l_canonical_file_path, l_source);
+
+        bool l_compile = l_compilable && !l_cached && !s_module_cache_directory.empty();
+
+        fs::path l_compiled_path;
+        source_stamp l_stamp;
+        std::unique_ptr<compiled_module> l_compiled;
+
+        if (l_compilable && !l_cached)
+            l_stamp = stamp_source(l_canonical_file_path, l_source->text());
+
+        if (l_compile)
+        {
+            l_compiled_path = compiled_module_path(s_module_cache_directory, l_canonical_file_path);
+            l_compiled = compiled_module::open(l_compiled_path, l_stamp);
+        }
+
+        // the statements parsed, if they are to be kept. otherwise each is
+        //     dropped once it has executed.
+        bool l_keep = l_compilable && !l_cached &&
+                      refer_module_cache().admit(l_canonical_file_path, l_stamp.m_hash, l_source->text().size());
+
+        std::shared_ptr<parsed_module> l_parsed_module = std::make_shared<parsed_module>();
 
         /////////////////////////////////////////
-        // construct a charpos tracking streambuf
+        // execute all statements in file
         /////////////////////////////////////////
-        charpos_streambuf l_cpos_sbuf(l_ifs.rdbuf());
-        std::istream l_cpos_ifs(&l_cpos_sbuf);
+
+        // the statement executing, while one is
+        span l_executing_span;
+        bool l_executing = false;
+
+        // set once a chunk fails to parse, where the parser stopped
+        std::optional<size_t> l_parse_stopped;
 
         /////////////////////////////////////////
-        // execute all statements in file
+        // each statement is built and executed in a foreign frame of its
+        //     own, discarded once it has executed. its term refs are then
+        //     reused by the next, so a file holds at most those of its
+        //     largest statement, however many statements it has, and
+        //     however deeply it refers other files.
         /////////////////////////////////////////
-        std::istream_iterator<statement> l_it(l_cpos_ifs);
-        std::istream_iterator<statement> l_end;
+        auto l_execute = [&l_executing_span, &l_executing, l_new_module_path, &l_file_parent_path](const ast_statement &a_parsed)
+        {
+            fid_t l_statement_frame = PL_open_foreign_frame();
+
+            try
+            {
+                statement l_statement = make_statement(a_parsed);
+
+                l_executing_span = a_parsed.m_span;
+                l_executing = true;
+
+                execute(l_statement, l_new_module_path, l_file_parent_path);
+
+                l_executing = false;
+            }
+            catch (...)
+            {
+                PL_discard_foreign_frame(l_statement_frame);
+                throw;
+            }
+
+            PL_discard_foreign_frame(l_statement_frame);
+        };
 
         try
         {
-            for (; l_it != l_end; ++l_it)
+            if (l_cached)
             {
-                std::visit(
-                    [l_new_module_path](const auto &a_statement)
-                    { execute(a_statement, l_new_module_path); }, *l_it);
+                /////////////////////////////////////////
+                // the statements were interned when they were parsed
+                /////////////////////////////////////////
+                for (const std::unique_ptr<parsed_chunk> &l_chunk : l_cached->m_chunks)
+                    for (const ast_statement &l_parsed : l_chunk->m_statements)
+                        l_execute(l_parsed);
+            }
+            else if (l_compiled)
+            {
+                /////////////////////////////////////////
+                // rebuild each statement from the compiled module
+                /////////////////////////////////////////
+                std::unique_ptr<parsed_chunk> l_chunk = std::make_unique<parsed_chunk>();
+                ast_statement l_parsed;
+
+                for (size_t i = 0; i < l_compiled->statement_count(); ++i)
+                {
+                    if (!l_keep)
+                        l_chunk->m_arena.clear();
+
+                    l_compiled->statement(i, l_chunk->m_arena, l_parsed);
+                    refer_pool().intern(l_parsed, l_chunk->m_arena);
+
+                    if (l_keep)
+                        l_chunk->m_statements.push_back(l_parsed);
+
+                    l_execute(l_parsed);
+                }
+
+                if (l_keep)
+                    l_parsed_module->m_chunks.push_back(std::move(l_chunk));
+            }
+            else
+            {
+                /////////////////////////////////////////
+                // parse directly from the file contents, in chunks of whole
+                //     statements, while the chunks before them execute
+                /////////////////////////////////////////
+                parallel_parser l_parser(l_source->text(), s_parse_threads);
+                compiled_module_writer l_writer;
+
+                while (std::unique_ptr<parsed_chunk> l_chunk = l_parser.next())
+                {
+                    for (ast_statement &l_parsed : l_chunk->m_statements)
+                    {
+                        refer_pool().intern(l_parsed, l_chunk->m_arena);
+
+                        l_execute(l_parsed);
+
+                        if (l_compile)
+                            l_writer.add(l_parsed);
+                    }
+
+                    if (l_chunk->m_error)
+                    {
+                        l_parse_stopped = l_chunk->m_error->m_offset;
+                        throw std::runtime_error(l_chunk->m_error->m_message);
+                    }
+
+                    if (l_keep)
+                        l_parsed_module->m_chunks.push_back(std::move(l_chunk));
+                }
+
+                /////////////////////////////////////////
+                // compile the file for next time. where it cannot be written
+                //     (a read-only directory, say), it is parsed every time.
+                /////////////////////////////////////////
+                if (l_compile)
+                {
+                    std::error_code l_error;
+                    fs::create_directories(s_module_cache_directory, l_error);
+
+                    l_writer.write(l_compiled_path, l_stamp);
+                }
             }
+
+            /////////////////////////////////////////
+            // only a module which parsed and executed whole is kept
+            /////////////////////////////////////////
+            if (l_keep)
+                refer_module_cache().insert(l_canonical_file_path, l_source, l_stamp.m_hash, std::move(l_parsed_module));
         }
         catch (const std::runtime_error &l_err)
         {
+            /////////////////////////////////////////
+            // a statement which failed to execute is reported where it begins,
+            //     and one which failed to parse where the lexer stopped.
+            //     lines are only indexed now that a position is needed.
+            /////////////////////////////////////////
+            size_t l_offset = l_executing ? l_executing_span.m_begin : l_parse_stopped.value_or(0);
+            auto [l_row, l_col] = line_index(l_source->text()).position(l_offset);
+
             // unwinding exception (call stack)
             std::string l_unwind_msg =
                 std::string(l_err.what()) +
                 "\nin: " + l_canonical_file_path.string() +
-                std::string(":") + std::to_string(l_cpos_sbuf.row()) +
-                std::string(":") + std::to_string(l_cpos_sbuf.col());
+                std::string(":") + std::to_string(l_row) +
+                std::string(":") + std::to_string(l_col);
             throw std::runtime_error(l_unwind_msg);
         }
 
-        /////////////////////////////////////////
-        // reset cwd to the original cwd
-        /////////////////////////////////////////
-        fs::current_path(l_cwd);
-
         PL_discard_foreign_frame(l_frame);
     }
-}
 
-void wipe_database()
-{
-    call_predicate("wipe_database", {});
-}
+    void retract(const axiom_statement &a_axiom_statement, term_t a_module_path)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
 
-#ifdef UNIT_TEST
+        if (!predicates().m_retract_theorem(a_module_path, a_axiom_statement.m_tag))
+            throw std::runtime_error(ERR_MSG_RETRACT);
 
-#include "test_utils.hpp"
+        PL_discard_foreign_frame(l_frame);
+    }
 
-////////////////////////////////
-//// HELPER FUNCTIONS
-////////////////////////////////
+    void retract(const redir_statement &a_redir_statement, term_t a_module_path)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
 
-////////////////////////////////
-////////////////////////////////
+        if (!predicates().m_retract_redir(a_module_path, a_redir_statement.m_tag))
+            throw std::runtime_error(ERR_MSG_RETRACT);
 
-/////////////////////////////////////////
-// helper struct(s)
-/////////////////////////////////////////
-struct stmt_decl
-{
-    term_t m_module_stack;
-    unilog::statement m_statement;
-};
+        PL_discard_foreign_frame(l_frame);
+    }
 
-static void test_call_predicate()
-{
-    fid_t l_frame = PL_open_foreign_frame();
+    void retract(const infer_statement &a_infer_statement, term_t a_module_path)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
 
-    term_t l_x = PL_new_term_ref();
-    term_t l_y = PL_new_term_ref();
+        if (!predicates().m_retract_theorem(a_module_path, a_infer_statement.m_tag))
+            throw std::runtime_error(ERR_MSG_RETRACT);
 
-    /////////////////////////////////////////
-    // right now, both args variable so ==/2 fails
-    /////////////////////////////////////////
-    assert(!call_predicate("==", {l_x, l_y}));
+        PL_discard_foreign_frame(l_frame);
+    }
 
-    /////////////////////////////////////////
-    // set argument to an atom using PL_unify
-    /////////////////////////////////////////
-    term_t l_atom_term = PL_new_term_ref();
-    assert(PL_put_atom_chars(l_atom_term, "I am an atom"));
-    assert(PL_unify(l_atom_term, l_x));
+    void retract(const refer_statement &a_refer_statement, term_t a_module_path)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
 
-    /////////////////////////////////////////
-    // right now, args not strictly equal
-    /////////////////////////////////////////
-    assert(!call_predicate("==", {l_x, l_y}));
+        term_t l_referee_module_path = PL_new_term_ref();
+        if (!PL_cons_list(l_referee_module_path, a_refer_statement.m_tag, a_module_path))
+            throw std::runtime_error(ERR_MSG_CONS_LIST);
+
+        if (!predicates().m_retract_module(l_referee_module_path))
+            throw std::runtime_error(ERR_MSG_RETRACT);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    bool module_declared(const refer_statement &a_refer_statement, term_t a_module_path)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        term_t l_referee_module_path = PL_new_term_ref();
+        if (!PL_cons_list(l_referee_module_path, a_refer_statement.m_tag, a_module_path))
+            throw std::runtime_error(ERR_MSG_CONS_LIST);
+
+        bool l_result = predicates().m_module_declared(l_referee_module_path);
+
+        PL_discard_foreign_frame(l_frame);
+
+        return l_result;
+    }
+
+    // executes the statements of a_text, which begins a_base bytes into the buffer
+    //     it was taken from. returns the number executed. each statement gets a
+    //     foreign frame of its own.
+    static size_t execute_statements(std::string_view a_text, size_t a_base, term_t a_module_path, std::optional<span> &a_executing, lexer &a_lexer)
+    {
+        size_t l_result = 0;
+
+        a_lexer.assign(a_text, a_base);
+
+        for (;;)
+        {
+            fid_t l_frame = PL_open_foreign_frame();
+
+            statement l_statement;
+
+            if (!(a_lexer >> l_statement))
+            {
+                PL_discard_foreign_frame(l_frame);
+                return l_result;
+            }
+
+            a_executing = get_span(l_statement);
+
+            std::visit([a_module_path](const auto &a_statement)
+                       { execute(a_statement, a_module_path); }, l_statement);
+
+            a_executing.reset();
+
+            PL_discard_foreign_frame(l_frame);
+
+            ++l_result;
+        }
+    }
+
+    stream_statistics execute_stream(int a_fd, const std::string &a_name, term_t a_module_path)
+    {
+        // least input read at once. more is read when a statement is longer.
+        constexpr size_t MIN_READ_SIZE = 64 * 1024;
+
+        auto l_start = std::chrono::steady_clock::now();
+
+        stream_statistics l_result;
+
+        // input not yet executed. spans are offsets into it, so they stay
+        //     small however long the stream runs.
+        std::string l_buffer;
+
+        // newlines in the discarded input, and bytes discarded since the last one
+        size_t l_discarded_lines = 0;
+        size_t l_discarded_column = 0;
+
+        // set when the buffer may hold a complete statement not yet executed
+        bool l_may_hold_statement = false;
+
+        bool l_eof = false;
+
+        lexer l_lexer;
+        std::optional<span> l_executing;
+
+        try
+        {
+            while (!l_eof || !l_buffer.empty())
+            {
+                /////////////////////////////////////////
+                // execute each complete statement in the buffer. the last
+                //     one is left for the next read when the buffer ends at its
+                //     ';', as a comment or quote could be hiding that ';'.
+                /////////////////////////////////////////
+                const char *l_begin = l_buffer.data();
+                const char *l_end = l_begin + l_buffer.size();
+                const char *l_pos = l_begin;
+
+                while (l_may_hold_statement || l_eof)
+                {
+                    const char *l_statement_end = l_eof ? l_end : find_statement_end(l_pos, l_end);
+
+                    if (l_statement_end == l_pos || (l_statement_end == l_end && !l_eof))
+                        break;
+
+                    l_result.m_statements += execute_statements(
+                        std::string_view(l_pos, l_statement_end - l_pos), l_pos - l_begin, a_module_path, l_executing, l_lexer);
+
+                    l_pos = l_statement_end;
+                }
+
+                /////////////////////////////////////////
+                // discard what was executed, keeping count of lines for error positions
+                /////////////////////////////////////////
+                for (const char *l_line = l_begin; l_line != l_pos; ++l_discarded_lines)
+                {
+                    const char *l_newline = find_newline(l_line, l_pos);
+
+                    if (l_newline == l_pos)
+                    {
+                        l_discarded_column += l_pos - l_line;
+                        break;
+                    }
+
+                    l_discarded_column = 0;
+                    l_line = l_newline + 1;
+                }
+
+                l_buffer.erase(0, l_pos - l_begin);
+
+                if (l_eof)
+                    break;
+
+                /////////////////////////////////////////
+                // read at least as much as is buffered, so that a long statement
+                //     is only scanned for its end a logarithmic number of times
+                /////////////////////////////////////////
+                size_t l_size = l_buffer.size();
+                size_t l_read_size = std::max(MIN_READ_SIZE, l_size);
+
+                l_buffer.resize(l_size + l_read_size);
+
+                ssize_t l_read;
+
+                do
+                    l_read = ::read(a_fd, l_buffer.data() + l_size, l_read_size);
+                while (l_read < 0 && errno == EINTR);
+
+                if (l_read < 0)
+                    throw std::runtime_error(ERR_MSG_FILE_READ);
+
+                l_buffer.resize(l_size + l_read);
+
+                l_result.m_bytes += l_read;
+                l_result.m_peak_buffered = std::max(l_result.m_peak_buffered, l_buffer.size());
+
+                l_eof = l_read == 0;
+
+                // a statement can only be complete if a ';' was just read, or if
+                //     the buffer ended at one before
+                l_may_hold_statement = (l_size > 0 && l_buffer[l_size - 1] == ';') ||
+                                       std::memchr(l_buffer.data() + l_size, ';', l_read) != nullptr;
+            }
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            /////////////////////////////////////////
+            // a statement which failed to execute is reported where it begins,
+            //     and one which failed to parse where the lexer stopped.
+            //     offsets are into the buffer, which still holds the statement.
+            /////////////////////////////////////////
+            size_t l_offset = l_executing ? l_executing->m_begin : l_lexer.offset();
+            auto [l_row, l_col] = line_index(l_buffer).position(l_offset);
+
+            if (l_row == 1)
+                l_col += l_discarded_column;
+
+            l_row += l_discarded_lines;
+
+            throw std::runtime_error(
+                std::string(l_err.what()) +
+                "\nin: " + a_name +
+                std::string(":") + std::to_string(l_row) +
+                std::string(":") + std::to_string(l_col));
+        }
+
+        l_result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - l_start).count();
+
+        return l_result;
+    }
+}
+
+void wipe_database()
+{
+    predicates().m_wipe_database();
+}
+
+#ifdef UNIT_TEST
+
+#include <fstream>
+#include <thread>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+// calls a predicate by name, for tests of predicates the executor does not call
+static int call_predicate(const std::string &a_functor, const std::vector<term_t> &a_args)
+{
+    /////////////////////////////////////////
+    // define predicate we wish to call
+    /////////////////////////////////////////
+    predicate_t l_predicate = PL_predicate(a_functor.c_str(), a_args.size(), NULL);
+
+    /////////////////////////////////////////
+    // construct contiguous term refs for args (must always declare at least 1)
+    /////////////////////////////////////////
+    term_t l_contiguous_args = PL_new_term_refs(std::max(1, (int)a_args.size()));
+
+    /////////////////////////////////////////
+    // unify supplied args with contiguous refs
+    /////////////////////////////////////////
+    for (int i = 0; i < (int)a_args.size(); ++i)
+    {
+        if (!PL_unify(l_contiguous_args + i, a_args[i]))
+            throw std::runtime_error(ERR_MSG_UNIFY);
+    }
+
+    /////////////////////////////////////////
+    // call the predicate finally, and return the result.
+    /////////////////////////////////////////
+    return PL_call_predicate(NULL, PL_Q_NORMAL, l_predicate, l_contiguous_args);
+}
+
+////////////////////////////////
+////////////////////////////////
+
+/////////////////////////////////////////
+// helper struct(s)
+/////////////////////////////////////////
+struct stmt_decl
+{
+    term_t m_module_stack;
+    unilog::statement m_statement;
+};
+
+static void test_call_predicate()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    term_t l_x = PL_new_term_ref();
+    term_t l_y = PL_new_term_ref();
+
+    /////////////////////////////////////////
+    // right now, both args variable so ==/2 fails
+    /////////////////////////////////////////
+    assert(!call_predicate("==", {l_x, l_y}));
+
+    /////////////////////////////////////////
+    // set argument to an atom using PL_unify
+    /////////////////////////////////////////
+    term_t l_atom_term = PL_new_term_ref();
+    assert(PL_put_atom_chars(l_atom_term, "I am an atom"));
+    assert(PL_unify(l_atom_term, l_x));
+
+    /////////////////////////////////////////
+    // right now, args not strictly equal
+    /////////////////////////////////////////
+    assert(!call_predicate("==", {l_x, l_y}));
 
     /////////////////////////////////////////
     // set argument to an atom using PL_unify
@@ -287,69 +957,37 @@ static void test_call_predicate()
     PL_discard_foreign_frame(l_frame);
 }
 
-static void test_charpos_streambuf()
+static void test_prolog_predicate()
 {
-    using pos = std::pair<int, int>;
+    fid_t l_frame = PL_open_foreign_frame();
 
-    data_points<std::string, pos> l_data_points =
-        {
-            {"abc", {1, 4}},
-            {"abc\n", {2, 1}},
-            {"ab\nc", {2, 2}},
-            {"a\nbc", {2, 3}},
-            {"fasdfjklf fgd dfFFFjf 7 8^&>?/.?\\ \r ", {1, 37}},
-            {"fasdfjklf fgd dfFFFjf 7 8^&>?/.?\\ \r \n", {2, 1}},
-            {"fasdfjklf fgd\n dfFFFjf 7 8^&>?/.?\\ \r ", {2, 24}},
-        };
+    prolog_predicate<2> l_unify("=");
+    prolog_predicate<2> l_equal("==");
 
-    for (const auto &[l_str, l_position] : l_data_points)
-    {
-        std::stringstream l_ss(l_str);
-        charpos_streambuf l_sbuf(l_ss.rdbuf());
-        std::istream l_charpos_istream(&l_sbuf);
+    term_t l_x = PL_new_term_ref();
+    term_t l_y = PL_new_term_ref();
 
-        char l_char;
-        while (l_charpos_istream.get(l_char))
-            ; // extract all chars
+    assert(!l_equal(l_x, l_y));
 
-        assert(l_position == (pos{l_sbuf.row(), l_sbuf.col()}));
-    }
+    /////////////////////////////////////////
+    // bindings made by the call are seen through the caller's refs
+    /////////////////////////////////////////
+    assert(l_unify(l_x, make_atom("a")));
+    assert(PL_is_atom(l_x));
 
-    {
-        std::stringstream l_ss("a\n");
-        charpos_streambuf l_sbuf(l_ss.rdbuf());
-        std::istream l_charpos_istream(&l_sbuf);
-        assert(l_charpos_istream.peek() == 'a');
-        assert(l_sbuf.row() == 1);
-        assert(l_sbuf.col() == 1);
-        assert(l_charpos_istream.get() == 'a');
-        assert(l_sbuf.row() == 1);
-        assert(l_sbuf.col() == 2);
-        assert(l_charpos_istream.peek() == '\n');
-        assert(l_sbuf.row() == 1);
-        assert(l_sbuf.col() == 2);
-        assert(l_charpos_istream.get() == '\n');
-        assert(l_sbuf.row() == 2);
-        assert(l_sbuf.col() == 1);
-    }
+    assert(!l_unify(l_x, make_atom("b")));
+    assert(l_unify(l_x, l_y));
+    assert(l_equal(l_x, l_y));
 
-    {
-        std::stringstream l_ss("\na");
-        charpos_streambuf l_sbuf(l_ss.rdbuf());
-        std::istream l_charpos_istream(&l_sbuf);
-        assert(l_charpos_istream.peek() == '\n');
-        assert(l_sbuf.row() == 1);
-        assert(l_sbuf.col() == 1);
-        assert(l_charpos_istream.get() == '\n');
-        assert(l_sbuf.row() == 2);
-        assert(l_sbuf.col() == 1);
-        assert(l_charpos_istream.peek() == 'a');
-        assert(l_sbuf.row() == 2);
-        assert(l_sbuf.col() == 1);
-        assert(l_charpos_istream.get() == 'a');
-        assert(l_sbuf.row() == 2);
-        assert(l_sbuf.col() == 2);
-    }
+    /////////////////////////////////////////
+    // the block of argument refs is released after each call
+    /////////////////////////////////////////
+    term_t l_before = PL_new_term_ref();
+
+    assert(l_equal(l_x, l_y));
+    assert(PL_new_term_ref() == l_before + 1);
+
+    PL_discard_foreign_frame(l_frame);
 }
 
 static void test_assertz_and_retract_all()
@@ -1130,7 +1768,7 @@ static void test_execute_refer_statement()
         std::vector<guide> m_redirs;
     };
 
-    std::map<std::string, term_t> l_var_decl_alist;
+    unilog::variable_table<term_t> l_var_decl_alist;
 
     std::vector<file_test_case> l_file_test_cases =
         {
@@ -1805,12 +2443,733 @@ static void test_execute_refer_statement()
     PL_discard_foreign_frame(l_frame);
 }
 
+static void test_refer_error_position()
+{
+    namespace fs = std::filesystem;
+
+    using unilog::execute;
+    using unilog::refer_statement;
+
+    fs::path l_path = fs::temp_directory_path() / "unilog_executor_error_position.u";
+    fs::path l_cwd = fs::current_path();
+
+    data_points<std::string, std::string> l_data_points =
+        {
+            // a statement which fails to execute is reported where it begins
+            {"axiom a0 x;\n\n  axiom a0 y; # duplicate\n", ":3:3"},
+            // and one which fails to parse, where the lexer stopped
+            {"axiom a0 x;\naxiom a1 ];\n", ":2:11"},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        {
+            std::ofstream l_ofs(l_path, std::ios::binary | std::ios::trunc);
+            l_ofs << l_key;
+        }
+
+        std::string l_message;
+
+        try
+        {
+            execute(refer_statement{
+                        .m_tag = make_atom("root"),
+                        .m_file_path = make_atom(l_path.string()),
+                    },
+                    make_nil());
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            l_message = l_err.what();
+        }
+
+        assert(l_message.ends_with(l_path.string() + l_value));
+
+        // the cwd is left alone, even by a failed refer
+        assert(fs::current_path() == l_cwd);
+
+        wipe_database();
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    fs::remove(l_path);
+}
+
+static void test_refer_base_directory()
+{
+    namespace fs = std::filesystem;
+
+    using unilog::execute;
+    using unilog::refer_statement;
+
+    fs::path l_directory = fs::canonical(fs::temp_directory_path()) / "unilog_executor_base_directory";
+    fs::path l_cwd = fs::current_path();
+
+    fs::remove_all(l_directory);
+    fs::create_directories(l_directory / "sub");
+
+    auto l_write = [](const fs::path &a_path, const std::string &a_text)
+    {
+        std::ofstream l_ofs(a_path, std::ios::binary | std::ios::trunc);
+        l_ofs << a_text;
+    };
+
+    /////////////////////////////////////////
+    // each refer is relative to the file it is in, not to the cwd
+    /////////////////////////////////////////
+    l_write(l_directory / "main.u", "refer s './sub/s.u';\n");
+    l_write(l_directory / "sub" / "s.u", "refer c '../c.u';\naxiom s x;\n");
+    l_write(l_directory / "c.u", "axiom c y;\n");
+
+    assert(unilog::resolve_refer_path(l_directory, "./c.u") == l_directory / "c.u");
+    assert(unilog::resolve_refer_path(l_directory / "sub", "../c.u") == l_directory / "c.u");
+    assert(unilog::resolve_refer_path(l_directory / "sub", "./s.u") == l_directory / "sub" / "s.u");
+    assert(unilog::resolve_refer_path(l_directory / "sub", "./s.u") == l_directory / "sub" / "s.u");
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    execute(refer_statement{
+                .m_tag = make_atom("root"),
+                .m_file_path = make_atom("./main.u"),
+            },
+            make_nil(), l_directory);
+
+    assert(fs::current_path() == l_cwd);
+
+    assert(call_predicate("theorem", {make_list({make_atom("s"), make_atom("root")}), make_atom("s"), make_atom("x")}));
+    assert(call_predicate("theorem", {make_list({make_atom("c"), make_atom("s"), make_atom("root")}), make_atom("c"), make_atom("y")}));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // a path which does not resolve is not cached, so it is found once it exists
+    /////////////////////////////////////////
+    bool l_thrown = false;
+
+    try
+    {
+        unilog::resolve_refer_path(l_directory, "./later.u");
+    }
+    catch (const fs::filesystem_error &)
+    {
+        l_thrown = true;
+    }
+
+    assert(l_thrown);
+
+    l_write(l_directory / "later.u", "");
+
+    assert(unilog::resolve_refer_path(l_directory, "./later.u") == l_directory / "later.u");
+
+    /////////////////////////////////////////
+    // a resolved path is kept until the refer state is cleared, so a link
+    //     pointed elsewhere meanwhile is followed only after that
+    /////////////////////////////////////////
+    fs::create_symlink(l_directory / "c.u", l_directory / "link.u");
+
+    assert(unilog::resolve_refer_path(l_directory, "./link.u") == l_directory / "c.u");
+
+    fs::remove(l_directory / "link.u");
+    fs::create_symlink(l_directory / "later.u", l_directory / "link.u");
+
+    assert(unilog::resolve_refer_path(l_directory, "./link.u") == l_directory / "c.u");
+
+    unilog::clear_refer_state();
+
+    assert(unilog::resolve_refer_path(l_directory, "./link.u") == l_directory / "later.u");
+
+    PL_discard_foreign_frame(l_frame);
+
+    fs::remove_all(l_directory);
+}
+
+static void test_refer_term_refs_bounded()
+{
+    namespace fs = std::filesystem;
+
+    using unilog::execute;
+    using unilog::refer_statement;
+
+    fs::path l_directory = fs::canonical(fs::temp_directory_path()) / "unilog_executor_term_refs";
+
+    fs::remove_all(l_directory);
+    fs::create_directories(l_directory);
+
+    auto l_write = [](const fs::path &a_path, const std::string &a_text)
+    {
+        std::ofstream l_ofs(a_path, std::ios::binary | std::ios::trunc);
+        l_ofs << a_text;
+    };
+
+    l_write(l_directory / "small.u", "axiom a0 [p x];\n");
+
+    /////////////////////////////////////////
+    // many statements, some of them large, and a nested refer with more
+    /////////////////////////////////////////
+    std::string l_large;
+    std::string l_nested;
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        l_large += "axiom a" + std::to_string(i) + " [p [q k" + std::to_string(i) + " X] [r X Y] [s [t Y]]];\n";
+        l_nested += "axiom n" + std::to_string(i) + " [n k" + std::to_string(i) + "];\n";
+    }
+
+    l_large += "refer sub './nested.u';\naxiom h [if y x];\naxiom g x;\ninfer i0 [mp [t h] [t g]];\n";
+
+    l_write(l_directory / "large.u", l_large);
+    l_write(l_directory / "nested.u", l_nested);
+
+    // the term refs a refer of a_file leaves allocated, once it returns
+    auto l_refs_left = [&l_directory](const char *a_file)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        refer_statement l_refer{
+            .m_tag = make_atom("root"),
+            .m_file_path = make_atom(a_file),
+        };
+
+        term_t l_module_path = make_nil();
+        term_t l_before = PL_new_term_ref();
+
+        execute(l_refer, l_module_path, l_directory);
+
+        term_t l_after = PL_new_term_ref();
+
+        PL_discard_foreign_frame(l_frame);
+        wipe_database();
+
+        return l_after - l_before;
+    };
+
+    // the first refer may allocate what is cached for later ones
+    l_refs_left("./small.u");
+
+    assert(l_refs_left("./large.u") == l_refs_left("./small.u"));
+
+    fs::remove_all(l_directory);
+}
+
+static void test_refer_compiled_module()
+{
+    namespace fs = std::filesystem;
+
+    using unilog::execute;
+    using unilog::refer_statement;
+
+    fs::path l_path = fs::canonical(fs::temp_directory_path()) / "unilog_executor_compiled.u";
+    fs::path l_cache_directory = fs::temp_directory_path() / "unilog_executor_compiled_cache";
+    fs::path l_compiled_path = unilog::compiled_module_path(l_cache_directory, l_path);
+    fs::path l_cwd = fs::current_path();
+
+    fs::remove_all(l_cache_directory);
+
+    auto l_write_source = [&l_path](const std::string &a_text)
+    {
+        std::ofstream l_ofs(l_path, std::ios::binary | std::ios::trunc);
+        l_ofs << a_text;
+    };
+
+    // refers the file, returning the error, if any
+    auto l_refer = [&l_path, &l_cwd]()
+    {
+        std::string l_message;
+
+        try
+        {
+            execute(refer_statement{
+                        .m_tag = make_atom("root"),
+                        .m_file_path = make_atom(l_path.string()),
+                    },
+                    make_nil());
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            l_message = l_err.what();
+        }
+
+        assert(fs::current_path() == l_cwd);
+
+        return l_message;
+    };
+
+    // the theorem declared as a_tag, in the module the file was referred as
+    auto l_declared = [](const char *a_tag, term_t a_theorem)
+    {
+        term_t l_theorem = PL_new_term_ref();
+
+        return call_predicate("theorem", {make_list({make_atom("root")}), make_atom(a_tag), l_theorem}) &&
+               equal_forms(l_theorem, a_theorem);
+    };
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    unilog::variable_table<term_t> l_var_alist;
+    term_t l_a0 = make_list({make_atom("p"), make_var("X", l_var_alist), make_var("X", l_var_alist)});
+    term_t l_a1 = make_list({make_atom("q"), make_list({make_atom("a"), make_atom("b")})});
+
+    l_write_source("axiom a0 [p X X];\n  axiom a1 [q [a b]];\n");
+
+    /////////////////////////////////////////
+    // without a directory for them, nothing is compiled
+    /////////////////////////////////////////
+    assert(l_refer().empty());
+    assert(!fs::exists(l_cache_directory));
+
+    unilog::clear_refer_cache();
+    wipe_database();
+
+    /////////////////////////////////////////
+    // with one, the first refer parses the file, and compiles it there
+    /////////////////////////////////////////
+    unilog::set_module_cache_directory(l_cache_directory);
+
+    assert(l_refer().empty());
+    assert(fs::exists(l_compiled_path));
+    assert(!fs::exists(l_path.string() + "c"));
+    assert(l_declared("a0", l_a0) && l_declared("a1", l_a1));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // later refers execute the compiled module, as they would the text,
+    //     once the parsed module is no longer kept in memory
+    /////////////////////////////////////////
+    unilog::clear_refer_cache();
+
+    fs::file_time_type l_compiled_time = fs::last_write_time(l_compiled_path);
+
+    assert(l_refer().empty());
+    assert(l_declared("a0", l_a0) && l_declared("a1", l_a1));
+    assert(fs::last_write_time(l_compiled_path) == l_compiled_time);
+
+    // and report errors where the statement is in the source
+    unilog::clear_refer_cache();
+
+    assert(l_refer().ends_with(l_path.string() + ":1:1"));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // a changed source is parsed again, and recompiled
+    /////////////////////////////////////////
+    l_write_source("axiom a1 [q [a b]];\n");
+
+    assert(l_refer().empty());
+    assert(!l_declared("a0", l_a0) && l_declared("a1", l_a1));
+    assert(fs::last_write_time(l_compiled_path) != l_compiled_time);
+
+    wipe_database();
+
+    // and an unchanged one is not
+    l_compiled_time = fs::last_write_time(l_compiled_path);
+
+    assert(l_refer().empty());
+    assert(fs::last_write_time(l_compiled_path) == l_compiled_time);
+
+    wipe_database();
+
+    PL_discard_foreign_frame(l_frame);
+
+    unilog::set_module_cache_directory({});
+
+    fs::remove(l_path);
+    fs::remove_all(l_cache_directory);
+}
+
+static void test_refer_module_cache()
+{
+    namespace fs = std::filesystem;
+
+    using unilog::execute;
+    using unilog::refer_statement;
+
+    fs::path l_directory = fs::canonical(fs::temp_directory_path()) / "unilog_executor_module_cache";
+
+    fs::remove_all(l_directory);
+    fs::create_directories(l_directory);
+
+    auto l_write = [](const fs::path &a_path, const std::string &a_text)
+    {
+        std::ofstream l_ofs(a_path, std::ios::binary | std::ios::trunc);
+        l_ofs << a_text;
+    };
+
+    auto l_refer_main = [&l_directory]()
+    {
+        execute(refer_statement{
+                    .m_tag = make_atom("root"),
+                    .m_file_path = make_atom("./main.u"),
+                },
+                make_nil(), l_directory);
+    };
+
+    // whether a_tag declares [a_name] in the module lib.u was referred as by a_module
+    auto l_declared = [](const char *a_module, const char *a_tag, const char *a_name)
+    {
+        return call_predicate("theorem", {make_list({make_atom(a_module), make_atom("root")}), make_atom(a_tag), make_list({make_atom(a_name)})});
+    };
+
+    std::string l_lib = "axiom a [x];\naxiom b [y];\n";
+
+    l_write(l_directory / "main.u", "refer m0 './lib.u';\nrefer m1 './lib.u';\nrefer m2 './lib.u';\nrefer m3 './lib.u';\n");
+    l_write(l_directory / "lib.u", l_lib);
+
+    // refers main.u, returning how the cache's totals changed
+    auto l_count = [&l_refer_main]()
+    {
+        unilog::module_cache_statistics l_before = unilog::refer_cache_statistics();
+
+        try
+        {
+            l_refer_main();
+        }
+        catch (const std::runtime_error &)
+        {
+            // the caller checks what was kept
+        }
+
+        unilog::module_cache_statistics l_after = unilog::refer_cache_statistics();
+
+        return std::tuple(l_after.m_misses - l_before.m_misses, l_after.m_hits - l_before.m_hits,
+                          l_after.m_bytes_saved - l_before.m_bytes_saved);
+    };
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    /////////////////////////////////////////
+    // lib.u is parsed as a stream the first time, kept the second, and
+    //     executed from the cache into every later module. main.u, referred
+    //     once, is not kept.
+    /////////////////////////////////////////
+    size_t l_kept = unilog::refer_cache_statistics().m_bytes_kept;
+
+    assert(l_count() == std::tuple(3, 2, 2 * l_lib.size()));
+    assert(unilog::refer_cache_statistics().m_bytes_kept - l_kept == l_lib.size());
+
+    for (const char *l_module : {"m0", "m1", "m2", "m3"})
+        assert(l_declared(l_module, "a", "x") && l_declared(l_module, "b", "y"));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // a file written again with the same content is still a hit
+    /////////////////////////////////////////
+    l_write(l_directory / "lib.u", l_lib);
+    fs::last_write_time(l_directory / "lib.u", fs::last_write_time(l_directory / "lib.u") + std::chrono::seconds(1));
+
+    assert(l_count() == std::tuple(1, 4, 4 * l_lib.size()));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // a changed file is dropped, and kept again from its second refer
+    /////////////////////////////////////////
+    l_write(l_directory / "lib.u", "axiom a [z];\n");
+
+    assert(std::get<0>(l_count()) == 2);
+
+    for (const char *l_module : {"m0", "m1", "m2", "m3"})
+        assert(l_declared(l_module, "a", "z") && !l_declared(l_module, "b", "y"));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // a module which fails to execute is not kept
+    /////////////////////////////////////////
+    l_write(l_directory / "lib.u", "axiom a [x];\naxiom a [x];\n");
+
+    assert(std::get<0>(l_count()) == 1);
+
+    wipe_database();
+
+    assert(std::get<0>(l_count()) == 1);
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // within the limit, the least recently used module is dropped first
+    /////////////////////////////////////////
+    unilog::clear_refer_cache();
+    unilog::set_refer_cache_limit(l_lib.size());
+
+    l_write(l_directory / "lib.u", l_lib);
+    l_write(l_directory / "lib2.u", l_lib);
+    l_write(l_directory / "main.u", "refer m0 './lib.u';\nrefer m1 './lib.u';\nrefer m2 './lib2.u';\nrefer m3 './lib2.u';\nrefer m4 './lib.u';\n");
+
+    assert(l_count() == std::tuple(6, 0, 0));
+    assert(unilog::refer_cache_statistics().m_bytes_kept == l_lib.size());
+
+    wipe_database();
+
+    // and a file larger than the limit is never kept
+    unilog::set_refer_cache_limit(l_lib.size() - 1);
+
+    assert(unilog::refer_cache_statistics().m_bytes_kept == 0);
+    assert(l_count() == std::tuple(6, 0, 0));
+
+    wipe_database();
+
+    unilog::set_refer_cache_limit(unilog::DEFAULT_REFER_CACHE_LIMIT);
+    unilog::clear_refer_cache();
+
+    PL_discard_foreign_frame(l_frame);
+
+    fs::remove_all(l_directory);
+}
+
+static void test_clear_refer_state()
+{
+    namespace fs = std::filesystem;
+
+    fs::path l_path = fs::canonical(fs::temp_directory_path()) / "unilog_executor_refer_state.u";
+
+    std::string l_lib = "axiom a [[x y] [x y]];\n";
+
+    {
+        std::ofstream l_ofs(l_path, std::ios::binary | std::ios::trunc);
+        l_ofs << l_lib;
+    }
+
+    auto l_refer = [&l_path](const char *a_tag)
+    {
+        unilog::execute(unilog::refer_statement{
+                            .m_tag = make_atom(a_tag),
+                            .m_file_path = make_atom(l_path.c_str()),
+                        },
+                        make_nil());
+    };
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    unilog::clear_refer_state();
+
+    const unilog::pool_statistics &l_pool = unilog::refer_pool_statistics();
+
+    /////////////////////////////////////////
+    // the file's lists are pooled once, and its module kept from its
+    //     second refer
+    /////////////////////////////////////////
+    size_t l_pooled_before = l_pool.m_pooled_cells;
+
+    l_refer("m0");
+
+    size_t l_pooled = l_pool.m_pooled_cells - l_pooled_before;
+
+    assert(l_pooled > 0);
+
+    l_refer("m1");
+
+    assert(l_pool.m_pooled_cells == l_pooled_before + l_pooled);
+    assert(unilog::refer_cache_statistics().m_bytes_kept == l_lib.size());
+
+    /////////////////////////////////////////
+    // once cleared, nothing is kept, and the lists are pooled anew
+    /////////////////////////////////////////
+    unilog::clear_refer_state();
+
+    assert(unilog::refer_cache_statistics().m_bytes_kept == 0);
+
+    l_refer("m2");
+
+    assert(l_pool.m_pooled_cells == l_pooled_before + 2 * l_pooled);
+
+    wipe_database();
+    unilog::clear_refer_state();
+
+    PL_discard_foreign_frame(l_frame);
+
+    fs::remove(l_path);
+}
+
+// writes a_text into a new pipe from another thread, a_piece bytes at a time,
+//     and returns the read end
+static int pipe_text(const std::string &a_text, size_t a_piece, std::thread &a_writer)
+{
+    int l_fds[2];
+    assert(::pipe(l_fds) == 0);
+
+    a_writer = std::thread([a_text, a_piece, l_write_fd = l_fds[1]]()
+                           {
+                               for (size_t i = 0; i < a_text.size(); i += a_piece)
+                                   assert(::write(l_write_fd, a_text.data() + i, std::min(a_piece, a_text.size() - i)) > 0);
+
+                               ::close(l_write_fd); });
+
+    return l_fds[0];
+}
+
+static void test_execute_stream()
+{
+    using unilog::execute_stream;
+    using unilog::stream_statistics;
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    /////////////////////////////////////////
+    // statements split across many small writes, with ';'
+    //     hidden in quotes and comments along the way
+    /////////////////////////////////////////
+    constexpr size_t STATEMENT_COUNT = 8000;
+
+    std::string l_text = "# header; not a statement\n";
+
+    for (size_t i = 0; i < STATEMENT_COUNT; i++)
+        l_text += "axiom a" + std::to_string(i) + " [if y 'x;" + std::to_string(i) + "'];\n";
+
+    l_text += "axiom x 'x;0';\ninfer i0 [mp [t a0] [t x]]; # trailing; comment";
+
+    std::thread l_writer;
+    int l_fd = pipe_text(l_text, 7, l_writer);
+
+    term_t l_module_path = make_list({make_atom("root")});
+
+    stream_statistics l_statistics = execute_stream(l_fd, "<test>", l_module_path);
+
+    l_writer.join();
+    ::close(l_fd);
+
+    assert(l_statistics.m_statements == STATEMENT_COUNT + 2);
+    assert(l_statistics.m_bytes == l_text.size());
+
+    // never more than a read's worth of input was held, whatever the length of the stream
+    assert(l_statistics.m_peak_buffered < l_text.size() / 2);
+
+    term_t l_theorem = PL_new_term_ref();
+
+    assert(call_predicate("theorem", {l_module_path, make_atom("a7999"), PL_new_term_ref()}));
+    assert(call_predicate("theorem", {l_module_path, make_atom("i0"), l_theorem}));
+    assert(equal_forms(l_theorem, make_atom("y")));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // errors are positioned within the whole stream
+    /////////////////////////////////////////
+    data_points<std::string, std::string> l_data_points =
+        {
+            {"axiom a0 x;\n  axiom a0 y;\n", "<test>:2:3"},
+            {"axiom a0 x; axiom a1 ];", "<test>:1:23"},
+            {"axiom a0 x;\naxiom a1", "<test>:2:9"},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        l_fd = pipe_text(l_key, 3, l_writer);
+
+        std::string l_message;
+
+        try
+        {
+            execute_stream(l_fd, "<test>", l_module_path);
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            l_message = l_err.what();
+        }
+
+        l_writer.join();
+        ::close(l_fd);
+
+        assert(l_message.ends_with(l_value));
+
+        wipe_database();
+    }
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+static void test_retract_statement()
+{
+    using unilog::axiom_statement;
+    using unilog::execute;
+    using unilog::infer_statement;
+    using unilog::redir_statement;
+    using unilog::refer_statement;
+    using unilog::retract;
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    term_t l_module_path = make_list({make_atom("root")});
+    term_t l_result = PL_new_term_ref();
+
+    axiom_statement l_axiom{
+        .m_tag = make_atom("a0"),
+        .m_theorem = make_atom("x"),
+    };
+
+    redir_statement l_redir{
+        .m_tag = make_atom("r0"),
+        .m_guide = make_list({make_atom("t"), make_atom("a0")}),
+    };
+
+    infer_statement l_infer{
+        .m_tag = make_atom("i0"),
+        .m_guide = make_list({make_atom("r"), make_atom("r0")}),
+    };
+
+    execute(l_axiom, l_module_path);
+    execute(l_redir, l_module_path);
+    execute(l_infer, l_module_path);
+
+    /////////////////////////////////////////
+    // retracting the inference leaves what it was inferred from
+    /////////////////////////////////////////
+    retract(l_infer, l_module_path);
+
+    assert(!call_predicate("theorem", {l_module_path, l_infer.m_tag, l_result}));
+    assert(call_predicate("theorem", {l_module_path, l_axiom.m_tag, l_result}));
+
+    /////////////////////////////////////////
+    // so it may be executed again
+    /////////////////////////////////////////
+    execute(l_infer, l_module_path);
+
+    retract(l_axiom, l_module_path);
+    retract(l_redir, l_module_path);
+
+    assert(!call_predicate("theorem", {l_module_path, l_axiom.m_tag, l_result}));
+    assert(!call_predicate("redir", {l_module_path, l_redir.m_tag, l_result}));
+    assert(call_predicate("theorem", {l_module_path, l_infer.m_tag, l_result}));
+
+    wipe_database();
+
+    /////////////////////////////////////////
+    // retracting a refer retracts the whole module it declared, and nothing else
+    /////////////////////////////////////////
+    refer_statement l_refer{
+        .m_tag = make_atom("math"),
+        .m_file_path = make_atom("./src/test_input_files/executor_example_0/test.u"),
+    };
+
+    execute(l_axiom, l_module_path);
+
+    assert(!unilog::module_declared(l_refer, l_module_path));
+
+    execute(l_refer, l_module_path);
+
+    assert(unilog::module_declared(l_refer, l_module_path));
+
+    retract(l_refer, l_module_path);
+
+    assert(!unilog::module_declared(l_refer, l_module_path));
+    assert(call_predicate("theorem", {l_module_path, l_axiom.m_tag, l_result}));
+
+    wipe_database();
+
+    PL_discard_foreign_frame(l_frame);
+}
+
 void test_executor_main()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
     TEST(test_call_predicate);
-    TEST(test_charpos_streambuf);
+    TEST(test_prolog_predicate);
     TEST(test_assertz_and_retract_all);
     TEST(test_wipe_database);
     TEST(test_execute_axiom_statement);
@@ -1823,6 +3182,15 @@ void test_executor_main()
 
     // this test depends on behavior tested in above functions
     TEST(test_execute_refer_statement);
+    TEST(test_refer_error_position);
+    TEST(test_refer_compiled_module);
+    TEST(test_refer_base_directory);
+    TEST(test_refer_term_refs_bounded);
+    TEST(test_refer_module_cache);
+    TEST(test_clear_refer_state);
+    TEST(test_execute_stream);
+
+    TEST(test_retract_statement);
 }
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef EXECUTOR_HPP
 #define EXECUTOR_HPP
 
+#include <filesystem>
+#include <string_view>
 #include "parser.hpp"
 
 namespace unilog
@@ -8,7 +10,95 @@ namespace unilog
     void execute(const axiom_statement &a_axiom_statement, term_t a_module_path);
     void execute(const redir_statement &a_redir_statement, term_t a_module_path);
     void execute(const infer_statement &a_infer_statement, term_t a_module_path);
-    void execute(const refer_statement &a_refer_statement, term_t a_module_path);
+    // a_base_directory is the directory the referred file path is relative
+    //     to: that of the file the refer is in. empty means the working
+    //     directory. the working directory is never changed.
+    void execute(const refer_statement &a_refer_statement, term_t a_module_path, const std::filesystem::path &a_base_directory = {});
+
+    // executes a statement of any kind, with a refer's path relative to a_base_directory
+    void execute(const statement &a_statement, term_t a_module_path, const std::filesystem::path &a_base_directory = {});
+
+    // the canonical path of the file a refer of a_file_path names, from a
+    //     file in a_base_directory (the working directory, if empty).
+    //     results are cached by (base, path) until clear_refer_state, so
+    //     repeated refers of a file do not resolve it again. safe to call
+    //     from any thread.
+    std::filesystem::path resolve_refer_path(const std::filesystem::path &a_base_directory, std::string_view a_file_path);
+
+    // undo the declarations made by executing the statement. a refer
+    //     retracts everything declared inside the module it named.
+    void retract(const axiom_statement &a_axiom_statement, term_t a_module_path);
+    void retract(const redir_statement &a_redir_statement, term_t a_module_path);
+    void retract(const infer_statement &a_infer_statement, term_t a_module_path);
+    void retract(const refer_statement &a_refer_statement, term_t a_module_path);
+
+    // totals of sharing ground lists across the statements of referred files
+    const pool_statistics &refer_pool_statistics();
+
+    // totals of the cache of parsed modules
+    struct module_cache_statistics
+    {
+        // refers executed from the cache, and refers which parsed their file
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+
+        // source bytes which hits did not parse again. their sources are
+        //     still loaded, to place errors.
+        size_t m_bytes_saved = 0;
+
+        // source bytes of the modules kept now
+        size_t m_bytes_kept = 0;
+    };
+
+    module_cache_statistics refer_cache_statistics();
+
+    // drops every parsed module kept, so that the next refer of each file
+    //     parses it again. the statistics are kept.
+    void clear_refer_cache();
+
+    // the most source bytes whose parsed modules are kept. a file is kept
+    //     from the second time it is referred, and the least recently
+    //     referred are dropped first. 0 keeps none.
+    constexpr size_t DEFAULT_REFER_CACHE_LIMIT = 64 * 1024 * 1024;
+
+    void set_refer_cache_limit(size_t a_bytes);
+
+    // drops what refers keep from one statement to the next: the parsed
+    //     modules, the ground lists they share, and the paths resolved, which
+    //     links or renames may since have changed. called between top-level
+    //     executions, which need nothing of each other. the statistics are kept.
+    void clear_refer_state();
+
+    // how many threads parse each referred file. statements still execute
+    //     one at a time, in order. 1 (the default) parses on the executing
+    //     thread alone.
+    void set_parse_threads(size_t a_threads);
+
+    // the directory compiled modules of referred files are kept in, which
+    //     is created when first written. empty (the default) compiles
+    //     nothing, so that verifying never writes files of its own.
+    void set_module_cache_directory(const std::filesystem::path &a_directory);
+
+    // determines if anything is declared inside the module a refer would name
+    bool module_declared(const refer_statement &a_refer_statement, term_t a_module_path);
+
+    // totals of executing a stream
+    struct stream_statistics
+    {
+        size_t m_bytes = 0;
+        size_t m_statements = 0;
+        double m_seconds = 0;
+
+        // the most input that was buffered at once
+        size_t m_peak_buffered = 0;
+    };
+
+    // executes the statements read from a_fd (stdin, say) as they arrive.
+    //     only the statement being executed, and whatever was read past it,
+    //     are buffered. the term refs of each statement are released once it
+    //     has executed, so memory is bounded by the largest statement.
+    //     errors are reported as being in a_name.
+    stream_statistics execute_stream(int a_fd, const std::string &a_name, term_t a_module_path);
 }
 
 void wipe_database();
@@ -0,0 +1,555 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "json.hpp"
+#include "char_class.hpp"
+#include "err_msg.hpp"
+
+////////////////////////////////
+//// SERIALIZATION
+////////////////////////////////
+
+static void dump_string(std::string &a_out, const std::string &a_text)
+{
+    a_out.push_back('\"');
+
+    for (char l_char : a_text)
+    {
+        switch (l_char)
+        {
+        case '\"':
+            a_out += "\\\"";
+            break;
+        case '\\':
+            a_out += "\\\\";
+            break;
+        case '\n':
+            a_out += "\\n";
+            break;
+        case '\r':
+            a_out += "\\r";
+            break;
+        case '\t':
+            a_out += "\\t";
+            break;
+        default:
+        {
+            // remaining control chars must be escaped. utf-8 passes through.
+            if ((unsigned char)l_char < 0x20)
+            {
+                char l_escape[8];
+                std::snprintf(l_escape, sizeof(l_escape), "\\u%04x", (unsigned char)l_char);
+                a_out += l_escape;
+            }
+            else
+            {
+                a_out.push_back(l_char);
+            }
+        }
+        break;
+        }
+    }
+
+    a_out.push_back('\"');
+}
+
+static void dump_value(std::string &a_out, const unilog::json &a_value)
+{
+    if (a_value.is_null())
+    {
+        a_out += "null";
+    }
+    else if (a_value.is_bool())
+    {
+        a_out += a_value.as_bool() ? "true" : "false";
+    }
+    else if (a_value.is_number())
+    {
+        double l_number = a_value.as_number();
+
+        char l_text[32];
+
+        // integers (ids, line numbers, offsets) are written without a fraction
+        if (std::trunc(l_number) == l_number && std::fabs(l_number) < 9007199254740992.0)
+            std::snprintf(l_text, sizeof(l_text), "%lld", (long long)l_number);
+        else if (std::isfinite(l_number))
+            std::snprintf(l_text, sizeof(l_text), "%.17g", l_number);
+        else
+            std::snprintf(l_text, sizeof(l_text), "null");
+
+        a_out += l_text;
+    }
+    else if (a_value.is_string())
+    {
+        dump_string(a_out, a_value.as_string());
+    }
+    else if (a_value.is_array())
+    {
+        a_out.push_back('[');
+
+        for (const unilog::json &l_element : a_value.as_array())
+        {
+            if (a_out.back() != '[')
+                a_out.push_back(',');
+
+            dump_value(a_out, l_element);
+        }
+
+        a_out.push_back(']');
+    }
+    else
+    {
+        a_out.push_back('{');
+
+        for (const auto &[l_key, l_member] : a_value.as_object())
+        {
+            if (a_out.back() != '{')
+                a_out.push_back(',');
+
+            dump_string(a_out, l_key);
+            a_out.push_back(':');
+            dump_value(a_out, l_member);
+        }
+
+        a_out.push_back('}');
+    }
+}
+
+////////////////////////////////
+//// PARSING
+////////////////////////////////
+
+// recursive descent over the text. positions only ever move forward.
+struct json_parser
+{
+    const char *m_pos;
+    const char *m_end;
+
+    [[noreturn]] static void fail()
+    {
+        throw std::runtime_error(ERR_MSG_JSON_MALFORMED);
+    }
+
+    void skip_whitespace()
+    {
+        while (m_pos != m_end && unilog::is_whitespace(*m_pos))
+            ++m_pos;
+    }
+
+    void expect(char a_char)
+    {
+        skip_whitespace();
+
+        if (m_pos == m_end || *m_pos != a_char)
+            fail();
+
+        ++m_pos;
+    }
+
+    bool consume(char a_char)
+    {
+        skip_whitespace();
+
+        if (m_pos == m_end || *m_pos != a_char)
+            return false;
+
+        ++m_pos;
+        return true;
+    }
+
+    void expect_word(std::string_view a_word)
+    {
+        if (std::string_view(m_pos, m_end - m_pos).substr(0, a_word.size()) != a_word)
+            fail();
+
+        m_pos += a_word.size();
+    }
+
+    unsigned parse_hex4()
+    {
+        if (m_end - m_pos < 4)
+            fail();
+
+        unsigned l_result = 0;
+
+        for (int i = 0; i < 4; i++)
+        {
+            char l_char = *m_pos++;
+            unsigned l_digit;
+
+            if (l_char >= '0' && l_char <= '9')
+                l_digit = l_char - '0';
+            else if ((l_char | 0x20) >= 'a' && (l_char | 0x20) <= 'f')
+                l_digit = (l_char | 0x20) - 'a' + 10;
+            else
+                fail();
+
+            l_result = l_result << 4 | l_digit;
+        }
+
+        return l_result;
+    }
+
+    static void append_utf8(std::string &a_out, unsigned a_code_point)
+    {
+        if (a_code_point < 0x80)
+        {
+            a_out.push_back(a_code_point);
+        }
+        else if (a_code_point < 0x800)
+        {
+            a_out.push_back(0xC0 | a_code_point >> 6);
+            a_out.push_back(0x80 | (a_code_point & 0x3F));
+        }
+        else if (a_code_point < 0x10000)
+        {
+            a_out.push_back(0xE0 | a_code_point >> 12);
+            a_out.push_back(0x80 | (a_code_point >> 6 & 0x3F));
+            a_out.push_back(0x80 | (a_code_point & 0x3F));
+        }
+        else
+        {
+            a_out.push_back(0xF0 | a_code_point >> 18);
+            a_out.push_back(0x80 | (a_code_point >> 12 & 0x3F));
+            a_out.push_back(0x80 | (a_code_point >> 6 & 0x3F));
+            a_out.push_back(0x80 | (a_code_point & 0x3F));
+        }
+    }
+
+    std::string parse_string()
+    {
+        expect('\"');
+
+        std::string l_result;
+
+        for (;;)
+        {
+            if (m_pos == m_end)
+                fail();
+
+            char l_char = *m_pos++;
+
+            if (l_char == '\"')
+                return l_result;
+
+            if (l_char != '\\')
+            {
+                l_result.push_back(l_char);
+                continue;
+            }
+
+            if (m_pos == m_end)
+                fail();
+
+            switch (char l_escaped = *m_pos++)
+            {
+            case 'b':
+                l_result.push_back('\b');
+                break;
+            case 'f':
+                l_result.push_back('\f');
+                break;
+            case 'n':
+                l_result.push_back('\n');
+                break;
+            case 'r':
+                l_result.push_back('\r');
+                break;
+            case 't':
+                l_result.push_back('\t');
+                break;
+            case 'u':
+            {
+                unsigned l_code_point = parse_hex4();
+
+                // a surrogate pair encodes a code point above the basic plane
+                if (l_code_point >= 0xD800 && l_code_point < 0xDC00 && m_end - m_pos >= 6 && m_pos[0] == '\\' && m_pos[1] == 'u')
+                {
+                    m_pos += 2;
+                    unsigned l_low = parse_hex4();
+
+                    if (l_low < 0xDC00 || l_low >= 0xE000)
+                        fail();
+
+                    l_code_point = 0x10000 + ((l_code_point - 0xD800) << 10) + (l_low - 0xDC00);
+                }
+
+                append_utf8(l_result, l_code_point);
+            }
+            break;
+            default:
+            {
+                // \" \\ and \/ stand for themselves
+                if (l_escaped != '\"' && l_escaped != '\\' && l_escaped != '/')
+                    fail();
+
+                l_result.push_back(l_escaped);
+            }
+            break;
+            }
+        }
+    }
+
+    double parse_number()
+    {
+        const char *l_begin = m_pos;
+
+        while (m_pos != m_end && (unilog::is_identifier(*m_pos) || *m_pos == '-' || *m_pos == '+' || *m_pos == '.'))
+            ++m_pos;
+
+        std::string l_text(l_begin, m_pos);
+
+        char *l_parsed_end;
+        double l_result = std::strtod(l_text.c_str(), &l_parsed_end);
+
+        if (l_text.empty() || l_parsed_end != l_text.c_str() + l_text.size())
+            fail();
+
+        return l_result;
+    }
+
+    unilog::json parse_value()
+    {
+        skip_whitespace();
+
+        if (m_pos == m_end)
+            fail();
+
+        switch (*m_pos)
+        {
+        case 'n':
+            expect_word("null");
+            return nullptr;
+        case 't':
+            expect_word("true");
+            return true;
+        case 'f':
+            expect_word("false");
+            return false;
+        case '\"':
+            return parse_string();
+        case '[':
+        {
+            ++m_pos;
+
+            unilog::json::array l_result;
+
+            if (consume(']'))
+                return l_result;
+
+            do
+                l_result.push_back(parse_value());
+            while (consume(','));
+
+            expect(']');
+
+            return l_result;
+        }
+        case '{':
+        {
+            ++m_pos;
+
+            unilog::json::object l_result;
+
+            if (consume('}'))
+                return l_result;
+
+            do
+            {
+                std::string l_key = parse_string();
+                expect(':');
+                l_result[std::move(l_key)] = parse_value();
+            } while (consume(','));
+
+            expect('}');
+
+            return l_result;
+        }
+        default:
+            return parse_number();
+        }
+    }
+};
+
+namespace unilog
+{
+
+    bool json::as_bool() const
+    {
+        if (!is_bool())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<bool>(m_value);
+    }
+
+    double json::as_number() const
+    {
+        if (!is_number())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<double>(m_value);
+    }
+
+    const std::string &json::as_string() const
+    {
+        if (!is_string())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<std::string>(m_value);
+    }
+
+    const json::array &json::as_array() const
+    {
+        if (!is_array())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<array>(m_value);
+    }
+
+    const json::object &json::as_object() const
+    {
+        if (!is_object())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<object>(m_value);
+    }
+
+    const json &json::operator[](const std::string &a_key) const
+    {
+        static const json s_null;
+
+        if (!is_object())
+            return s_null;
+
+        const object &l_object = std::get<object>(m_value);
+
+        auto l_member = l_object.find(a_key);
+
+        return l_member == l_object.end() ? s_null : l_member->second;
+    }
+
+    json &json::operator[](const std::string &a_key)
+    {
+        if (is_null())
+            m_value = object();
+
+        if (!is_object())
+            throw std::runtime_error(ERR_MSG_JSON_TYPE);
+
+        return std::get<object>(m_value)[a_key];
+    }
+
+    std::string json::dump() const
+    {
+        std::string l_result;
+        dump_value(l_result, *this);
+        return l_result;
+    }
+
+    json json::parse(std::string_view a_text)
+    {
+        json_parser l_parser{a_text.data(), a_text.data() + a_text.size()};
+
+        json l_result = l_parser.parse_value();
+
+        // nothing but whitespace may follow the value
+        l_parser.skip_whitespace();
+
+        if (l_parser.m_pos != l_parser.m_end)
+            json_parser::fail();
+
+        return l_result;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include "test_utils.hpp"
+
+static void test_json_parse()
+{
+    using unilog::json;
+
+    json l_value = json::parse(R"( {"jsonrpc": "2.0", "id": 3, "params": {"list": [1, -2.5, 1e3, true, false, null, "x"]}} )");
+
+    assert(l_value["jsonrpc"] == "2.0");
+    assert(l_value["id"].as_number() == 3);
+    assert(l_value["missing"].is_null());
+    assert(l_value["params"]["missing"]["deeper"].is_null());
+
+    const json::array &l_list = l_value["params"]["list"].as_array();
+
+    assert(l_list.size() == 7);
+    assert(l_list[0] == 1);
+    assert(l_list[1] == -2.5);
+    assert(l_list[2] == 1000);
+    assert(l_list[3] == true);
+    assert(l_list[4] == false);
+    assert(l_list[5].is_null());
+    assert(l_list[6] == "x");
+
+    // string escapes, including surrogate pairs
+    assert(json::parse(R"("a\"b\\c\/d\n\t\u0041\u00e9\ud83d\ude00")") == "a\"b\\c/d\n\tA\xC3\xA9\xF0\x9F\x98\x80");
+
+    assert(json::parse("[]").as_array().empty());
+    assert(json::parse("{}").as_object().empty());
+}
+
+static void test_json_parse_malformed()
+{
+    data_points<std::string, std::string> l_data_points =
+        {
+            {"", ERR_MSG_JSON_MALFORMED},
+            {"{", ERR_MSG_JSON_MALFORMED},
+            {"[1,]", ERR_MSG_JSON_MALFORMED},
+            {"{\"a\" 1}", ERR_MSG_JSON_MALFORMED},
+            {"\"abc", ERR_MSG_JSON_MALFORMED},
+            {"\"\\q\"", ERR_MSG_JSON_MALFORMED},
+            {"nul", ERR_MSG_JSON_MALFORMED},
+            {"1 2", ERR_MSG_JSON_MALFORMED},
+            {"--1", ERR_MSG_JSON_MALFORMED},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        try
+        {
+            unilog::json::parse(l_key);
+            throw std::runtime_error("Failed test case: expected throw");
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            assert(l_err.what() == l_value);
+        }
+    }
+}
+
+static void test_json_dump()
+{
+    using unilog::json;
+
+    json l_value;
+    l_value["b"] = json::array{1, 2.5, "x\"\n\x01", nullptr, false};
+    l_value["a"] = json::object{};
+    l_value["c"]["d"] = -3;
+
+    // object keys are sorted, integers have no fraction
+    assert(l_value.dump() == R"({"a":{},"b":[1,2.5,"x\"\n\u0001",null,false],"c":{"d":-3}})");
+
+    // dumping round-trips
+    assert(json::parse(l_value.dump()) == l_value);
+}
+
+void test_json_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_json_parse);
+    TEST(test_json_parse_malformed);
+    TEST(test_json_dump);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+
+namespace unilog
+{
+
+    // a JSON value. just enough of JSON for the language server protocol:
+    //     numbers are doubles, and objects keep their keys sorted.
+    class json
+    {
+    public:
+        using array = std::vector<json>;
+        using object = std::map<std::string, json>;
+
+    private:
+        std::variant<std::nullptr_t, bool, double, std::string, array, object> m_value;
+
+    public:
+        json() : m_value(nullptr) {}
+        json(std::nullptr_t) : m_value(nullptr) {}
+        json(bool a_value) : m_value(a_value) {}
+        json(const char *a_value) : m_value(std::string(a_value)) {}
+        json(std::string_view a_value) : m_value(std::string(a_value)) {}
+        json(std::string a_value) : m_value(std::move(a_value)) {}
+        json(array a_value) : m_value(std::move(a_value)) {}
+        json(object a_value) : m_value(std::move(a_value)) {}
+
+        template <typename Number>
+            requires(std::is_arithmetic_v<Number> && !std::is_same_v<Number, bool>)
+        json(Number a_value) : m_value(static_cast<double>(a_value))
+        {
+        }
+
+        bool is_null() const { return std::holds_alternative<std::nullptr_t>(m_value); }
+        bool is_bool() const { return std::holds_alternative<bool>(m_value); }
+        bool is_number() const { return std::holds_alternative<double>(m_value); }
+        bool is_string() const { return std::holds_alternative<std::string>(m_value); }
+        bool is_array() const { return std::holds_alternative<array>(m_value); }
+        bool is_object() const { return std::holds_alternative<object>(m_value); }
+
+        // these throw if the value has another type
+        bool as_bool() const;
+        double as_number() const;
+        const std::string &as_string() const;
+        const array &as_array() const;
+        const object &as_object() const;
+
+        // member of an object, or null if there is no such member
+        const json &operator[](const std::string &a_key) const;
+
+        // member of an object, inserted if missing. a null value becomes an object.
+        json &operator[](const std::string &a_key);
+
+        bool operator==(const json &a_rhs) const = default;
+
+        // compact serialization, without any whitespace
+        std::string dump() const;
+
+        // throws if a_text is not exactly one JSON value
+        static json parse(std::string_view a_text);
+    };
+
+}
+
+#endif
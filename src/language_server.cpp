@@ -0,0 +1,1004 @@
+#include <filesystem>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <cctype>
+#include <stdexcept>
+#include <SWI-Prolog.h>
+
+#include "language_server.hpp"
+#include "document.hpp"
+#include "executor.hpp"
+#include "json.hpp"
+#include "err_msg.hpp"
+
+// json-rpc error codes
+#define LSP_PARSE_ERROR -32700
+#define LSP_INVALID_REQUEST -32600
+#define LSP_METHOD_NOT_FOUND -32601
+
+////////////////////////////////
+//// MESSAGE FRAMING
+////////////////////////////////
+
+// reads the next message, or returns false at the end of the input
+static bool read_message(std::istream &a_input, std::string &a_content)
+{
+    size_t l_content_length = 0;
+    bool l_has_content_length = false;
+
+    /////////////////////////////////////////
+    // headers, up to an empty line
+    /////////////////////////////////////////
+    for (std::string l_line; std::getline(a_input, l_line);)
+    {
+        if (l_line.ends_with('\r'))
+            l_line.pop_back();
+
+        if (l_line.empty())
+        {
+            if (!l_has_content_length)
+                throw std::runtime_error(ERR_MSG_LSP_HEADER);
+
+            a_content.resize(l_content_length);
+
+            if (!a_input.read(a_content.data(), l_content_length))
+                throw std::runtime_error(ERR_MSG_LSP_HEADER);
+
+            return true;
+        }
+
+        static const std::string s_content_length = "Content-Length:";
+
+        /////////////////////////////////////////
+        // after a malformed header, the content it framed is read as a
+        //     header line, and the next message follows it on that line
+        /////////////////////////////////////////
+        size_t l_header = l_line.find(s_content_length);
+
+        if (l_header != std::string::npos)
+        {
+            // a bad length is reported at the end of the headers, once they are all read
+            try
+            {
+                l_content_length = std::stoull(l_line.substr(l_header + s_content_length.size()));
+                l_has_content_length = true;
+            }
+            catch (const std::logic_error &)
+            {
+                l_has_content_length = false;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void write_message(std::ostream &a_output, const unilog::json &a_message)
+{
+    std::string l_content = a_message.dump();
+
+    a_output << "Content-Length: " << l_content.size() << "\r\n\r\n"
+             << l_content;
+
+    a_output.flush();
+}
+
+static void write_error(std::ostream &a_output, const unilog::json &a_id, int a_code, const std::string &a_message)
+{
+    write_message(a_output, unilog::json::object{
+                                {"jsonrpc", "2.0"},
+                                {"id", a_id},
+                                {"error", unilog::json::object{
+                                              {"code", a_code},
+                                              {"message", a_message},
+                                          }},
+                            });
+}
+
+////////////////////////////////
+//// DOCUMENTS
+////////////////////////////////
+
+// decodes the path of a file:// uri. other uris have no path.
+static std::filesystem::path uri_path(const std::string &a_uri)
+{
+    static const std::string s_scheme = "file://";
+
+    if (!a_uri.starts_with(s_scheme))
+        return {};
+
+    std::string l_result;
+
+    for (size_t i = s_scheme.size(); i < a_uri.size(); i++)
+    {
+        if (a_uri[i] == '%' && i + 2 < a_uri.size() &&
+            std::isxdigit((unsigned char)a_uri[i + 1]) && std::isxdigit((unsigned char)a_uri[i + 2]))
+        {
+            l_result.push_back((char)std::stoi(a_uri.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        else
+            l_result.push_back(a_uri[i]);
+    }
+
+    return l_result;
+}
+
+// atoms of tags, or every tag at once
+struct tag_set
+{
+    std::set<unilog::symbol> m_atoms;
+    bool m_all = false;
+
+    bool empty() const { return !m_all && m_atoms.empty(); }
+
+    // adds the atoms of a tag, or every tag if it has a variable in it
+    void insert(const std::vector<unilog::symbol> &a_atoms, bool a_open)
+    {
+        m_atoms.insert(a_atoms.begin(), a_atoms.end());
+        m_all = m_all || a_open;
+    }
+
+    // whether a tag made of a_atoms, or any tag if a_open, may be in the set
+    bool meets(const std::vector<unilog::symbol> &a_atoms, bool a_open) const
+    {
+        if (empty())
+            return false;
+
+        if (a_open)
+            return true;
+
+        if (m_all)
+            return !a_atoms.empty();
+
+        return std::any_of(a_atoms.begin(), a_atoms.end(), [this](unilog::symbol a_atom)
+                           { return m_atoms.contains(a_atom); });
+    }
+};
+
+struct open_document
+{
+    unilog::document m_document;
+
+    // refers are resolved from the directory of the document
+    std::filesystem::path m_directory;
+};
+
+class language_server
+{
+private:
+    std::ostream &m_output;
+    std::map<std::string, open_document> m_documents;
+    bool m_shutdown = false;
+
+    // statements executed, over all documents
+    size_t m_executed_statements = 0;
+
+    // each document is its own module, named by its uri
+    static term_t module_path(const std::string &a_uri)
+    {
+        return make_list({make_atom(a_uri)});
+    }
+
+    void retract_statement(const unilog::document_statement &a_statement, term_t a_module_path)
+    {
+        if (!a_statement.m_declared)
+            return;
+
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::lexer l_lexer(a_statement.m_text);
+        unilog::statement l_statement;
+
+        // it was executed, so it parses
+        if (l_lexer >> l_statement)
+            std::visit([a_module_path](const auto &a_statement)
+                       { unilog::retract(a_statement, a_module_path); }, l_statement);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    // executes a statement of a document in a_directory, which its refers are relative to
+    void execute_statement(unilog::document_statement &a_statement, term_t a_module_path, const std::filesystem::path &a_directory)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        a_statement.m_executed = true;
+        a_statement.m_declared = false;
+        a_statement.m_diagnostic.clear();
+
+        unilog::lexer l_lexer(a_statement.m_text);
+        unilog::statement l_statement;
+
+        /////////////////////////////////////////
+        // parse errors are placed where the lexer stopped
+        /////////////////////////////////////////
+        try
+        {
+            if (!(l_lexer >> l_statement))
+            {
+                // only whitespace and comments
+                PL_discard_foreign_frame(l_frame);
+                return;
+            }
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            a_statement.m_diagnostic = l_err.what();
+            a_statement.m_diagnostic_begin = std::min(l_lexer.tell(), a_statement.m_text.size());
+            a_statement.m_diagnostic_end = std::min(a_statement.m_diagnostic_begin + 1, a_statement.m_text.size());
+
+            PL_discard_foreign_frame(l_frame);
+            return;
+        }
+
+        /////////////////////////////////////////
+        // execution errors cover the statement, from its command through its ';'
+        /////////////////////////////////////////
+        const unilog::refer_statement *l_refer = std::get_if<unilog::refer_statement>(&l_statement);
+
+        bool l_module_declared_before = l_refer && unilog::module_declared(*l_refer, a_module_path);
+
+        ++m_executed_statements;
+
+        try
+        {
+            unilog::execute(l_statement, a_module_path, a_directory);
+
+            a_statement.m_declared = true;
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            a_statement.m_diagnostic = l_err.what();
+            a_statement.m_diagnostic_begin = get_span(l_statement).m_begin;
+            a_statement.m_diagnostic_end = get_span(l_statement).m_end;
+        }
+
+        /////////////////////////////////////////
+        // a refer may fail part way, having declared some of the module
+        /////////////////////////////////////////
+        if (l_refer)
+            a_statement.m_declared = !l_module_declared_before && unilog::module_declared(*l_refer, a_module_path);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    // brings the declarations of a document up to date with an edit of it
+    void update(const std::string &a_uri, open_document &a_open_document, const unilog::document_edit &a_edit)
+    {
+        std::vector<unilog::document_statement> &l_statements = a_open_document.m_document.statements();
+
+        fid_t l_frame = PL_open_foreign_frame();
+
+        term_t l_module_path = module_path(a_uri);
+
+        /////////////////////////////////////////
+        // tags which may now be declared differently
+        /////////////////////////////////////////
+        tag_set l_dirty;
+
+        for (size_t i = 0; i < a_edit.m_removed.size(); i++)
+        {
+            // a statement carried over verbatim still declares what it did
+            if (!a_edit.m_kept[i])
+                l_dirty.insert(a_edit.m_removed[i].m_tag_atoms, a_edit.m_removed[i].m_open_tag);
+        }
+
+        /////////////////////////////////////////
+        // statements before the edit were executed before everything after
+        //     them, so only statements from the edit on are affected. one is
+        //     affected if it changed, or may see a dirty tag, by querying it
+        //     or by declaring it. its own tag becomes dirty in turn.
+        //
+        // an affected statement is executed again against the declarations
+        //     before it only, so a later statement which declared a tag it
+        //     may see is affected too, and retracted before it runs.
+        /////////////////////////////////////////
+        tag_set l_wanted;
+
+        std::vector<size_t> l_affected;
+
+        for (size_t i = a_edit.m_first; i < l_statements.size(); i++)
+        {
+            // past the replacements, only dirty or wanted tags affect a statement
+            if (i >= a_edit.m_first + a_edit.m_count && l_dirty.empty() && l_wanted.empty())
+                break;
+
+            const unilog::document_statement &l_statement = l_statements[i];
+
+            bool l_changed = !l_statement.m_executed ||
+                             l_dirty.meets(l_statement.m_mentioned, l_statement.m_open_mentions) ||
+                             l_dirty.meets(l_statement.m_tag_atoms, l_statement.m_open_tag) ||
+                             (l_statement.m_declared && l_wanted.meets(l_statement.m_tag_atoms, l_statement.m_open_tag));
+
+            if (!l_changed)
+                continue;
+
+            l_affected.push_back(i);
+
+            l_dirty.insert(l_statement.m_tag_atoms, l_statement.m_open_tag);
+            l_wanted.insert(l_statement.m_tag_atoms, l_statement.m_open_tag);
+            l_wanted.insert(l_statement.m_mentioned, l_statement.m_open_mentions);
+        }
+
+        /////////////////////////////////////////
+        // retract what the replaced and affected statements declared. the
+        //     declarations of a statement carried over now belong to its
+        //     replacement, which retracts them only if it is affected.
+        /////////////////////////////////////////
+        for (size_t i = 0; i < a_edit.m_removed.size(); i++)
+            if (!a_edit.m_kept[i])
+                retract_statement(a_edit.m_removed[i], l_module_path);
+
+        for (size_t l_index : l_affected)
+        {
+            retract_statement(l_statements[l_index], l_module_path);
+            l_statements[l_index].m_declared = false;
+        }
+
+        /////////////////////////////////////////
+        // then execute the affected statements, in order, from the document's directory
+        /////////////////////////////////////////
+        for (size_t l_index : l_affected)
+            execute_statement(l_statements[l_index], l_module_path, a_open_document.m_directory);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    void publish_diagnostics(const std::string &a_uri, const unilog::document *a_document)
+    {
+        unilog::json::array l_diagnostics;
+
+        auto l_position = [a_document](size_t a_offset)
+        {
+            auto [l_line, l_character] = a_document->position(a_offset);
+            return unilog::json::object{{"line", l_line}, {"character", l_character}};
+        };
+
+        if (a_document)
+        {
+            for (const unilog::document_statement &l_statement : a_document->statements())
+            {
+                if (l_statement.m_diagnostic.empty())
+                    continue;
+
+                l_diagnostics.push_back(unilog::json::object{
+                    {"range", unilog::json::object{
+                                  {"start", l_position(l_statement.m_begin + l_statement.m_diagnostic_begin)},
+                                  {"end", l_position(l_statement.m_begin + l_statement.m_diagnostic_end)},
+                              }},
+                    {"severity", 1},
+                    {"source", "uni"},
+                    {"message", l_statement.m_diagnostic},
+                });
+            }
+        }
+
+        write_message(m_output, unilog::json::object{
+                                    {"jsonrpc", "2.0"},
+                                    {"method", "textDocument/publishDiagnostics"},
+                                    {"params", unilog::json::object{
+                                                   {"uri", a_uri},
+                                                   {"diagnostics", l_diagnostics},
+                                               }},
+                                });
+    }
+
+    void did_open(const unilog::json &a_params)
+    {
+        const std::string &l_uri = a_params["textDocument"]["uri"].as_string();
+        const std::string &l_text = a_params["textDocument"]["text"].as_string();
+
+        close(l_uri);
+
+        open_document &l_open_document = m_documents[l_uri];
+        l_open_document.m_directory = uri_path(l_uri).parent_path();
+
+        /////////////////////////////////////////
+        // opening is an edit which inserts the whole text
+        /////////////////////////////////////////
+        unilog::document_edit l_edit = l_open_document.m_document.edit(0, 0, l_text);
+
+        update(l_uri, l_open_document, l_edit);
+
+        publish_diagnostics(l_uri, &l_open_document.m_document);
+    }
+
+    void did_change(const unilog::json &a_params)
+    {
+        const std::string &l_uri = a_params["textDocument"]["uri"].as_string();
+
+        auto l_it = m_documents.find(l_uri);
+
+        if (l_it == m_documents.end())
+            return;
+
+        unilog::document &l_document = l_it->second.m_document;
+
+        for (const unilog::json &l_change : a_params["contentChanges"].as_array())
+        {
+            const unilog::json &l_range = l_change["range"];
+
+            size_t l_begin = 0;
+            size_t l_end = l_document.text().size();
+
+            // without a range, the change replaces the whole text
+            if (!l_range.is_null())
+            {
+                l_begin = l_document.offset((size_t)l_range["start"]["line"].as_number(), (size_t)l_range["start"]["character"].as_number());
+                l_end = l_document.offset((size_t)l_range["end"]["line"].as_number(), (size_t)l_range["end"]["character"].as_number());
+            }
+
+            unilog::document_edit l_edit = l_document.edit(l_begin, l_end, l_change["text"].as_string());
+
+            update(l_uri, l_it->second, l_edit);
+        }
+
+        publish_diagnostics(l_uri, &l_document);
+    }
+
+    void did_close(const unilog::json &a_params)
+    {
+        const std::string &l_uri = a_params["textDocument"]["uri"].as_string();
+
+        close(l_uri);
+
+        publish_diagnostics(l_uri, nullptr);
+    }
+
+    // retracts everything the document declared
+    void close(const std::string &a_uri)
+    {
+        auto l_it = m_documents.find(a_uri);
+
+        if (l_it == m_documents.end())
+            return;
+
+        fid_t l_frame = PL_open_foreign_frame();
+
+        term_t l_module_path = module_path(a_uri);
+
+        for (const unilog::document_statement &l_statement : l_it->second.m_document.statements())
+            retract_statement(l_statement, l_module_path);
+
+        PL_discard_foreign_frame(l_frame);
+
+        m_documents.erase(l_it);
+
+        // what refers kept is rebuilt as documents refer again
+        unilog::clear_refer_state();
+    }
+
+    void respond(const unilog::json &a_id, unilog::json a_result)
+    {
+        write_message(m_output, unilog::json::object{
+                                    {"jsonrpc", "2.0"},
+                                    {"id", a_id},
+                                    {"result", std::move(a_result)},
+                                });
+    }
+
+    void respond_error(const unilog::json &a_id, int a_code, const std::string &a_message)
+    {
+        write_error(m_output, a_id, a_code, a_message);
+    }
+
+    bool dispatch(const unilog::json &a_message)
+    {
+        const std::string &l_method = a_message["method"].as_string();
+        const unilog::json &l_id = a_message["id"];
+        const unilog::json &l_params = a_message["params"];
+
+        if (l_method == "initialize")
+        {
+            // documents are synced incrementally
+            respond(l_id, unilog::json::object{
+                              {"capabilities", unilog::json::object{
+                                                   {"textDocumentSync", unilog::json::object{
+                                                                            {"openClose", true},
+                                                                            {"change", 2},
+                                                                        }},
+                                               }},
+                              {"serverInfo", unilog::json::object{{"name", "uni"}}},
+                          });
+        }
+        else if (l_method == "shutdown")
+        {
+            m_shutdown = true;
+            respond(l_id, nullptr);
+        }
+        else if (l_method == "exit")
+            return false;
+        else if (l_method == "textDocument/didOpen")
+            did_open(l_params);
+        else if (l_method == "textDocument/didChange")
+            did_change(l_params);
+        else if (l_method == "textDocument/didClose")
+            did_close(l_params);
+        else if (!l_id.is_null())
+            respond_error(l_id, LSP_METHOD_NOT_FOUND, "unknown method: " + l_method);
+
+        // other notifications are ignored
+
+        return true;
+    }
+
+public:
+    explicit language_server(std::ostream &a_output) : m_output(a_output) {}
+
+    // handles one message. returns false once the client asks to exit.
+    bool handle(const unilog::json &a_message)
+    {
+        try
+        {
+            return dispatch(a_message);
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            // a malformed request is answered, and a malformed notification dropped
+            if (!a_message["id"].is_null())
+                respond_error(a_message["id"], LSP_INVALID_REQUEST, l_err.what());
+
+            return true;
+        }
+    }
+
+    bool shutdown() const { return m_shutdown; }
+
+    size_t executed_statements() const { return m_executed_statements; }
+};
+
+namespace unilog
+{
+
+    int run_language_server(std::istream &a_input, std::ostream &a_output)
+    {
+        language_server l_server(a_output);
+
+        for (;;)
+        {
+            std::string l_content;
+            json l_message;
+
+            /////////////////////////////////////////
+            // a message which cannot be framed or parsed has no id to
+            //     answer, so the error is reported against none
+            /////////////////////////////////////////
+            try
+            {
+                if (!read_message(a_input, l_content))
+                    break;
+
+                l_message = json::parse(l_content);
+            }
+            catch (const std::exception &l_err)
+            {
+                write_error(a_output, nullptr, LSP_PARSE_ERROR, l_err.what());
+                continue;
+            }
+
+            if (!l_server.handle(l_message))
+                return l_server.shutdown() ? 0 : 1;
+        }
+
+        // the input ended without an exit
+        return 1;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <sstream>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+static std::string frame_message(const unilog::json &a_message)
+{
+    std::string l_content = a_message.dump();
+    return "Content-Length: " + std::to_string(l_content.size()) + "\r\n\r\n" + l_content;
+}
+
+static std::vector<unilog::json> read_messages(std::istream &a_input)
+{
+    std::vector<unilog::json> l_result;
+
+    for (std::string l_content; read_message(a_input, l_content);)
+        l_result.push_back(unilog::json::parse(l_content));
+
+    return l_result;
+}
+
+static unilog::json did_change(const std::string &a_uri, size_t a_line, size_t a_begin, size_t a_end, const std::string &a_text)
+{
+    using unilog::json;
+
+    auto l_position = [a_line](size_t a_character)
+    { return json::object{{"line", a_line}, {"character", a_character}}; };
+
+    return json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didChange"},
+        {"params", json::object{
+                       {"textDocument", json::object{{"uri", a_uri}, {"version", 2}}},
+                       {"contentChanges", json::array{json::object{
+                                              {"range", json::object{{"start", l_position(a_begin)}, {"end", l_position(a_end)}}},
+                                              {"text", a_text},
+                                          }}},
+                   }},
+    };
+}
+
+////////////////////////////////
+////////////////////////////////
+
+static void test_read_message()
+{
+    std::stringstream l_input("Content-Length: 2\r\nContent-Type: x\r\n\r\n{}Content-Length: 4\r\n\r\nnull");
+
+    std::string l_content;
+
+    assert(read_message(l_input, l_content) && l_content == "{}");
+    assert(read_message(l_input, l_content) && l_content == "null");
+    assert(!read_message(l_input, l_content));
+
+    std::stringstream l_no_length("Content-Type: x\r\n\r\n{}");
+
+    try
+    {
+        read_message(l_no_length, l_content);
+        assert(false);
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        assert(l_err.what() == std::string(ERR_MSG_LSP_HEADER));
+    }
+}
+
+static void test_language_server_session()
+{
+    using unilog::json;
+
+    const std::string l_uri = "file:///tmp/unilog_lsp_test.u";
+
+    std::stringstream l_input;
+    std::stringstream l_output;
+
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "initialize"}, {"params", json::object{}}});
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"method", "initialized"}, {"params", json::object{}}});
+
+    /////////////////////////////////////////
+    // the inference fails, since a1 is not declared yet
+    /////////////////////////////////////////
+    l_input << frame_message(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{
+                       {"textDocument", json::object{
+                                            {"uri", l_uri},
+                                            {"languageId", "unilog"},
+                                            {"version", 1},
+                                            {"text", "axiom a0 [if y x];\naxiom a2 x;\ninfer i0 [mp [t a0] [t a1]];\n"},
+                                        }},
+                   }},
+    });
+
+    // rename a2 to a1, which the inference depends on
+    l_input << frame_message(did_change(l_uri, 1, 7, 8, "1"));
+
+    // break the first statement's syntax
+    l_input << frame_message(did_change(l_uri, 0, 9, 10, ""));
+
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"id", 2}, {"method", "unknown/method"}});
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"id", 3}, {"method", "shutdown"}});
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"method", "exit"}});
+
+    assert(unilog::run_language_server(l_input, l_output) == 0);
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 6);
+
+    /////////////////////////////////////////
+    // initialize
+    /////////////////////////////////////////
+    assert(l_messages[0]["id"] == json(1));
+    assert(l_messages[0]["result"]["capabilities"]["textDocumentSync"]["change"] == json(2));
+
+    /////////////////////////////////////////
+    // open: one diagnostic, on the inference
+    /////////////////////////////////////////
+    const json::array &l_opened = l_messages[1]["params"]["diagnostics"].as_array();
+
+    assert(l_messages[1]["method"] == json("textDocument/publishDiagnostics"));
+    assert(l_opened.size() == 1);
+    assert(l_opened[0]["message"] == json(ERR_MSG_INFER));
+    assert(l_opened[0]["range"]["start"] == json(json::object{{"line", 2}, {"character", 0}}));
+    assert(l_opened[0]["range"]["end"] == json(json::object{{"line", 2}, {"character", 28}}));
+
+    /////////////////////////////////////////
+    // once a1 is declared, the inference is re-executed and succeeds
+    /////////////////////////////////////////
+    assert(l_messages[2]["params"]["diagnostics"].as_array().empty());
+
+    /////////////////////////////////////////
+    // the syntax error is placed where the lexer stopped, and the
+    //     inference fails again since a0 is retracted
+    /////////////////////////////////////////
+    const json::array &l_broken = l_messages[3]["params"]["diagnostics"].as_array();
+
+    assert(l_broken.size() == 2);
+    assert(l_broken[0]["message"] != json(ERR_MSG_INFER));
+    assert(l_broken[0]["range"]["start"]["line"] == json(0));
+    assert(l_broken[0]["range"]["start"]["character"].as_number() > 8);
+    assert(l_broken[1]["message"] == json(ERR_MSG_INFER));
+
+    /////////////////////////////////////////
+    // unknown requests are errors, and shutdown is acknowledged
+    /////////////////////////////////////////
+    assert(l_messages[4]["id"] == json(2));
+    assert(l_messages[4]["error"]["code"] == json(LSP_METHOD_NOT_FOUND));
+    assert(l_messages[5]["id"] == json(3));
+    assert(l_messages[5]["result"].is_null());
+
+    wipe_database();
+}
+
+static void test_language_server_close_retracts()
+{
+    using unilog::json;
+
+    const std::string l_uri = "file:///tmp/unilog_lsp_test.u";
+
+    std::stringstream l_input;
+    std::stringstream l_output;
+
+    l_input << frame_message(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", "axiom a0 x;"}}}}},
+    });
+
+    // reopening executes the document again, which would fail were a0 still declared
+    l_input << frame_message(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didClose"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}}}}},
+    });
+
+    l_input << frame_message(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", "axiom a0 x;"}}}}},
+    });
+
+    // the input ends without an exit
+    assert(unilog::run_language_server(l_input, l_output) == 1);
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 3);
+
+    for (const json &l_message : l_messages)
+        assert(l_message["params"]["diagnostics"].as_array().empty());
+
+    wipe_database();
+}
+
+static void test_language_server_whitespace_edit()
+{
+    using unilog::json;
+
+    const std::string l_uri = "file:///tmp/unilog_lsp_test.u";
+
+    std::stringstream l_output;
+    language_server l_server(l_output);
+
+    l_server.handle(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", "axiom a0 [if y x];\naxiom a1 x;\ninfer i0 [mp [t a0] [t a1]];\n"}}}}},
+    });
+
+    assert(l_server.executed_statements() == 3);
+
+    /////////////////////////////////////////
+    // whitespace inside a statement, and a comment before one, re-execute nothing
+    /////////////////////////////////////////
+    l_server.handle(did_change(l_uri, 0, 5, 5, "  "));
+    l_server.handle(did_change(l_uri, 1, 11, 11, " # note"));
+
+    assert(l_server.executed_statements() == 3);
+
+    /////////////////////////////////////////
+    // a changed statement is re-executed, with those mentioning its tag,
+    //     and the inference now fails
+    /////////////////////////////////////////
+    l_server.handle(did_change(l_uri, 1, 9, 10, "z"));
+
+    assert(l_server.executed_statements() == 5);
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 4);
+
+    for (size_t i = 0; i < 3; i++)
+        assert(l_messages[i]["params"]["diagnostics"].as_array().empty());
+
+    assert(l_messages[3]["params"]["diagnostics"].as_array().size() == 1);
+    assert(l_messages[3]["params"]["diagnostics"].as_array()[0]["message"] == json(ERR_MSG_INFER));
+
+    /////////////////////////////////////////
+    // a statement which failed for its tag being taken is re-executed once
+    //     the tag is free
+    /////////////////////////////////////////
+    l_output.str("");
+    l_output.clear();
+
+    l_server.handle(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", "axiom b0 x;\naxiom b0 y;\n"}}}}},
+    });
+
+    l_server.handle(did_change(l_uri, 0, 7, 8, "1"));
+
+    l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 2);
+    assert(l_messages[0]["params"]["diagnostics"].as_array().size() == 1);
+    assert(l_messages[1]["params"]["diagnostics"].as_array().empty());
+
+    wipe_database();
+}
+
+static void test_language_server_list_tag()
+{
+    using unilog::json;
+
+    const std::string l_uri = "file:///tmp/unilog_lsp_test.u";
+
+    std::stringstream l_output;
+    language_server l_server(l_output);
+
+    l_server.handle(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", "axiom a0 [if y x];\naxiom a1 x;\nredir [r0 s0] [t a0];\ninfer i0 [mp [r [r0 s0]] [t a1]];\n"}}}}},
+    });
+
+    assert(l_server.executed_statements() == 4);
+
+    /////////////////////////////////////////
+    // changing an atom within a list-valued tag re-executes the inference
+    //     which mentions it
+    /////////////////////////////////////////
+    l_server.handle(did_change(l_uri, 2, 10, 12, "t0"));
+
+    assert(l_server.executed_statements() == 6);
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 2);
+    assert(l_messages[0]["params"]["diagnostics"].as_array().empty());
+    assert(l_messages[1]["params"]["diagnostics"].as_array().size() == 1);
+    assert(l_messages[1]["params"]["diagnostics"].as_array()[0]["message"] == json(ERR_MSG_INFER));
+
+    wipe_database();
+}
+
+static void test_language_server_document_order()
+{
+    using unilog::json;
+
+    const std::string l_uri = "file:///tmp/unilog_lsp_test.u";
+
+    std::stringstream l_output;
+    language_server l_server(l_output);
+
+    auto l_open = [&l_server, &l_uri](const std::string &a_text)
+    {
+        l_server.handle(json::object{
+            {"jsonrpc", "2.0"},
+            {"method", "textDocument/didOpen"},
+            {"params", json::object{{"textDocument", json::object{{"uri", l_uri}, {"text", a_text}}}}},
+        });
+    };
+
+    /////////////////////////////////////////
+    // an edited statement does not see what is declared after it
+    /////////////////////////////////////////
+    l_open("infer i0 [mp [t a0] [t a1]];\naxiom a0 [if y x];\naxiom a1 x;\n");
+
+    l_server.handle(did_change(l_uri, 0, 6, 8, "i1"));
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 2);
+
+    for (const json &l_message : l_messages)
+    {
+        const json::array &l_diagnostics = l_message["params"]["diagnostics"].as_array();
+
+        assert(l_diagnostics.size() == 1);
+        assert(l_diagnostics[0]["message"] == json(ERR_MSG_INFER));
+        assert(l_diagnostics[0]["range"]["start"]["line"] == json(0));
+    }
+
+    /////////////////////////////////////////
+    // a tag declared twice is an error of the later statement, even when
+    //     the earlier one is edited to declare it
+    /////////////////////////////////////////
+    l_output.str("");
+    l_output.clear();
+
+    l_open("axiom b1 x;\naxiom b0 y;\n");
+
+    l_server.handle(did_change(l_uri, 0, 7, 8, "0"));
+
+    l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 2);
+    assert(l_messages[0]["params"]["diagnostics"].as_array().empty());
+
+    const json::array &l_duplicate = l_messages[1]["params"]["diagnostics"].as_array();
+
+    assert(l_duplicate.size() == 1);
+    assert(l_duplicate[0]["range"]["start"]["line"] == json(1));
+
+    wipe_database();
+}
+
+static void test_language_server_bad_messages()
+{
+    using unilog::json;
+
+    std::stringstream l_input;
+    std::stringstream l_output;
+
+    // a request without a method, and a notification with a field of the wrong type
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"id", 1}, {"params", json::object{}}});
+    l_input << frame_message(json::object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/didOpen"},
+        {"params", json::object{{"textDocument", json::object{{"uri", "file:///tmp/unilog_lsp_test.u"}, {"text", 5}}}}},
+    });
+
+    // a bad length, after which the server finds the next message
+    l_input << "Content-Length: many\r\n\r\n{}";
+
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"id", 2}, {"method", "shutdown"}});
+    l_input << frame_message(json::object{{"jsonrpc", "2.0"}, {"method", "exit"}});
+
+    assert(unilog::run_language_server(l_input, l_output) == 0);
+
+    std::vector<json> l_messages = read_messages(l_output);
+
+    assert(l_messages.size() == 3);
+    assert(l_messages[0]["id"] == json(1));
+    assert(l_messages[0]["error"]["code"] == json(LSP_INVALID_REQUEST));
+    assert(l_messages[1]["id"].is_null());
+    assert(l_messages[1]["error"]["code"] == json(LSP_PARSE_ERROR));
+    assert(l_messages[2]["id"] == json(2));
+    assert(l_messages[2]["result"].is_null());
+}
+
+void test_language_server_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_read_message);
+    TEST(test_language_server_session);
+    TEST(test_language_server_close_retracts);
+    TEST(test_language_server_whitespace_edit);
+    TEST(test_language_server_list_tag);
+    TEST(test_language_server_document_order);
+    TEST(test_language_server_bad_messages);
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef LANGUAGE_SERVER_HPP
+#define LANGUAGE_SERVER_HPP
+
+#include <istream>
+#include <ostream>
+
+namespace unilog
+{
+
+    // serves the language server protocol over a_input and a_output, until
+    //     the client sends exit. open documents are executed as they are
+    //     edited: an edit re-lexes only the statements it touches, and
+    //     re-executes only those, plus the later statements which mention
+    //     a tag that was redeclared. every edit publishes the document's
+    //     diagnostics. returns the process exit code the protocol asks for.
+    int run_language_server(std::istream &a_input, std::ostream &a_output);
+
+}
+
+#endif
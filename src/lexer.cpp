@@ -1,15 +1,36 @@
 #include <string>
-#include <regex>
-#include <cctype>
 #include <stdexcept>
 
 #include "lexer.hpp"
+#include "scan.hpp"
+#include "char_class.hpp"
 #include "err_msg.hpp"
 
-std::istream &escape(std::istream &a_istream, char &a_char)
+// value of a single hex digit, or -1 if it is not one
+static int hex_digit_value(char a_char)
+{
+    unsigned char l_char = a_char;
+
+    if (l_char >= '0' && l_char <= '9')
+        return l_char - '0';
+
+    // fold upper case onto lower case
+    l_char |= 0x20;
+
+    if (l_char >= 'a' && l_char <= 'f')
+        return l_char - 'a' + 10;
+
+    return -1;
+}
+
+// decodes the escape sequence following a backslash. returns the position
+//     after the sequence, or nullptr if the sequence is malformed.
+static const char *escape(const char *a_pos, const char *a_end, char &a_char)
 {
-    char l_char;
-    a_istream.get(l_char);
+    if (a_pos == a_end)
+        return nullptr;
+
+    char l_char = *a_pos++;
 
     switch (l_char)
     {
@@ -55,29 +76,16 @@ std::istream &escape(std::istream &a_istream, char &a_char)
     break;
     case 'x':
     {
-        char l_upper_hex_digit;
-        char l_lower_hex_digit;
+        if (a_end - a_pos < 2)
+            return nullptr;
 
-        if (!a_istream.get(l_upper_hex_digit))
-            break;
-        if (!a_istream.get(l_lower_hex_digit))
-            break;
+        int l_upper_hex_value = hex_digit_value(*a_pos++);
+        int l_lower_hex_value = hex_digit_value(*a_pos++);
 
-        if (std::isxdigit(l_upper_hex_digit) == 0 || std::isxdigit(l_lower_hex_digit) == 0)
-        {
-            a_istream.setstate(std::ios::failbit);
-            break;
-        }
+        if (l_upper_hex_value < 0 || l_lower_hex_value < 0)
+            return nullptr;
 
-        int l_hex_value;
-
-        std::stringstream l_ss;
-
-        l_ss << std::hex << l_upper_hex_digit << l_lower_hex_digit;
-
-        l_ss >> l_hex_value;
-
-        a_char = static_cast<char>(l_hex_value);
+        a_char = static_cast<char>(l_upper_hex_value << 4 | l_lower_hex_value);
     }
     break;
     default:
@@ -87,100 +95,164 @@ std::istream &escape(std::istream &a_istream, char &a_char)
     break;
     }
 
-    return a_istream;
+    return a_pos;
 }
 
-static std::istream &consume_line(std::istream &a_istream)
+static const char *consume_line(const char *a_pos, const char *a_end)
 {
-    int l_char;
+    // read all chars up to and including \n. if we reach the end, stop there.
+    a_pos = unilog::find_newline(a_pos, a_end);
 
-    // Extract character (read all chars up to and including \n. If we peek EOF, return before consumption)
-    while (
-        a_istream.good() &&
-        (l_char = a_istream.peek()) &&
-        (l_char != std::ios::traits_type::eof()) &&
-        (a_istream.get() && l_char != '\n'))
-        ;
-
-    return a_istream;
+    return a_pos == a_end ? a_pos : a_pos + 1;
 }
 
-static std::istream &consume_whitespace(std::istream &a_istream)
+static const char *consume_whitespace(const char *a_pos, const char *a_end)
 {
-    int l_char;
-
-    // Extract character (read until first non-whitespace)
-    while (
-        a_istream.good() && // important to check a_istream.good() to prevent double-peeking an EOF, which will cause failbit.
-        (l_char = a_istream.peek()) &&
-        ((std::isspace(l_char) != 0 && a_istream.get()) ||
-         (l_char == '#' && consume_line(a_istream))))
-        ;
+    // read until first non-whitespace. comments count as whitespace.
+    while ((a_pos = unilog::skip_whitespace(a_pos, a_end)) != a_end && *a_pos == '#')
+        a_pos = consume_line(a_pos, a_end);
 
-    return a_istream;
+    return a_pos;
 }
 
-static std::istream &extract_unquoted_text(std::istream &a_istream, std::string &a_text)
+static const char *extract_unquoted_text(const char *a_pos, const char *a_end, unilog::symbol &a_text)
 {
     ////////////////////////////////////
     /////////// TEXT SECTION ///////////
     ////////////////////////////////////
 
-    a_text.clear();
-
-    char l_char;
+    const char *l_begin = a_pos;
 
     // unquoted lexemes may only contain alphanumeric chars and underscores.
-    while (
-        l_char = a_istream.peek(),
-        // conditions for consumption
-        (isalnum(l_char) || l_char == '_') &&
-            // Consume char now
-            a_istream.get(l_char))
-    {
-        a_text.push_back(l_char);
-    }
+    a_pos = unilog::skip_identifier(a_pos, a_end);
+
+    a_text = unilog::symbol(std::string_view(l_begin, a_pos - l_begin));
+
+    return a_pos;
+}
+
+// end of the run of quoted chars which need no decoding
+static const char *skip_plain_quoted_text(const char *a_pos, const char *a_end, char a_quote_char)
+{
+    while (a_pos != a_end && *a_pos != a_quote_char && *a_pos != '\\' && *a_pos != '\n')
+        ++a_pos;
 
-    return a_istream;
+    return a_pos;
 }
 
-static std::istream &extract_quoted_text(std::istream &a_istream, std::string &a_text)
+// a_text views the input when the literal has no escape sequences.
+//     otherwise, it is decoded into a_scratch, and a_text views that.
+static const char *extract_quoted_text(const char *a_pos, const char *a_end, std::string &a_scratch, std::string_view &a_text)
 {
     ////////////////////////////////////
     /////////// TEXT SECTION ///////////
     ////////////////////////////////////
 
     // save the type of quotation. then we can match for closing quote.
-    int l_quote_char = a_istream.get();
+    char l_quote_char = *a_pos++;
 
-    a_text.clear();
+    const char *l_begin = a_pos;
 
-    char l_char;
+    a_pos = skip_plain_quoted_text(a_pos, a_end, l_quote_char);
 
-    // The input was a quote character. Thus we should scan until the closing quote
-    //     to produce a valid lexeme.
-    while (
-        // Consume char now
-        a_istream.get(l_char))
+    /////////////////////////////////////////
+    // no escape sequences: slice the input
+    /////////////////////////////////////////
+    if (a_pos != a_end && *a_pos == l_quote_char)
     {
-        // no multiline string literals
-        if (l_char == '\n')
-            throw std::runtime_error(ERR_MSG_CLOSING_QUOTE);
+        a_text = std::string_view(l_begin, a_pos - l_begin);
+        return a_pos + 1;
+    }
 
-        if (l_char == l_quote_char)
+    /////////////////////////////////////////
+    // otherwise decode, one plain run at a time
+    /////////////////////////////////////////
+    a_scratch.assign(l_begin, a_pos);
+
+    // every run ends at a backslash, or at the closing quote
+    while (a_pos != a_end && *a_pos == '\\')
+    {
+        char l_char;
+
+        if ((a_pos = escape(a_pos + 1, a_end, l_char)) == nullptr)
             break;
 
-        if (l_char == '\\')
-            escape(a_istream, l_char);
+        a_scratch.push_back(l_char);
+
+        l_begin = a_pos;
+        a_pos = skip_plain_quoted_text(a_pos, a_end, l_quote_char);
+        a_scratch.append(l_begin, a_pos);
 
-        a_text.push_back(l_char);
+        if (a_pos != a_end && *a_pos == l_quote_char)
+        {
+            a_text = a_scratch;
+            return a_pos + 1;
+        }
     }
 
-    // if we fail to extract character, then throw exception
-    if (a_istream.fail())
-        throw std::runtime_error(ERR_MSG_CLOSING_QUOTE);
+    // if we run out of input before the closing quote, then throw exception.
+    //     no multiline string literals, either.
+    throw std::runtime_error(ERR_MSG_CLOSING_QUOTE);
+}
+
+//////////////////////////////////////////
+// istream adapter state
+//////////////////////////////////////////
 
-    return a_istream;
+// kept alongside each std::istream that lexemes are extracted from.
+//     lexemes never span lines, so whole lines are read from the stream
+//     and handed to the buffer lexer.
+struct istream_lexer_state
+{
+    std::string m_line;
+    unilog::lexer m_lexer;
+
+    // bytes of the stream read before m_line
+    size_t m_line_offset = 0;
+};
+
+static int istream_lexer_state_index()
+{
+    static const int s_index = std::ios_base::xalloc();
+    return s_index;
+}
+
+static void istream_lexer_state_callback(std::ios_base::event a_event, std::ios_base &a_ios, int a_index)
+{
+    void *&l_pword = a_ios.pword(a_index);
+
+    // the stream is being destroyed (or overwritten by copyfmt)
+    if (a_event == std::ios_base::erase_event)
+    {
+        delete static_cast<istream_lexer_state *>(l_pword);
+        l_pword = nullptr;
+    }
+
+    // copyfmt() copied the pointer of another stream. build our own state lazily.
+    if (a_event == std::ios_base::copyfmt_event)
+        l_pword = nullptr;
+}
+
+static istream_lexer_state &get_istream_lexer_state(std::istream &a_istream)
+{
+    const int l_index = istream_lexer_state_index();
+
+    void *&l_pword = a_istream.pword(l_index);
+
+    if (l_pword != nullptr)
+        return *static_cast<istream_lexer_state *>(l_pword);
+
+    // iword marks the callback as registered. it is copied by copyfmt() along with the callback.
+    if (a_istream.iword(l_index) == 0)
+    {
+        a_istream.register_callback(istream_lexer_state_callback, l_index);
+        a_istream.iword(l_index) = 1;
+    }
+
+    istream_lexer_state *l_state = new istream_lexer_state;
+    l_pword = l_state;
+
+    return *l_state;
 }
 
 namespace unilog
@@ -216,59 +288,166 @@ namespace unilog
         return a_lhs.m_text == a_rhs.m_text;
     }
 
-    std::istream &operator>>(std::istream &a_istream, lexeme &a_lexeme)
+    lexer::lexer(std::string_view a_input, size_t a_base)
+    {
+        assign(a_input, a_base);
+    }
+
+    void lexer::assign(std::string_view a_input, size_t a_base)
+    {
+        if (a_base > MAX_INPUT_SIZE || a_input.size() > MAX_INPUT_SIZE - a_base)
+            throw std::runtime_error(ERR_MSG_INPUT_TOO_LARGE);
+
+        m_begin = a_input.data();
+        m_pos = m_begin;
+        m_end = m_begin + a_input.size();
+        m_fail = false;
+        m_base = a_base;
+    }
+
+    lexer &operator>>(lexer &a_lexer, lexeme &a_lexeme)
     {
+        if (a_lexer.m_fail)
+            return a_lexer;
+
         // consume all leading whitespace
-        consume_whitespace(a_istream);
+        a_lexer.m_pos = consume_whitespace(a_lexer.m_pos, a_lexer.m_end);
 
-        // get the char which indicates type of lexeme
-        int l_indicator = a_istream.peek();
+        // running out of input is the only way to fail extraction
+        if (a_lexer.m_pos == a_lexer.m_end)
+        {
+            a_lexer.m_fail = true;
+            return a_lexer;
+        }
 
-        if (!a_istream.good())
-            return a_istream;
+        const char *l_begin = a_lexer.m_pos;
 
-        if (l_indicator == ';')
+        // the class of the first char indicates the type of lexeme
+        switch (get_char_class(*a_lexer.m_pos))
         {
-            a_istream.get(); // extract the character
+        case char_class::eol:
+        {
+            ++a_lexer.m_pos; // extract the character
             a_lexeme = eol{};
         }
-        else if (l_indicator == '|')
+        break;
+        case char_class::list_separator:
         {
-            a_istream.get(); // extract the character
+            ++a_lexer.m_pos; // extract the character
             a_lexeme = list_separator{};
         }
-        else if (l_indicator == '[')
+        break;
+        case char_class::list_open:
         {
-            a_istream.get(); // extract the character
+            ++a_lexer.m_pos; // extract the character
             a_lexeme = list_open{};
         }
-        else if (l_indicator == ']')
+        break;
+        case char_class::list_close:
         {
-            a_istream.get(); // extract the character
+            ++a_lexer.m_pos; // extract the character
             a_lexeme = list_close{};
         }
-        else if (isupper(l_indicator) || l_indicator == '_')
+        break;
+        case char_class::variable_start:
         {
             variable l_result;
-            extract_unquoted_text(a_istream, l_result.m_identifier);
+            a_lexer.m_pos = extract_unquoted_text(a_lexer.m_pos, a_lexer.m_end, l_result.m_identifier);
             a_lexeme = l_result;
         }
-        else if (l_indicator == '\'' || l_indicator == '\"')
+        break;
+        case char_class::quote:
         {
-            atom l_result;
-            extract_quoted_text(a_istream, l_result.m_text);
-            a_lexeme = l_result;
+            std::string_view l_text;
+            a_lexer.m_pos = extract_quoted_text(a_lexer.m_pos, a_lexer.m_end, a_lexer.m_decoded, l_text);
+            a_lexeme = atom{l_text};
         }
-        else if (isalpha(l_indicator)) // only lower-case letters
+        break;
+        case char_class::atom_start: // only lower-case letters
         {
             atom l_result;
-            extract_unquoted_text(a_istream, l_result.m_text);
+            a_lexer.m_pos = extract_unquoted_text(a_lexer.m_pos, a_lexer.m_end, l_result.m_text);
             a_lexeme = l_result;
         }
-        else
+        break;
+        default:
         {
             throw std::runtime_error(ERR_MSG_INVALID_LEXEME);
         }
+        break;
+        }
+
+        span l_span{
+            .m_begin = static_cast<uint32_t>(a_lexer.m_base + (l_begin - a_lexer.m_begin)),
+            .m_end = static_cast<uint32_t>(a_lexer.m_base + (a_lexer.m_pos - a_lexer.m_begin)),
+        };
+
+        std::visit([l_span](auto &a_alternative)
+                   { a_alternative.m_span = l_span; }, a_lexeme);
+
+        return a_lexer;
+    }
+
+    const char *skip_whitespace_and_comments(const char *a_pos, const char *a_end)
+    {
+        return consume_whitespace(a_pos, a_end);
+    }
+
+    const char *find_statement_end(const char *a_pos, const char *a_end)
+    {
+        while (a_pos != a_end)
+        {
+            char l_char = *a_pos++;
+
+            switch (get_char_class(l_char))
+            {
+            case char_class::eol:
+            {
+                return a_pos;
+            }
+            break;
+            case char_class::comment:
+            {
+                a_pos = consume_line(a_pos, a_end);
+            }
+            break;
+            case char_class::quote:
+            {
+                // skip to the closing quote. escaped chars never close it.
+                while (a_pos != a_end && *a_pos != l_char && *a_pos != '\n')
+                    a_pos += (*a_pos == '\\' && a_end - a_pos > 1) ? 2 : 1;
+
+                if (a_pos != a_end)
+                    ++a_pos;
+            }
+            break;
+            default:
+                break;
+            }
+        }
+
+        return a_pos;
+    }
+
+    std::istream &operator>>(std::istream &a_istream, lexeme &a_lexeme)
+    {
+        istream_lexer_state &l_state = get_istream_lexer_state(a_istream);
+
+        // extract from the current line, reading another whenever it runs dry
+        while (!(l_state.m_lexer >> a_lexeme))
+        {
+            l_state.m_line_offset += l_state.m_line.size();
+
+            if (!std::getline(a_istream, l_state.m_line))
+                return a_istream;
+
+            // keep the newline, so that unclosed quotes are detected as before
+            if (!a_istream.eof())
+                l_state.m_line.push_back('\n');
+
+            // spans are offsets into the whole stream
+            l_state.m_lexer.assign(l_state.m_line, l_state.m_line_offset);
+        }
 
         return a_istream;
     }
@@ -278,10 +457,92 @@ namespace unilog
 #ifdef UNIT_TEST
 
 #include <fstream>
+#include <sstream>
+#include <cctype>
 #include <iterator>
 #include <vector>
+#include <map>
 #include "test_utils.hpp"
 
+// the acceptance rules of the lexer before it used char classes,
+//     spelled out so that they can be checked at compile time.
+constexpr bool char_classes_match_acceptance_rules()
+{
+    using unilog::char_class;
+
+    for (unsigned l_char = 0; l_char < 256; l_char++)
+    {
+        char l_signed_char = static_cast<char>(l_char);
+        char_class l_class = unilog::get_char_class(l_signed_char);
+
+        // std::isspace
+        bool l_space = l_char == ' ' || l_char == '\t' || l_char == '\n' ||
+                       l_char == '\v' || l_char == '\f' || l_char == '\r';
+
+        // std::isupper, std::islower, std::isdigit
+        bool l_upper = l_char >= 'A' && l_char <= 'Z';
+        bool l_lower = l_char >= 'a' && l_char <= 'z';
+        bool l_digit = l_char >= '0' && l_char <= '9';
+
+        if (unilog::is_whitespace(l_signed_char) != l_space)
+            return false;
+
+        // std::isalnum or '_'
+        if (unilog::is_identifier(l_signed_char) != (l_upper || l_lower || l_digit || l_char == '_'))
+            return false;
+
+        // std::isupper or '_'
+        if ((l_class == char_class::variable_start) != (l_upper || l_char == '_'))
+            return false;
+
+        // std::isalpha, once upper-case letters are ruled out
+        if ((l_class == char_class::atom_start) != l_lower)
+            return false;
+
+        if ((l_class == char_class::quote) != (l_char == '\'' || l_char == '\"'))
+            return false;
+
+        if ((l_class == char_class::comment) != (l_char == '#'))
+            return false;
+
+        if ((l_class == char_class::eol) != (l_char == ';') ||
+            (l_class == char_class::list_separator) != (l_char == '|') ||
+            (l_class == char_class::list_open) != (l_char == '[') ||
+            (l_class == char_class::list_close) != (l_char == ']'))
+            return false;
+
+        // nothing else starts a lexeme, including every byte outside ascii
+        bool l_accepted = l_space || l_upper || l_lower || l_digit ||
+                          l_char == '_' || l_char == '\'' || l_char == '\"' || l_char == '#' ||
+                          l_char == ';' || l_char == '|' || l_char == '[' || l_char == ']';
+
+        if ((l_class == char_class::invalid) == l_accepted)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(char_classes_match_acceptance_rules());
+static_assert(unilog::get_char_class('\xC3') == unilog::char_class::invalid);
+static_assert(unilog::get_char_class('0') == unilog::char_class::digit);
+static_assert(!unilog::is_identifier('-'));
+
+static void test_lexer_char_classes()
+{
+    // the compile-time rules agree with <cctype> in the C locale
+    for (int l_char = 0; l_char < 256; l_char++)
+    {
+        char l_signed_char = static_cast<char>(l_char);
+        unilog::char_class l_class = unilog::get_char_class(l_signed_char);
+
+        assert(unilog::is_whitespace(l_signed_char) == (std::isspace(l_char) != 0));
+        assert(unilog::is_identifier(l_signed_char) == (std::isalnum(l_char) != 0 || l_char == '_'));
+        assert((l_class == unilog::char_class::variable_start) == (std::isupper(l_char) != 0 || l_char == '_'));
+        assert((l_class == unilog::char_class::atom_start) == (std::isalpha(l_char) != 0 && std::isupper(l_char) == 0));
+    }
+}
+
 static void test_lexer_escape()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
@@ -305,6 +566,8 @@ static void test_lexer_escape()
         {"xff", 255},
         {"xAb", 0xAB},
         {"xaB", 0xAB},
+        {"x9e", 0x9E},
+        {"xF0", 0xF0},
         {"c", 'c'},
         {"\'", '\''},
         {"\\", '\\'},
@@ -316,16 +579,16 @@ static void test_lexer_escape()
 
     for (const auto &[l_key, l_value] : l_desired_map)
     {
-        std::stringstream l_ss(l_key);
+        const char *l_end = l_key.data() + l_key.size();
 
         char l_escaped_char;
-        escape(l_ss, l_escaped_char);
+        const char *l_pos = escape(l_key.data(), l_end, l_escaped_char);
 
         // Ensure the escape routine succeeded on this test case.
         assert(l_escaped_char == l_value);
 
-        // Ensure the stream content was actually consumed
-        assert((size_t)l_ss.tellg() == l_key.size());
+        // Ensure the input was actually consumed
+        assert(l_pos == l_end);
 
         LOG("success, case: " << l_key << std::endl);
     }
@@ -337,18 +600,19 @@ static void test_lexer_escape()
             "x1Z",
             "x1z",
             "xg0",
+            "x:0",
+            "x/0",
+            "x@0",
+            "x`0",
+            "xG0",
         };
 
     for (const auto &l_input : l_expect_failure_inputs)
     {
-        std::stringstream l_ss(l_input);
-
         char l_escaped_char;
 
-        escape(l_ss, l_escaped_char);
-
         // expect failure state of extraction
-        assert(l_ss.fail());
+        assert(escape(l_input.data(), l_input.data() + l_input.size(), l_escaped_char) == nullptr);
 
         LOG("success, expected throw, case: " << l_input << std::endl);
     }
@@ -356,7 +620,7 @@ static void test_lexer_escape()
 
 static void test_consume_line()
 {
-    data_points<std::string, std::streampos> l_data_points =
+    data_points<std::string, std::ptrdiff_t> l_data_points =
         {
             {"\nakdsfhjghdjfgj", 1},
             {"a\nakdsfhjghdjfgj", 2},
@@ -370,16 +634,16 @@ static void test_consume_line()
 
     for (const auto &[l_key, l_value] : l_data_points)
     {
-        std::stringstream l_ss(l_key);
-        assert(consume_line(l_ss)); // eofbit = 2
-        // std::cout << l_ss.rdstate() << std::endl;
-        assert(l_ss.tellg() == l_value); // make sure we extracted the correct # of chars
+        const char *l_end = l_key.data() + l_key.size();
+        const char *l_pos = consume_line(l_key.data(), l_end);
+        // make sure we extracted the correct # of chars (-1 meaning all input was consumed)
+        assert((l_pos == l_end ? -1 : l_pos - l_key.data()) == l_value);
     }
 }
 
 static void test_consume_whitespace()
 {
-    data_points<std::string, std::streampos> l_data_points =
+    data_points<std::string, std::ptrdiff_t> l_data_points =
         {
             {"    abc", 4},
             {"   \nabc", 4},
@@ -400,9 +664,10 @@ static void test_consume_whitespace()
 
     for (const auto &[l_key, l_value] : l_data_points)
     {
-        std::stringstream l_ss(l_key);
-        assert(consume_whitespace(l_ss));
-        assert(l_ss.tellg() == l_value); // make sure we extracted the correct # of chars
+        const char *l_end = l_key.data() + l_key.size();
+        const char *l_pos = consume_whitespace(l_key.data(), l_end);
+        // make sure we extracted the correct # of chars (-1 meaning all input was consumed)
+        assert((l_pos == l_end ? -1 : l_pos - l_key.data()) == l_value);
     }
 }
 
@@ -438,10 +703,10 @@ static void test_extract_unquoted_text()
 
     for (const auto &[l_key, l_value] : l_data_points)
     {
-        std::stringstream l_ss(l_key);
-        std::string l_string;
-        assert(extract_unquoted_text(l_ss, l_string));
-        assert(l_string == l_value);
+        unilog::symbol l_text;
+        const char *l_pos = extract_unquoted_text(l_key.data(), l_key.data() + l_key.size(), l_text);
+        assert(l_text.text() == l_value);
+        assert(l_pos == l_key.data() + l_value.size());
     }
 }
 
@@ -490,12 +755,19 @@ static void test_extract_quoted_text()
             {"\"\\r1\\n23\"", "\r1\n23"},
         };
 
+    // a single scratch buffer is reused across literals
+    std::string l_scratch;
+
     for (const auto &[l_key, l_value] : l_data_points)
     {
-        std::stringstream l_ss(l_key);
-        std::string l_string;
-        assert(extract_quoted_text(l_ss, l_string));
-        assert(l_string == l_value);
+        std::string_view l_text;
+        const char *l_pos = extract_quoted_text(l_key.data(), l_key.data() + l_key.size(), l_scratch, l_text);
+        assert(l_text == l_value);
+
+        // literals without escapes are sliced from the input, others are decoded
+        bool l_escaped = l_key.find('\\') < (size_t)(l_pos - l_key.data());
+        const char *l_storage = l_escaped ? l_scratch.data() : l_key.data() + 1;
+        assert(l_text.data() == l_storage);
     }
 }
 
@@ -1562,6 +1834,16 @@ static void test_lexer_extract_lexeme()
         // Ensure the lexeme extraction succeeded
         assert(l_lexemes == l_value);
 
+        // the buffer lexer must agree with the istream adapter
+        unilog::lexer l_lexer(l_key);
+
+        std::vector<lexeme> l_buffer_lexemes;
+
+        for (lexeme l_lexeme; l_lexer >> l_lexeme;)
+            l_buffer_lexemes.push_back(l_lexeme);
+
+        assert(l_buffer_lexemes == l_value);
+
         LOG("success, case: \"" << l_key << "\"" << std::endl);
     }
 
@@ -1615,6 +1897,18 @@ static void test_lexer_extract_lexeme()
             assert(l_err.what() == l_err_msg);
         }
 
+        // Make sure the buffer lexer throws the same exception.
+        try
+        {
+            unilog::lexer l_lexer(l_input);
+            l_lexer >> l_lexeme;
+            throw std::runtime_error("Failed test case: expected throw");
+        }
+        catch (const std::runtime_error &l_err)
+        {
+            assert(l_err.what() == l_err_msg);
+        }
+
         LOG("success, expected throw, case: " << l_input << std::endl);
     }
 
@@ -1639,10 +1933,190 @@ static void test_lexer_extract_lexeme()
         // Make sure the stream state has its failbit set.
         assert(l_ss.fail());
 
+        unilog::lexer l_lexer(l_input);
+        l_lexer >> l_lexeme;
+
+        // Make sure the buffer lexer fails the same way.
+        assert(l_lexer.fail());
+
         LOG("success, expected stream fail state, case: " << l_input << std::endl);
     }
 }
 
+static void test_lexer_spans()
+{
+    using unilog::lexeme;
+    using unilog::span;
+
+    std::string l_text = "axiom a0 # c\n [X 'q\\n' | T];";
+
+    // (begin, end) of each lexeme
+    std::vector<std::pair<uint32_t, uint32_t>> l_expected =
+        {
+            {0, 5},
+            {6, 8},
+            {14, 15},
+            {15, 16},
+            {17, 22},
+            {23, 24},
+            {25, 26},
+            {26, 27},
+            {27, 28},
+        };
+
+    /////////////////////////////////////////
+    // spans are offsets into the input, from where the lexeme begins
+    /////////////////////////////////////////
+    unilog::lexer l_lexer(l_text);
+
+    std::vector<lexeme> l_lexemes;
+
+    for (lexeme l_lexeme; l_lexer >> l_lexeme;)
+        l_lexemes.push_back(l_lexeme);
+
+    assert(l_lexemes.size() == l_expected.size());
+
+    for (size_t i = 0; i < l_lexemes.size(); i++)
+    {
+        span l_span = unilog::get_span(l_lexemes[i]);
+        assert(l_span.m_begin == l_expected[i].first && l_span.m_end == l_expected[i].second);
+    }
+
+    /////////////////////////////////////////
+    // a base offset shifts them, as when lexing a slice of a larger text
+    /////////////////////////////////////////
+    l_lexer.assign(std::string_view(l_text).substr(6), 6);
+
+    lexeme l_lexeme;
+    assert(l_lexer >> l_lexeme);
+    assert(unilog::get_span(l_lexeme).m_begin == 6 && unilog::get_span(l_lexeme).m_end == 8);
+
+    /////////////////////////////////////////
+    // the stream adapter lexes line by line, but spans count from the start of the stream
+    /////////////////////////////////////////
+    std::stringstream l_ss(l_text);
+
+    for (size_t i = 0; i < l_expected.size(); i++)
+    {
+        assert(l_ss >> l_lexeme);
+
+        span l_span = unilog::get_span(l_lexeme);
+        assert(l_span.m_begin == l_expected[i].first && l_span.m_end == l_expected[i].second);
+    }
+
+    /////////////////////////////////////////
+    // spans are not compared
+    /////////////////////////////////////////
+    assert((unilog::atom{"a0", {6, 8}} == unilog::atom{"a0"}));
+    assert((unilog::eol{{1, 2}} == unilog::eol{{3, 4}}));
+
+    /////////////////////////////////////////
+    // input ending past what spans can address is rejected
+    /////////////////////////////////////////
+    l_lexer.assign("a0;", unilog::MAX_INPUT_SIZE - 3);
+
+    assert(l_lexer >> l_lexeme);
+    assert(unilog::get_span(l_lexeme).m_end == unilog::MAX_INPUT_SIZE - 1);
+
+    try
+    {
+        l_lexer.assign("a0;", unilog::MAX_INPUT_SIZE - 2);
+        assert(false);
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        assert(l_err.what() == std::string(ERR_MSG_INPUT_TOO_LARGE));
+    }
+}
+
+static void test_find_statement_end()
+{
+    // expected offset just past the terminating ';', or -1 for the end of input
+    data_points<std::string, int> l_data_points =
+        {
+            {"", -1},
+            {"axiom a0 x", -1},
+            {"axiom a0 x;", 11},
+            {"axiom a0 x; axiom a1 y;", 11},
+            {";", 1},
+            {"axiom a0 'x;y';", 15},
+            {"axiom a0 \"x;y\";", 15},
+            {"axiom a0 'x\\';y';", 17},
+            {"axiom a0 '\"';", 13},
+            {"axiom a0 x # a;b\n;", 18},
+            {"# ;\n# ;\naxiom a0 x;", 19},
+            {"axiom a0 'x\n;", 13},  // unclosed quotes end with their line
+            {"axiom a0 'x;", -1},
+            {"axiom a0 x # ;", -1},
+            {"[a | b] ; c", 9},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        const char *l_end = l_key.data() + l_key.size();
+        const char *l_pos = unilog::find_statement_end(l_key.data(), l_end);
+        assert(l_pos == (l_value < 0 ? l_end : l_key.data() + l_value));
+    }
+
+    // splitting input at statement ends agrees with the lexer
+    std::ifstream l_ifs("./src/test_input_files/executor_example_3/main/main.u");
+    std::string l_input((std::istreambuf_iterator<char>(l_ifs)), std::istreambuf_iterator<char>());
+
+    size_t l_eol_count = 0;
+
+    unilog::lexer l_lexer(l_input);
+
+    for (unilog::lexeme l_lexeme; l_lexer >> l_lexeme;)
+        l_eol_count += std::holds_alternative<unilog::eol>(l_lexeme);
+
+    size_t l_statement_count = 0;
+
+    for (const char *l_pos = l_input.data(), *l_end = l_pos + l_input.size(); l_pos != l_end; ++l_statement_count)
+    {
+        l_pos = unilog::find_statement_end(l_pos, l_end);
+        assert(l_pos == l_end || l_pos[-1] == ';');
+    }
+
+    assert(l_eol_count > 0);
+    assert(l_statement_count == l_eol_count || l_statement_count == l_eol_count + 1);
+}
+
+static void test_lexer_interned_text()
+{
+    using unilog::atom;
+    using unilog::lexeme;
+    using unilog::variable;
+
+    std::vector<lexeme> l_lexemes;
+
+    {
+        std::string l_input = "axiom add_bc_0 [add [] L L] \'quoted\' add;";
+
+        unilog::lexer l_lexer(l_input);
+
+        for (lexeme l_lexeme; l_lexer >> l_lexeme;)
+            l_lexemes.push_back(l_lexeme);
+
+        assert(l_lexer.eof());
+        assert(l_lexer.tell() == l_input.size());
+
+        // scribble over the input before it is destroyed
+        l_input.assign(l_input.size(), '?');
+    }
+
+    // lexemes own their text, so they outlive the input
+    assert(l_lexemes.size() == 12);
+    assert(std::get<atom>(l_lexemes[0]).m_text.text() == "axiom");
+    assert(std::get<atom>(l_lexemes[1]).m_text.text() == "add_bc_0");
+    assert(std::get<variable>(l_lexemes[6]).m_identifier.text() == "L");
+    assert(std::get<atom>(l_lexemes[9]).m_text.text() == "quoted");
+
+    // repeated text is interned once
+    assert(std::get<atom>(l_lexemes[3]) == std::get<atom>(l_lexemes[10]));
+    assert(std::get<atom>(l_lexemes[3]).m_text.id() == std::get<atom>(l_lexemes[10]).m_text.id());
+    assert(std::get<variable>(l_lexemes[6]) == std::get<variable>(l_lexemes[7]));
+}
+
 static void test_lex_file_examples()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
@@ -1824,6 +2298,7 @@ void test_lexer_main()
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
     // equivalence tests
+    TEST(test_lexer_char_classes);
     TEST(test_lexer_escape);
     TEST(test_consume_line);
     TEST(test_consume_whitespace);
@@ -1838,6 +2313,9 @@ void test_lexer_main()
 
     // extractor tests
     TEST(test_lexer_extract_lexeme);
+    TEST(test_lexer_interned_text);
+    TEST(test_lexer_spans);
+    TEST(test_find_statement_end);
 
     // larger tests, lexing files
     TEST(test_lex_file_examples);
@@ -3,37 +3,61 @@
 
 #include <list>
 #include <string>
+#include <string_view>
 #include <filesystem>
 #include <iterator>
 #include <variant>
+#include <cstdint>
+#include "symbol.hpp"
 
 namespace unilog
 {
 
+    // the bytes [m_begin, m_end) of the input that a lexeme or statement
+    //     was read from. every lexeme carries one, so it is kept compact.
+    struct span
+    {
+        uint32_t m_begin = 0;
+        uint32_t m_end = 0;
+    };
+
+    // the most bytes of input spans can address. larger inputs are
+    //     rejected, rather than have their offsets wrap.
+    constexpr size_t MAX_INPUT_SIZE = UINT32_MAX;
+
+    // spans only say where a lexeme came from. they are not compared.
     struct eol
     {
+        span m_span;
     };
 
     struct list_separator
     {
+        span m_span;
     };
 
     struct list_open
     {
+        span m_span;
     };
 
     struct list_close
     {
+        span m_span;
     };
 
+    // the text of variables and atoms is interned, so lexemes
+    //     do not depend on the input they were lexed from.
     struct variable
     {
-        std::string m_identifier;
+        symbol m_identifier;
+        span m_span;
     };
 
     struct atom
     {
-        std::string m_text;
+        symbol m_text;
+        span m_span;
     };
 
     /////////////////////////////////
@@ -54,6 +78,66 @@ namespace unilog
         variable,
         atom>;
 
+    inline span get_span(const lexeme &a_lexeme)
+    {
+        return std::visit([](const auto &a_alternative)
+                          { return a_alternative.m_span; }, a_lexeme);
+    }
+
+    // zero-copy lexer over a contiguous buffer. text is interned straight
+    //     from the buffer, and never copied unless it has escape sequences.
+    //     it mirrors the extraction interface of std::istream, so that
+    //     the parser may consume either.
+    class lexer
+    {
+    private:
+        const char *m_begin = nullptr;
+        const char *m_pos = nullptr;
+        const char *m_end = nullptr;
+        bool m_fail = false;
+
+        // offset of the input within the text it was taken from.
+        //     spans are relative to that text.
+        size_t m_base = 0;
+
+        // reused to decode quoted text with escape sequences
+        std::string m_decoded;
+
+    public:
+        lexer() = default;
+        explicit lexer(std::string_view a_input, size_t a_base = 0);
+
+        // rebinds the lexer to new input. throws if the input would end
+        //     past MAX_INPUT_SIZE of the text it was taken from.
+        void assign(std::string_view a_input, size_t a_base = 0);
+
+        bool fail() const { return m_fail; }
+        bool eof() const { return m_pos == m_end; }
+        explicit operator bool() const { return !m_fail; }
+
+        // number of bytes consumed from the current input
+        size_t tell() const { return m_pos - m_begin; }
+
+        // the same, as an offset into the text spans are relative to
+        size_t offset() const { return m_base + tell(); }
+
+        friend lexer &operator>>(lexer &a_lexer, lexeme &a_lexeme);
+    };
+
+    lexer &operator>>(lexer &a_lexer, lexeme &a_lexeme);
+
+    // first char at or after a_pos which is not whitespace or a comment
+    const char *skip_whitespace_and_comments(const char *a_pos, const char *a_end);
+
+    // end of the statement beginning at a_pos: just past its terminating ';',
+    //     or a_end if it has none. quoted text and comments are skipped over
+    //     without being lexed, so that input may be split into statements
+    //     cheaply. an unclosed quote ends at the end of its line, as it
+    //     would fail to lex there anyway.
+    const char *find_statement_end(const char *a_pos, const char *a_end);
+
+    // adapter over unilog::lexer. the line currently being lexed is
+    //     kept alongside the stream.
     std::istream &operator>>(std::istream &a_istream, lexeme &a_lexeme);
 
 }
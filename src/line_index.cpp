@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "line_index.hpp"
+#include "scan.hpp"
+
+namespace unilog
+{
+
+    line_index::line_index(std::string_view a_text) : m_line_begins{0}, m_size(a_text.size())
+    {
+        const char *l_begin = a_text.data();
+        const char *l_end = l_begin + a_text.size();
+
+        for (const char *l_pos = find_newline(l_begin, l_end); l_pos != l_end; l_pos = find_newline(l_pos, l_end))
+            m_line_begins.push_back(++l_pos - l_begin);
+    }
+
+    size_t line_index::line(size_t a_offset) const
+    {
+        return std::upper_bound(m_line_begins.begin(), m_line_begins.end(), a_offset) - m_line_begins.begin() - 1;
+    }
+
+    size_t line_index::line_begin(size_t a_line) const
+    {
+        return a_line < m_line_begins.size() ? m_line_begins[a_line] : m_size;
+    }
+
+    size_t line_index::line_end(size_t a_line) const
+    {
+        // the next line begins just past the newline
+        return a_line + 1 < m_line_begins.size() ? m_line_begins[a_line + 1] - 1 : m_size;
+    }
+
+    std::pair<size_t, size_t> line_index::position(size_t a_offset) const
+    {
+        size_t l_line = line(a_offset);
+        return {l_line + 1, std::min(a_offset, m_size) - m_line_begins[l_line] + 1};
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <string>
+#include "test_utils.hpp"
+
+static void test_line_index_lines()
+{
+    std::string l_text = "axiom a0 x;\n\naxiom a1 y;\nlast";
+
+    unilog::line_index l_index(l_text);
+
+    assert(l_index.line_count() == 4);
+
+    data_points<size_t, size_t> l_data_points =
+        {
+            {0, 0},
+            {11, 0}, // the newline belongs to the line it ends
+            {12, 1},
+            {13, 2},
+            {25, 3},
+            {28, 3},
+            {1000, 3},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+        assert(l_index.line(l_key) == l_value);
+
+    assert(l_index.line_begin(2) == 13 && l_index.line_end(2) == 24);
+    assert(l_index.line_begin(1) == 12 && l_index.line_end(1) == 12);
+    assert(l_index.line_begin(3) == 25 && l_index.line_end(3) == 29);
+    assert(l_index.line_begin(9) == 29 && l_index.line_end(9) == 29);
+}
+
+static void test_line_index_positions()
+{
+    std::string l_text = "ab\ncd\n";
+
+    unilog::line_index l_index(l_text);
+
+    // a trailing newline starts an empty last line
+    assert(l_index.line_count() == 3);
+
+    data_points<size_t, std::pair<size_t, size_t>> l_data_points =
+        {
+            {0, {1, 1}},
+            {2, {1, 3}},
+            {3, {2, 1}},
+            {5, {2, 3}},
+            {6, {3, 1}},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+        assert(l_index.position(l_key) == l_value);
+
+    // an empty text is a single empty line
+    assert(unilog::line_index("").line_count() == 1);
+    assert((unilog::line_index("").position(0) == std::pair<size_t, size_t>{1, 1}));
+}
+
+static void test_line_index_long_text()
+{
+    // long enough for the vector kernels to do the scanning
+    std::string l_text;
+
+    for (size_t i = 0; i < 1000; i++)
+        l_text += std::string(i % 97, 'x') + "\n";
+
+    unilog::line_index l_index(l_text);
+
+    assert(l_index.line_count() == 1001);
+
+    for (size_t i = 0, l_offset = 0; i < 1000; l_offset += i % 97 + 1, i++)
+    {
+        assert(l_index.line_begin(i) == l_offset);
+        assert(l_index.line(l_offset + i % 97) == i);
+    }
+}
+
+void test_line_index_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_line_index_lines);
+    TEST(test_line_index_positions);
+    TEST(test_line_index_long_text);
+}
+
+#endif
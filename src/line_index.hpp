@@ -0,0 +1,42 @@
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace unilog
+{
+
+    // where each line of a text begins, for turning byte offsets into
+    //     line and column numbers. built with one newline scan over the
+    //     text, so it is only worth building once a position is needed.
+    class line_index
+    {
+    private:
+        // offset of the first byte of each line. the first is always 0.
+        std::vector<size_t> m_line_begins;
+
+        size_t m_size = 0;
+
+    public:
+        line_index() = default;
+        explicit line_index(std::string_view a_text);
+
+        size_t line_count() const { return m_line_begins.size(); }
+
+        // zero-based line containing a_offset. offsets past the end are on the last line.
+        size_t line(size_t a_offset) const;
+
+        // offset of the first byte of a_line, and of its newline (or the end of the text).
+        //     lines past the last one begin and end at the end of the text.
+        size_t line_begin(size_t a_line) const;
+        size_t line_end(size_t a_line) const;
+
+        // one-based line and byte column of a_offset, as error messages show them
+        std::pair<size_t, size_t> position(size_t a_offset) const;
+    };
+
+}
+
+#endif
@@ -2,10 +2,18 @@
 
 #include <stdio.h>
 #include <iostream>
+#include <fstream>
 #include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <thread>
 #include <SWI-Prolog.h>
 #include "../CLI11/include/CLI/CLI.hpp"
 #include "executor.hpp"
+#include "language_server.hpp"
+#include "serializer.hpp"
+#include "syntax_check.hpp"
+#include "err_msg.hpp"
 
 #define MAXLINE 1024
 
@@ -15,10 +23,6 @@ int main(int argc, char **argv)
 
     const char *plav[] = {argv[0], "--quiet", "--nosignals"};
 
-    /* initialise Prolog */
-    if (!PL_initialise(3, const_cast<char **>(plav)))
-        PL_halt(1);
-
         /* Lookup calc/1 and make the arguments and call */
 
         // {
@@ -61,7 +65,25 @@ int main(int argc, char **argv)
     // l_app.require_subcommand(1);
 
     std::vector<std::string> l_files;
-    l_app.add_option("files", l_files, "List of input files");
+    l_app.add_option("files", l_files, "List of input files (- for stdin)");
+
+    bool l_lsp = false;
+    l_app.add_flag("--lsp", l_lsp, "Serve the language server protocol over stdio");
+
+    bool l_stats = false;
+    l_app.add_flag("--stats", l_stats, "Report the memory saved by sharing ground subterms and caching parsed modules, or the totals of a syntax check");
+
+    bool l_syntax_only = false;
+    l_app.add_flag("--syntax-only", l_syntax_only, "Only lex and parse the files, and the files they refer to, without starting Prolog");
+
+    size_t l_parse_threads = 1;
+    l_app.add_option("--parse-threads", l_parse_threads, "Threads parsing each file, or files checked at once with --syntax-only (0 for one per core)");
+
+    std::string l_module_cache;
+    l_app.add_option("--module-cache", l_module_cache, "Keep compiled modules of referred files in this directory, and load them from it while fresh");
+
+    std::string l_export;
+    l_app.add_option("--export", l_export, "Write the theorems of the single input file, inferred ones too, to this file as axioms. theorems of the modules it refers are not written");
 
     using unilog::execute;
     using unilog::refer_statement;
@@ -71,30 +93,136 @@ int main(int argc, char **argv)
     {
         l_app.parse(argc, argv);
 
+        if (l_parse_threads == 0)
+            l_parse_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        /////////////////////////////////////////
+        // every file is executed as [root], so the exports of two files
+        //     could declare the same tags, and fail to load back as one
+        /////////////////////////////////////////
+        if (!l_export.empty() && l_files.size() != 1)
+            throw std::runtime_error(ERR_MSG_EXPORT_FILES);
+
+        /////////////////////////////////////////
+        // syntax checking needs no prolog, so its startup is skipped.
+        //     each file is parsed by one thread, and --parse-threads
+        //     files at once.
+        /////////////////////////////////////////
+        if (l_syntax_only)
+        {
+            unilog::syntax_check_result l_result = unilog::check_syntax(l_files, l_parse_threads);
+
+            for (const unilog::syntax_diagnostic &l_diagnostic : l_result.m_diagnostics)
+                std::cout << l_diagnostic << '\n';
+
+            if (l_stats)
+                std::cout << l_result.m_files << " files, "
+                          << l_result.m_statements << " statements, "
+                          << l_result.m_bytes << " bytes checked" << '\n';
+
+            std::cout.flush();
+
+            return l_result.m_diagnostics.empty() ? 0 : 1;
+        }
+
+        /* register foreign predicates, before Prolog starts */
+        register_foreign_predicates();
+
+        /* initialise Prolog */
+        if (!PL_initialise(3, const_cast<char **>(plav)))
+            PL_halt(1);
+
+        unilog::set_parse_threads(l_parse_threads);
+        unilog::set_module_cache_directory(l_module_cache);
+
+        // stdout carries only protocol messages from here on
+        if (l_lsp)
+        {
+            int l_exit_code = unilog::run_language_server(std::cin, std::cout);
+            PL_halt(l_exit_code);
+            return l_exit_code;
+        }
+
+        std::ofstream l_export_stream;
+
+        if (!l_export.empty())
+        {
+            l_export_stream.open(l_export, std::ios::binary);
+
+            if (!l_export_stream)
+                throw std::runtime_error(ERR_MSG_FILE_OPEN);
+        }
+
         // execute all unilog files
         for (const std::string &l_file : l_files)
         {
+            // each file is executed with nothing kept from the one before
+            unilog::clear_refer_state();
+
             std::cout << l_file << std::endl;
 
             try
             {
-                execute(refer_statement{
-                            .m_tag = make_atom("root"),
-                            .m_file_path = make_atom(l_file),
-                        },
-                        make_nil());
+                if (l_file == "-")
+                {
+                    /////////////////////////////////////////
+                    // stdin is executed as it arrives, in the same module a file would be
+                    /////////////////////////////////////////
+                    unilog::stream_statistics l_statistics =
+                        unilog::execute_stream(STDIN_FILENO, "<stdin>", make_list({make_atom("root")}));
+
+                    std::cout << l_statistics.m_statements << " statements, "
+                              << l_statistics.m_bytes << " bytes in "
+                              << l_statistics.m_seconds << " s (";
+
+                    // empty or instant input has no meaningful rate
+                    if (l_statistics.m_seconds > 0)
+                        std::cout << l_statistics.m_bytes / 1e6 / l_statistics.m_seconds << " MB/s, "
+                                  << l_statistics.m_statements / l_statistics.m_seconds << " statements/s, ";
+
+                    std::cout << "peak buffer " << l_statistics.m_peak_buffered << " bytes)" << std::endl;
+                }
+                else
+                {
+                    execute(refer_statement{
+                                .m_tag = make_atom("root"),
+                                .m_file_path = make_atom(l_file),
+                            },
+                            make_nil());
+                }
             }
             catch (const std::runtime_error &l_err)
             {
                 std::cout << l_err.what() << std::endl;
                 exit(EXIT_FAILURE);
-                // we must exit after first failure, since
-                // cwd could be set to strange path, after exception is thrown
             }
 
+            // snapshot what the file declared and inferred in its own module, before it is cleared
+            if (l_export_stream.is_open())
+                unilog::export_theorems(make_list({make_atom("root")}), l_export_stream);
+
             // clear the database before next file begins execution
             wipe_database();
         }
+
+        if (l_stats)
+        {
+            const unilog::pool_statistics &l_pool = unilog::refer_pool_statistics();
+
+            std::cout << l_pool.m_ground_cells << " ground list cells in "
+                      << l_pool.m_pooled_cells << " distinct, "
+                      << l_pool.bytes_saved() << " bytes saved parsing; "
+                      << l_pool.m_cells - l_pool.m_distinct_cells << " of "
+                      << l_pool.m_cells << " prolog list cells shared, "
+                      << l_pool.prolog_bytes_saved() << " bytes saved" << std::endl;
+
+            unilog::module_cache_statistics l_cache = unilog::refer_cache_statistics();
+
+            std::cout << l_cache.m_hits << " refers from the module cache, "
+                      << l_cache.m_misses << " parsed, "
+                      << l_cache.m_bytes_saved << " bytes not parsed again, "
+                      << l_cache.m_bytes_kept << " bytes of source kept parsed" << std::endl;
+        }
     }
     catch (const CLI::ParseError &e)
     {
@@ -102,7 +230,8 @@ int main(int argc, char **argv)
     }
     catch (const std::exception &e)
     {
-        std::cout << e.what() << std::endl;
+        // with --lsp, stdout carries only protocol messages
+        (l_lsp ? std::cerr : std::cout) << e.what() << std::endl;
         return 1;
     }
 
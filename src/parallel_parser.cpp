@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "parallel_parser.hpp"
+#include "lexer.hpp"
+#include "scan.hpp"
+
+// parses the statements of a_text in [a_begin, a_end), stopping early once
+//     a statement ends at or past a_stop_after. the chunk then ends there.
+static std::unique_ptr<unilog::parsed_chunk> parse_chunk(std::string_view a_text, size_t a_begin, size_t a_end, size_t a_stop_after)
+{
+    auto l_result = std::make_unique<unilog::parsed_chunk>();
+
+    l_result->m_begin = a_begin;
+    l_result->m_end = a_end;
+
+    unilog::lexer l_lexer(a_text.substr(a_begin, a_end - a_begin), a_begin);
+
+    try
+    {
+        unilog::ast_statement l_statement;
+
+        while (unilog::parse_statement(l_lexer, l_result->m_arena, l_statement))
+        {
+            l_result->m_statements.push_back(l_statement);
+
+            if (l_statement.m_span.m_end >= a_stop_after)
+            {
+                l_result->m_end = l_statement.m_span.m_end;
+                break;
+            }
+        }
+    }
+    catch (const std::exception &l_err)
+    {
+        l_result->m_error = unilog::parse_error{
+            .m_offset = l_lexer.offset(),
+            .m_message = l_err.what(),
+        };
+    }
+
+    return l_result;
+}
+
+// whether a chunk parsed cleanly, its last statement ending where the chunk does
+static bool ends_cleanly(const unilog::parsed_chunk &a_chunk)
+{
+    return !a_chunk.m_error &&
+           !a_chunk.m_statements.empty() &&
+           a_chunk.m_statements.back().m_span.m_end == a_chunk.m_end;
+}
+
+namespace unilog
+{
+
+    std::vector<size_t> split_statements(std::string_view a_text, size_t a_chunk_size)
+    {
+        std::vector<size_t> l_result;
+
+        const char *l_begin = a_text.data();
+        const char *l_end = l_begin + a_text.size();
+
+        a_chunk_size = std::max<size_t>(1, a_chunk_size);
+
+        size_t l_last = 0;
+
+        while (a_text.size() - l_last > a_chunk_size)
+        {
+            /////////////////////////////////////////
+            // nothing but an escaped newline in a quote carries over a line
+            //     break, so assume a line begins outside of any statement's
+            //     quotes and comments. the split is just past the first ';'
+            //     from there.
+            /////////////////////////////////////////
+            const char *l_line = find_newline(l_begin + l_last + a_chunk_size, l_end);
+
+            if (l_line == l_end)
+                break;
+
+            const char *l_split = find_statement_end(l_line + 1, l_end);
+
+            // no chunk may be empty
+            if (l_split == l_end)
+                break;
+
+            l_last = l_split - l_begin;
+            l_result.push_back(l_last);
+        }
+
+        return l_result;
+    }
+
+    parallel_parser::parallel_parser(std::string_view a_text, size_t a_threads, size_t a_chunk_size)
+        : m_text(a_text),
+          m_chunk_size(a_chunk_size)
+    {
+        m_bounds.push_back(0);
+
+        for (size_t l_split : split_statements(a_text, a_chunk_size))
+            m_bounds.push_back(l_split);
+
+        m_bounds.push_back(a_text.size());
+
+        size_t l_chunk_count = m_bounds.size() - 1;
+
+        m_parsed.resize(l_chunk_count);
+
+        // enough parsed ahead to keep every worker busy, but no more
+        m_window = 2 * std::max<size_t>(1, a_threads);
+
+        if (a_threads < 2 || l_chunk_count < 2)
+            return;
+
+        for (size_t i = 0; i < std::min(a_threads, l_chunk_count); ++i)
+            m_workers.emplace_back([this]()
+                                   { work(); });
+    }
+
+    parallel_parser::~parallel_parser()
+    {
+        stop();
+    }
+
+    void parallel_parser::work()
+    {
+        size_t l_chunk_count = m_bounds.size() - 1;
+
+        for (;;)
+        {
+            size_t l_index;
+
+            {
+                std::unique_lock l_lock(m_mutex);
+
+                m_taken_changed.wait(l_lock, [this, l_chunk_count]()
+                                     { return m_stopping ||
+                                              m_next_claim >= l_chunk_count ||
+                                              m_next_claim < m_next_taken + m_window; });
+
+                if (m_stopping || m_next_claim >= l_chunk_count)
+                    return;
+
+                l_index = m_next_claim++;
+            }
+
+            std::unique_ptr<parsed_chunk> l_chunk =
+                parse_chunk(m_text, m_bounds[l_index], m_bounds[l_index + 1], SIZE_MAX);
+
+            {
+                std::lock_guard l_lock(m_mutex);
+                m_parsed[l_index] = std::move(l_chunk);
+            }
+
+            m_parsed_changed.notify_all();
+        }
+    }
+
+    void parallel_parser::stop()
+    {
+        {
+            std::lock_guard l_lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_taken_changed.notify_all();
+
+        for (std::thread &l_worker : m_workers)
+            l_worker.join();
+
+        m_workers.clear();
+    }
+
+    std::unique_ptr<parsed_chunk> parallel_parser::next()
+    {
+        /////////////////////////////////////////
+        // after a bad split, parse the rest in order, a chunk at a time
+        /////////////////////////////////////////
+        if (m_sequential_from)
+        {
+            std::unique_ptr<parsed_chunk> l_chunk =
+                parse_chunk(m_text, *m_sequential_from, m_text.size(), *m_sequential_from + m_chunk_size);
+
+            m_sequential_from = l_chunk->m_error ? m_text.size() : l_chunk->m_end;
+
+            if (l_chunk->m_statements.empty() && !l_chunk->m_error)
+                return nullptr;
+
+            return l_chunk;
+        }
+
+        size_t l_chunk_count = m_bounds.size() - 1;
+
+        if (m_next_taken >= l_chunk_count)
+            return nullptr;
+
+        size_t l_index = m_next_taken;
+
+        std::unique_ptr<parsed_chunk> l_chunk;
+
+        if (m_workers.empty())
+        {
+            l_chunk = parse_chunk(m_text, m_bounds[l_index], m_bounds[l_index + 1], SIZE_MAX);
+        }
+        else
+        {
+            std::unique_lock l_lock(m_mutex);
+
+            m_parsed_changed.wait(l_lock, [this, l_index]()
+                                  { return m_parsed[l_index] != nullptr; });
+
+            l_chunk = std::move(m_parsed[l_index]);
+        }
+
+        {
+            std::lock_guard l_lock(m_mutex);
+            ++m_next_taken;
+        }
+
+        m_taken_changed.notify_all();
+
+        /////////////////////////////////////////
+        // the chunk began on a statement boundary, as the ones before it
+        //     ended cleanly. unless it does too, the next split is suspect
+        //     (or this chunk has a real error): start over from this chunk,
+        //     in order.
+        /////////////////////////////////////////
+        if (l_index + 1 < l_chunk_count && !ends_cleanly(*l_chunk))
+        {
+            stop();
+
+            m_sequential_from = m_bounds[l_index];
+
+            return next();
+        }
+
+        return l_chunk;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <string>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+// the statements of every chunk, with the error the parse ended on if any
+static std::pair<std::vector<unilog::span>, std::optional<unilog::parse_error>>
+parse_all(const std::string &a_text, size_t a_threads, size_t a_chunk_size)
+{
+    std::vector<unilog::span> l_spans;
+    std::optional<unilog::parse_error> l_error;
+
+    unilog::parallel_parser l_parser(a_text, a_threads, a_chunk_size);
+
+    while (std::unique_ptr<unilog::parsed_chunk> l_chunk = l_parser.next())
+    {
+        assert(!l_error);
+
+        for (const unilog::ast_statement &l_statement : l_chunk->m_statements)
+            l_spans.push_back(l_statement.m_span);
+
+        l_error = l_chunk->m_error;
+    }
+
+    return {l_spans, l_error};
+}
+
+////////////////////////////////
+//// TESTS
+////////////////////////////////
+
+static void test_split_statements()
+{
+    data_points<std::pair<std::string, size_t>, std::vector<size_t>> l_data_points =
+        {
+            {{"", 4}, {}},
+            {{"axiom a x;", 4}, {}},
+
+            // splits come after the ';' ending the statement at the next
+            //     line, leaving no chunk empty
+            {{"axiom a x;\naxiom b y;\naxiom c z;\n", 4}, {21}},
+            {{"axiom a x;\naxiom b y;\naxiom c z;\n", 12}, {32}},
+
+            // ';' in quotes and comments does not end a statement
+            {{"axiom a x;\naxiom b ';' # ;\n;\naxiom c z;\n", 4}, {28}},
+
+            // the split is a guess: a quote continued by an escaped
+            //     newline is taken for the start of a line
+            {{"axiom a 'x\\\n;';\naxiom b y;\n", 4}, {13}},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+        assert(unilog::split_statements(l_key.first, l_key.second) == l_value);
+}
+
+static void test_parallel_parser_order()
+{
+    std::string l_text;
+
+    for (size_t i = 0; i < 5000; ++i)
+        l_text += "axiom a" + std::to_string(i) + " [if 'q;" + std::to_string(i) + "' # ;\n p];\n";
+
+    /////////////////////////////////////////
+    // every statement comes back once, in order, however it is split
+    /////////////////////////////////////////
+    auto [l_expected, l_expected_error] = parse_all(l_text, 1, l_text.size());
+
+    assert(l_expected.size() == 5000);
+    assert(!l_expected_error);
+
+    for (size_t l_threads : {1, 2, 4})
+    {
+        for (size_t l_chunk_size : {1, 100, 4096, 1 << 20})
+        {
+            auto [l_spans, l_error] = parse_all(l_text, l_threads, l_chunk_size);
+
+            assert(!l_error);
+            assert(l_spans.size() == l_expected.size());
+
+            for (size_t i = 0; i < l_spans.size(); ++i)
+                assert(l_spans[i].m_begin == l_expected[i].m_begin && l_spans[i].m_end == l_expected[i].m_end);
+        }
+    }
+}
+
+static void test_parallel_parser_errors()
+{
+    /////////////////////////////////////////
+    // a parse error stops the parse where it would without splitting,
+    //     with every statement before it kept
+    /////////////////////////////////////////
+    std::string l_text;
+
+    for (size_t i = 0; i < 1000; ++i)
+        l_text += "axiom a" + std::to_string(i) + " x;\n";
+
+    size_t l_error_at = l_text.size();
+    l_text += "axiom bad [x;\n";
+
+    for (size_t i = 0; i < 1000; ++i)
+        l_text += "axiom b" + std::to_string(i) + " x;\n";
+
+    auto [l_expected, l_expected_error] = parse_all(l_text, 1, l_text.size());
+
+    assert(l_expected.size() == 1000);
+    assert(l_expected_error && l_expected_error->m_offset > l_error_at);
+
+    for (size_t l_threads : {1, 3})
+    {
+        for (size_t l_chunk_size : {1, 50, 1000})
+        {
+            auto [l_spans, l_error] = parse_all(l_text, l_threads, l_chunk_size);
+
+            assert(l_spans.size() == l_expected.size());
+            assert(l_error);
+            assert(l_error->m_offset == l_expected_error->m_offset);
+            assert(l_error->m_message == l_expected_error->m_message);
+        }
+    }
+}
+
+static void test_parallel_parser_bad_split()
+{
+    /////////////////////////////////////////
+    // quotes continued over escaped newlines, hiding ';' and '#' at the
+    //     start of lines, are still parsed as they would be in order
+    /////////////////////////////////////////
+    std::string l_text;
+
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        if (i % 7 == 0)
+            l_text += "axiom q" + std::to_string(i) + " 'a\\\n;b\\\n# c;';\n";
+        else
+            l_text += "axiom a" + std::to_string(i) + " x;\n";
+    }
+
+    auto [l_expected, l_expected_error] = parse_all(l_text, 1, l_text.size());
+
+    assert(l_expected.size() == 2000);
+    assert(!l_expected_error);
+
+    for (size_t l_threads : {1, 2})
+    {
+        for (size_t l_chunk_size : {1, 64, 333})
+        {
+            auto [l_spans, l_error] = parse_all(l_text, l_threads, l_chunk_size);
+
+            assert(!l_error);
+            assert(l_spans.size() == l_expected.size());
+
+            for (size_t i = 0; i < l_spans.size(); ++i)
+                assert(l_spans[i].m_begin == l_expected[i].m_begin && l_spans[i].m_end == l_expected[i].m_end);
+        }
+    }
+}
+
+void test_parallel_parser_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_split_statements);
+    TEST(test_parallel_parser_order);
+    TEST(test_parallel_parser_errors);
+    TEST(test_parallel_parser_bad_split);
+}
+
+#endif
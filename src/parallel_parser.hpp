@@ -0,0 +1,106 @@
+#ifndef PARALLEL_PARSER_HPP
+#define PARALLEL_PARSER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "ast.hpp"
+
+namespace unilog
+{
+
+    // where, and why, parsing stopped
+    struct parse_error
+    {
+        // offset into the text, as the lexer's position when it threw
+        size_t m_offset = 0;
+
+        std::string m_message;
+    };
+
+    // a run of whole statements of a text, parsed without prolog
+    struct parsed_chunk
+    {
+        // offsets of the chunk's text within the whole text
+        size_t m_begin = 0;
+        size_t m_end = 0;
+
+        ast_arena m_arena;
+        std::vector<ast_statement> m_statements;
+
+        // set if parsing stopped short of m_end. the statements parsed
+        //     before the error are kept.
+        std::optional<parse_error> m_error;
+    };
+
+    // offsets at which to split a_text into chunks of about a_chunk_size
+    //     bytes, each just past a ';'. the first chunk begins at 0, which is
+    //     not included. each split is found from the start of a line, with
+    //     quotes and comments skipped, so it is a guess: a quoted atom may
+    //     continue past an escaped newline. parallel_parser checks them.
+    std::vector<size_t> split_statements(std::string_view a_text, size_t a_chunk_size);
+
+    // parses a text in chunks on worker threads, handing the chunks back
+    //     in source order. a chunk is only trusted once the chunk before it
+    //     has parsed cleanly and ended on its first byte. if one did not, the
+    //     workers are stopped and the rest of the text is parsed in order on
+    //     the calling thread, so errors are reported just as they would be
+    //     without splitting.
+    class parallel_parser
+    {
+    public:
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+    private:
+        std::string_view m_text;
+        size_t m_chunk_size;
+
+        // where each chunk begins, and the end of the text last
+        std::vector<size_t> m_bounds;
+
+        // parsed chunks waiting to be taken, by index
+        std::vector<std::unique_ptr<parsed_chunk>> m_parsed;
+
+        // the next chunk to claim, and to hand back
+        size_t m_next_claim = 0;
+        size_t m_next_taken = 0;
+
+        // workers parse at most this many chunks ahead of the consumer
+        size_t m_window;
+
+        bool m_stopping = false;
+
+        std::mutex m_mutex;
+        std::condition_variable m_parsed_changed;
+        std::condition_variable m_taken_changed;
+
+        std::vector<std::thread> m_workers;
+
+        // once set, the rest of the text is parsed on the calling thread
+        //     from this offset
+        std::optional<size_t> m_sequential_from;
+
+        void work();
+        void stop();
+
+    public:
+        // with fewer than two threads, chunks are parsed as they are taken
+        parallel_parser(std::string_view a_text, size_t a_threads, size_t a_chunk_size = DEFAULT_CHUNK_SIZE);
+        ~parallel_parser();
+
+        parallel_parser(const parallel_parser &) = delete;
+        parallel_parser &operator=(const parallel_parser &) = delete;
+
+        // the next chunk in source order, or nullptr after the last one.
+        //     after a chunk with an error, there are no more.
+        std::unique_ptr<parsed_chunk> next();
+    };
+
+}
+
+#endif
@@ -1,7 +1,10 @@
 #include <iterator>
 #include <algorithm>
 #include <iostream>
-#include <random>
+#include <map>
+#include <vector>
+#include <optional>
+#include <functional>
 
 #include "parser.hpp"
 #include "lexer.hpp"
@@ -16,300 +19,337 @@
 namespace unilog
 {
 
-    static std::istream &extract_term_t(std::istream &a_istream, std::map<std::string, term_t> &a_var_alist, term_t a_term_t, bool *a_list_terminated = nullptr)
+    // the prolog atom for a symbol. each atom is created once per symbol,
+    //     after which it costs an array index. the reference handed out by
+    //     PL_new_atom_nchars is kept by the cache for good, so the atoms are
+    //     never garbage collected out from under it.
+    //     only called from the thread which owns the prolog engine.
+    static atom_t symbol_atom(symbol a_symbol)
     {
-        // we assume a_term_t is already assigned to PL_new_term_ref()
+        static std::vector<atom_t> s_atoms;
 
-        lexeme l_lexeme;
+        if (a_symbol.id() >= s_atoms.size())
+            s_atoms.resize(a_symbol.id() + 1, 0);
 
-        // Try to extract a lexeme.
-        a_istream >> l_lexeme;
+        atom_t &l_atom = s_atoms[a_symbol.id()];
 
-        // NOTE:
-        //     here, we cannot check !good(), because EOFbit might be set due to peek()ing EOF
-        //     in the lexer. Instead, check for failure to extract.
-        if (a_istream.fail())
-            return a_istream;
-
-        if (std::holds_alternative<atom>(l_lexeme))
+        if (l_atom == 0)
         {
-            const atom &l_atom = std::get<atom>(l_lexeme);
+            std::string_view l_text = a_symbol.text();
+            l_atom = PL_new_atom_nchars(l_text.size(), l_text.data());
+        }
 
-            /////////////////////////////////////////
-            // try to bind the term to an atom with specific text
-            /////////////////////////////////////////
-            if (!PL_put_atom_chars(a_term_t, l_atom.m_text.c_str()))
+        return l_atom;
+    }
+
+    // unifies a_target with a term that is not a cons
+    static void unify_leaf(term_t a_target, const ast_term &a_term, term_t a_variables)
+    {
+        switch (a_term.m_kind)
+        {
+        case ast_term::kind::nil:
+        {
+            if (!PL_unify_nil(a_target))
+                throw std::runtime_error(ERR_MSG_PUT_NIL);
+        }
+        break;
+        case ast_term::kind::atom:
+        {
+            if (!PL_unify_atom(a_target, symbol_atom(a_term.text())))
                 throw std::runtime_error(ERR_MSG_PUT_ATOM_CHARS);
         }
-        else if (std::holds_alternative<variable>(l_lexeme))
+        break;
+        case ast_term::kind::variable:
         {
-            const variable &l_variable = std::get<variable>(l_lexeme);
+            if (!PL_unify(a_target, a_variables + a_term.m_id))
+                throw std::runtime_error(ERR_MSG_UNIFY);
+        }
+        break;
+        case ast_term::kind::fresh_variable:
+        case ast_term::kind::cons:
+            // the target is already a fresh variable
+            break;
+        }
+    }
 
-            // singletons never get entries in the table
-            if (l_variable.m_identifier == "_")
-                return a_istream;
+    // the term refs of a statement being built: one per variable, and one
+    //     per ground list it shares, each by index
+    struct statement_refs
+    {
+        term_t m_variables;
 
-            /////////////////////////////////////////
-            // see if this variable already has entry
-            /////////////////////////////////////////
-            auto l_alist_entry = a_var_alist.find(l_variable.m_identifier);
+        const ast_shared_list *m_shared = nullptr;
+        uint32_t m_shared_count = 0;
+        term_t m_shared_refs = 0;
+    };
 
-            /////////////////////////////////////////
-            // no entry exists, create one
-            /////////////////////////////////////////
-            if (l_alist_entry == a_var_alist.end())
-                l_alist_entry = a_var_alist.insert({l_variable.m_identifier, PL_new_term_ref()}).first;
+    // the term ref of a_cons, if it is one of the statement's shared lists.
+    //     the ref stays unbound until the list is first built into it.
+    static std::optional<term_t> shared_ref(const statement_refs &a_refs, const ast_cons *a_cons)
+    {
+        if (a_refs.m_shared_count == 0)
+            return std::nullopt;
 
-            /////////////////////////////////////////
-            // unify current term with entry
-            /////////////////////////////////////////
-            if (!PL_unify(a_term_t, l_alist_entry->second))
-                throw std::runtime_error(ERR_MSG_UNIFY);
-        }
-        else if (std::holds_alternative<list_open>(l_lexeme))
+        const ast_shared_list *l_end = a_refs.m_shared + a_refs.m_shared_count;
+
+        const ast_shared_list *l_entry = std::lower_bound(
+            a_refs.m_shared, l_end, a_cons,
+            [](const ast_shared_list &a_entry, const ast_cons *a_cons)
+            { return std::less<const ast_cons *>()(a_entry.m_cons, a_cons); });
+
+        if (l_entry == l_end || l_entry->m_cons != a_cons)
+            return std::nullopt;
+
+        return a_refs.m_shared_refs + (l_entry - a_refs.m_shared);
+    }
+
+    // unifies a_target, an unbound variable, with the prolog term of a_term.
+    //     lists are built in order, by unifying a running tail with each
+    //     cell. the lists still open are kept on an explicit stack, each
+    //     holding two term refs until its tail is reached. a shared list is
+    //     built the first time it is met, and reused after that.
+    static void unify_term(term_t a_target, const ast_term &a_term, const statement_refs &a_refs)
+    {
+        struct open_list
         {
-            std::list<term_t> l_list;
+            term_t m_tail;
+            term_t m_head;
 
-            // initialize flag for list termination
-            bool l_list_terminated = false;
+            // the rest of the list, still to be unified with m_tail
+            const ast_term *m_rest;
+        };
 
-            // extract until failure, this does NOT have to come from
-            //     eof. It will come from any list termination process.
-            //     we supply a_term_t as the list tail reference, because
-            //     we will build the list in reverse order, starting from the tail.
-            while (!l_list_terminated)
-            {
-                term_t l_sub_term = PL_new_term_ref();
+        // kept across calls, so that its capacity is reused
+        static thread_local std::vector<open_list> s_open;
 
-                /////////////////////////////////////////
-                // extract one subterm. final subterm will be the list's tail
-                /////////////////////////////////////////
-                extract_term_t(a_istream, a_var_alist, l_sub_term, &l_list_terminated);
+        s_open.clear();
 
-                if (a_istream.fail())
-                    throw std::runtime_error(ERR_MSG_NO_LIST_CLOSE);
+        term_t l_target = a_target;
+        const ast_term *l_term = &a_term;
 
-                l_list.push_back(l_sub_term);
-            }
+        for (;;)
+        {
+            if (l_term->m_kind == ast_term::kind::cons)
+            {
+                bool l_build = true;
 
-            /////////////////////////////////////////
-            // extract the tail of the list
-            /////////////////////////////////////////
-            if (!PL_unify(a_term_t, l_list.back()))
-                throw std::runtime_error(ERR_MSG_UNIFY);
-            l_list.pop_back();
+                if (std::optional<term_t> l_shared = shared_ref(a_refs, l_term->m_cons))
+                {
+                    l_build = PL_is_variable(*l_shared);
 
-            /////////////////////////////////////////
-            // build list in reverse order
-            /////////////////////////////////////////
-            for (auto l_it = l_list.rbegin(); l_it != l_list.rend(); l_it++)
+                    if (!PL_unify(l_target, *l_shared))
+                        throw std::runtime_error(ERR_MSG_UNIFY);
+                }
+
+                if (l_build)
+                {
+                    term_t l_tail = PL_copy_term_ref(l_target);
+                    s_open.push_back({l_tail, PL_new_term_ref(), l_term});
+                }
+            }
+            else
             {
-                if (!PL_cons_list(a_term_t, *l_it, a_term_t))
-                    throw std::runtime_error(ERR_MSG_CONS_LIST);
+                unify_leaf(l_target, *l_term, a_refs.m_variables);
             }
-        }
-        else if (std::holds_alternative<list_close>(l_lexeme))
-        {
-            // this basically checks if the list termination was expected
-            if (a_list_terminated == nullptr)
-                throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
 
             /////////////////////////////////////////
-            // default tail is always nil
+            // move on to the next head of the innermost open list,
+            //     closing off the lists which have run out
             /////////////////////////////////////////
-            if (!PL_put_nil(a_term_t))
-                throw std::runtime_error(ERR_MSG_PUT_NIL);
+            for (;;)
+            {
+                if (s_open.empty())
+                    return;
 
-            /////////////////////////////////////////
-            // notify the caller the list terminated
-            /////////////////////////////////////////
-            *a_list_terminated = true;
+                open_list &l_list = s_open.back();
+
+                bool l_more = l_list.m_rest->m_kind == ast_term::kind::cons;
+
+                /////////////////////////////////////////
+                // the rest of the list may be a shared list itself
+                /////////////////////////////////////////
+                if (l_more)
+                {
+                    if (std::optional<term_t> l_shared = shared_ref(a_refs, l_list.m_rest->m_cons))
+                    {
+                        l_more = PL_is_variable(*l_shared);
+
+                        if (!PL_unify(l_list.m_tail, *l_shared))
+                            throw std::runtime_error(ERR_MSG_UNIFY);
+                    }
+                }
+                else
+                {
+                    unify_leaf(l_list.m_tail, *l_list.m_rest, a_refs.m_variables);
+                }
+
+                if (l_more)
+                {
+                    if (!PL_unify_list(l_list.m_tail, l_list.m_head, l_list.m_tail))
+                        throw std::runtime_error(ERR_MSG_CONS_LIST);
+
+                    l_target = l_list.m_head;
+                    l_term = &l_list.m_rest->m_cons->m_head;
+                    l_list.m_rest = &l_list.m_rest->m_cons->m_tail;
+
+                    break;
+                }
+
+                // release the refs of this list, and of any lists inside it
+                PL_reset_term_refs(l_list.m_tail);
+
+                s_open.pop_back();
+            }
         }
-        else if (std::holds_alternative<list_separator>(l_lexeme))
-        {
-            // this basically checks if the list termination was expected
-            if (a_list_terminated == nullptr)
-                throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
+    }
 
-            /////////////////////////////////////////
-            // extract the tail of the list.
-            // could be var or atom, or any expr
-            /////////////////////////////////////////
-            extract_term_t(a_istream, a_var_alist, a_term_t);
+    // builds the prolog term of a_term into a_result
+    static void put_term(term_t a_result, const ast_term &a_term, const statement_refs &a_refs)
+    {
+        if (!PL_put_variable(a_result))
+            throw std::runtime_error(ERR_MSG_UNIFY);
 
-            /////////////////////////////////////////
-            // finally, extract the list_close
-            /////////////////////////////////////////
-            lexeme l_list_close;
-            a_istream >> l_list_close;
+        unify_term(a_result, a_term, a_refs);
+    }
 
-            if (a_istream.fail() || !std::holds_alternative<list_close>(l_list_close))
-                throw std::runtime_error(ERR_MSG_NO_LIST_CLOSE);
+    statement make_statement(const ast_statement &a_statement)
+    {
+        /////////////////////////////////////////
+        // one term ref per variable, shared by all of its occurrences
+        //     (must always declare at least 1)
+        /////////////////////////////////////////
+        statement_refs l_refs = {
+            .m_variables = PL_new_term_refs(std::max<uint32_t>(1, a_statement.m_variable_count)),
+        };
 
-            /////////////////////////////////////////
-            // notify the caller the list terminated
-            /////////////////////////////////////////
-            *a_list_terminated = true;
+        /////////////////////////////////////////
+        // and one per list the statement shares, so each is built once
+        /////////////////////////////////////////
+        if (a_statement.m_shared_count > 0)
+        {
+            l_refs.m_shared = a_statement.m_shared;
+            l_refs.m_shared_count = a_statement.m_shared_count;
+            l_refs.m_shared_refs = PL_new_term_refs(a_statement.m_shared_count);
         }
-        else
+
+        term_t l_tag = PL_new_term_ref();
+        term_t l_body = PL_new_term_ref();
+
+        put_term(l_tag, a_statement.m_tag, l_refs);
+        put_term(l_body, a_statement.m_body, l_refs);
+
+        switch (a_statement.m_kind)
         {
-            // failed to extract prolog expression
-            throw std::runtime_error(ERR_MSG_MALFORMED_TERM);
+        case ast_statement::kind::axiom:
+            return axiom_statement{.m_tag = l_tag, .m_theorem = l_body, .m_span = a_statement.m_span};
+        case ast_statement::kind::redir:
+            return redir_statement{.m_tag = l_tag, .m_guide = l_body, .m_span = a_statement.m_span};
+        case ast_statement::kind::infer:
+            return infer_statement{.m_tag = l_tag, .m_guide = l_body, .m_span = a_statement.m_span};
+        case ast_statement::kind::refer:
+            return refer_statement{.m_tag = l_tag, .m_file_path = l_body, .m_span = a_statement.m_span};
         }
 
-        return a_istream;
+        throw std::runtime_error(ERR_MSG_INVALID_COMMAND);
     }
 
     bool operator==(const axiom_statement &a_lhs, const axiom_statement &a_rhs)
     {
-        fid_t l_frame = PL_open_foreign_frame();
-
-        bool l_result = equal_forms(a_lhs.m_tag, a_rhs.m_tag) &&
-                        equal_forms(a_lhs.m_theorem, a_rhs.m_theorem);
-
-        PL_discard_foreign_frame(l_frame);
-
-        return l_result;
+        return equal_forms({{a_lhs.m_tag, a_rhs.m_tag},
+                            {a_lhs.m_theorem, a_rhs.m_theorem}});
     }
 
     bool operator==(const redir_statement &a_lhs, const redir_statement &a_rhs)
     {
-        fid_t l_frame = PL_open_foreign_frame();
-
-        bool l_result = equal_forms(a_lhs.m_tag, a_rhs.m_tag) &&
-                        equal_forms(a_lhs.m_guide, a_rhs.m_guide);
-
-        PL_discard_foreign_frame(l_frame);
-
-        return l_result;
+        return equal_forms({{a_lhs.m_tag, a_rhs.m_tag},
+                            {a_lhs.m_guide, a_rhs.m_guide}});
     }
 
     bool operator==(const infer_statement &a_lhs, const infer_statement &a_rhs)
     {
-        fid_t l_frame = PL_open_foreign_frame();
-
-        bool l_result = equal_forms(a_lhs.m_tag, a_rhs.m_tag) &&
-                        equal_forms(a_lhs.m_guide, a_rhs.m_guide);
-
-        PL_discard_foreign_frame(l_frame);
-
-        return l_result;
+        return equal_forms({{a_lhs.m_tag, a_rhs.m_tag},
+                            {a_lhs.m_guide, a_rhs.m_guide}});
     }
 
     bool operator==(const refer_statement &a_lhs, const refer_statement &a_rhs)
     {
-        fid_t l_frame = PL_open_foreign_frame();
-
-        bool l_result = equal_forms(a_lhs.m_tag, a_rhs.m_tag) &&
-                        equal_forms(a_lhs.m_file_path, a_rhs.m_file_path);
-
-        PL_discard_foreign_frame(l_frame);
-
-        return l_result;
+        return equal_forms({{a_lhs.m_tag, a_rhs.m_tag},
+                            {a_lhs.m_file_path, a_rhs.m_file_path}});
     }
 
-    std::istream &operator>>(std::istream &a_istream, statement &a_statement)
+#ifdef UNIT_TEST
+
+    // extracts a single term, naming its variables through a_var_alist.
+    //     statements are extracted whole, so only the tests use this.
+    static std::istream &extract_term_t(std::istream &a_istream, unilog::variable_table<term_t> &a_var_alist, term_t a_term_t)
     {
-        /////////////////////////////////////////
-        // extract the command lexeme
-        /////////////////////////////////////////
-        lexeme l_command;
-        a_istream >> l_command;
+        ast_arena l_arena;
+        std::vector<symbol> l_names;
+        ast_term l_term;
 
-        // if we fail to extract lexeme, gracefully return
-        if (a_istream.fail())
+        if (!parse_term(a_istream, l_arena, l_names, l_term))
             return a_istream;
 
-        // atom is expected for the command
-        if (!std::holds_alternative<atom>(l_command))
-            throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
-
-        std::string l_command_text = std::get<atom>(l_command).m_text;
-
         /////////////////////////////////////////
-        // declare the variable association-list
+        // the variables must be contiguous, so the alist entries are
+        //     copied into (or created from) a block of term refs
         /////////////////////////////////////////
-        std::map<std::string, term_t> l_var_alist;
+        term_t l_variables = PL_new_term_refs(std::max<size_t>(1, l_names.size()));
 
-        if (l_command_text == "axiom")
+        for (size_t i = 0; i < l_names.size(); ++i)
         {
-            axiom_statement l_result;
-
-            /////////////////////////////////////////
-            // creates new term refs
-            /////////////////////////////////////////
-            l_result.m_tag = PL_new_term_ref();
-            l_result.m_theorem = PL_new_term_ref();
-
-            if (!(extract_term_t(a_istream, l_var_alist, l_result.m_tag) &&
-                  extract_term_t(a_istream, l_var_alist, l_result.m_theorem)))
-                throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+            auto [l_entry, l_inserted] = a_var_alist.try_emplace(l_names[i], l_variables + i);
 
-            a_statement = l_result;
+            if (!l_inserted && !PL_put_term(l_variables + i, *l_entry))
+                throw std::runtime_error(ERR_MSG_UNIFY);
         }
-        else if (l_command_text == "redir")
-        {
-            redir_statement l_result;
 
-            /////////////////////////////////////////
-            // creates new term refs
-            /////////////////////////////////////////
-            l_result.m_tag = PL_new_term_ref();
-            l_result.m_guide = PL_new_term_ref();
+        put_term(a_term_t, l_term, {.m_variables = l_variables});
 
-            if (!(extract_term_t(a_istream, l_var_alist, l_result.m_tag) &&
-                  extract_term_t(a_istream, l_var_alist, l_result.m_guide)))
-                throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+        return a_istream;
+    }
 
-            a_statement = l_result;
-        }
-        else if (l_command_text == "infer")
-        {
-            infer_statement l_result;
+#endif
 
-            /////////////////////////////////////////
-            // creates new term refs
-            /////////////////////////////////////////
-            l_result.m_tag = PL_new_term_ref();
-            l_result.m_guide = PL_new_term_ref();
+    // the lexeme source may be a std::istream or a unilog::lexer.
+    template <typename Source>
+    static Source &extract_statement(Source &a_source, statement &a_statement, ast_pool *a_pool = nullptr)
+    {
+        /////////////////////////////////////////
+        // parse natively, then build the prolog terms in one pass. the
+        //     arena only holds one statement at a time, so it is reused.
+        /////////////////////////////////////////
+        static thread_local ast_arena s_arena;
 
-            if (!(extract_term_t(a_istream, l_var_alist, l_result.m_tag) &&
-                  extract_term_t(a_istream, l_var_alist, l_result.m_guide)))
-                throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+        s_arena.clear();
 
-            a_statement = l_result;
-        }
-        else if (l_command_text == "refer")
-        {
-            refer_statement l_result;
+        ast_statement l_parsed;
 
-            /////////////////////////////////////////
-            // creates new term refs
-            /////////////////////////////////////////
-            l_result.m_tag = PL_new_term_ref();
-            l_result.m_file_path = PL_new_term_ref();
+        // if we fail to extract a statement, gracefully return
+        if (!parse_statement(a_source, s_arena, l_parsed))
+            return a_source;
 
-            if (!(extract_term_t(a_istream, l_var_alist, l_result.m_tag) &&
-                  extract_term_t(a_istream, l_var_alist, l_result.m_file_path)))
-                throw std::runtime_error(ERR_MSG_MALFORMED_STMT);
+        if (a_pool != nullptr)
+            a_pool->intern(l_parsed, s_arena);
 
-            a_statement = l_result;
-        }
-        else
-        {
-            throw std::runtime_error(ERR_MSG_INVALID_COMMAND);
-        }
+        a_statement = make_statement(l_parsed);
 
-        /////////////////////////////////////////
-        // extracts the expected eol character.
-        /////////////////////////////////////////
-        lexeme l_eol;
-        a_istream >> l_eol;
+        return a_source;
+    }
 
-        if (a_istream.fail() || !std::holds_alternative<eol>(l_eol))
-            throw std::runtime_error(ERR_MSG_NO_EOL);
+    std::istream &operator>>(std::istream &a_istream, statement &a_statement)
+    {
+        return extract_statement(a_istream, a_statement);
+    }
 
-        return a_istream;
+    lexer &operator>>(lexer &a_lexer, statement &a_statement)
+    {
+        return extract_statement(a_lexer, a_statement);
+    }
+
+    lexer &extract_statement(lexer &a_lexer, statement &a_statement, ast_pool &a_pool)
+    {
+        return extract_statement(a_lexer, a_statement, &a_pool);
     }
 
 }
@@ -328,7 +368,7 @@ term_t make_nil()
 term_t make_atom(const std::string &a_text)
 {
     term_t l_result = PL_new_term_ref();
-    PL_put_atom_chars(l_result, a_text.c_str());
+    PL_put_atom(l_result, unilog::symbol_atom(a_text));
     return l_result;
 }
 
@@ -336,20 +376,27 @@ term_t make_list(const std::list<term_t> &a_elements, term_t a_tail)
 {
     term_t l_result = PL_new_term_ref();
 
-    if (!PL_unify(l_result, a_tail))
-        throw std::runtime_error("Error: failed to unify terms.");
+    /////////////////////////////////////////
+    // build the list front to back, unifying a running tail with each cell
+    /////////////////////////////////////////
+    term_t l_tail = PL_copy_term_ref(l_result);
+    term_t l_head = PL_new_term_ref();
 
-    for (auto l_it = a_elements.rbegin(); l_it != a_elements.rend(); l_it++)
+    for (term_t l_element : a_elements)
     {
-        // just toss it into an assertion, since we want it to always succeed.
-        if (!PL_cons_list(l_result, *l_it, l_result))
+        if (!PL_unify_list(l_tail, l_head, l_tail) || !PL_unify(l_head, l_element))
             throw std::runtime_error("Error: failed to unify terms.");
     }
 
+    if (!PL_unify(l_tail, a_tail))
+        throw std::runtime_error("Error: failed to unify terms.");
+
+    PL_reset_term_refs(l_tail);
+
     return l_result;
 }
 
-term_t make_var(const std::string &a_identifier, std::map<std::string, term_t> &a_var_alist)
+term_t make_var(const std::string &a_identifier, unilog::variable_table<term_t> &a_var_alist)
 {
     term_t l_result = PL_new_term_ref();
 
@@ -358,50 +405,25 @@ term_t make_var(const std::string &a_identifier, std::map<std::string, term_t> &
         return l_result;
 
     /////////////////////////////////////////
-    // see if this variable already has entry
+    // the first occurrence of a name creates its entry
     /////////////////////////////////////////
-    auto l_entry = a_var_alist.find(a_identifier);
+    auto [l_entry, l_inserted] = a_var_alist.try_emplace(a_identifier, l_result);
 
     /////////////////////////////////////////
-    // no entry exists
+    // later occurrences share the first one's variable
     /////////////////////////////////////////
-    if (l_entry == a_var_alist.end())
-        l_entry = a_var_alist.insert({a_identifier, l_result}).first;
-
-    /////////////////////////////////////////
-    // entry already exists;
-    /////////////////////////////////////////
-    if (!PL_unify(l_result, l_entry->second))
+    if (!l_inserted && !PL_unify(l_result, *l_entry))
         throw std::runtime_error("Error: failed to unify terms.");
 
     return l_result;
 }
 
-static std::string random_string(size_t a_length)
+bool equal_forms(term_t a_lhs, term_t a_rhs)
 {
-    // Character set: alphanumeric (you can customize this)
-    static const std::string s_chars =
-        "abcdefghijklmnopqrstuvwxyz"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "0123456789";
-
-    // Random number generator
-    static std::random_device s_rd;          // Seed
-    static std::mt19937 s_generator(s_rd()); // Random-number engine
-    static std::uniform_int_distribution<> s_distribution(0, s_chars.size() - 1);
-
-    // Generate random string
-    std::string l_result;
-
-    for (size_t i = 0; i < a_length; ++i)
-    {
-        l_result += s_chars[s_distribution(s_generator)];
-    }
-
-    return l_result;
+    return equal_forms({{a_lhs, a_rhs}});
 }
 
-bool equal_forms(term_t a_lhs, term_t a_rhs)
+bool equal_forms(std::initializer_list<std::pair<term_t, term_t>> a_pairs)
 {
     // Formal equivalence is different than ability to unify,
     //     and is different than PL_compare() == 0.
@@ -423,78 +445,275 @@ bool equal_forms(term_t a_lhs, term_t a_rhs)
     //     [A A A]
     //
 
-    if (PL_get_nil(a_lhs) && PL_get_nil(a_rhs))
-    {
-        /////////////////////////////////////////
-        // nil is universal
-        /////////////////////////////////////////
-        return true;
-    }
+    /////////////////////////////////////////
+    // pairs of terms still to compare, as blocks of two term refs.
+    //     list spines are walked in place, while heads wait on the stack.
+    //     blocks of pairs already compared are reused, so the refs held
+    //     are bounded by the nesting depth and the number of variables.
+    /////////////////////////////////////////
+    term_t l_base = PL_new_term_refs(2 * std::max<size_t>(1, a_pairs.size()));
 
-    if (PL_is_atom(a_lhs) && PL_is_atom(a_rhs))
+    std::vector<term_t> l_pending;
+    std::vector<term_t> l_free;
+
+    // the first pair is compared first
+    for (size_t i = a_pairs.size(); i-- > 0;)
     {
-        /////////////////////////////////////////
-        // simply compare the atoms
-        /////////////////////////////////////////
-        return PL_compare(a_lhs, a_rhs) == 0;
+        const auto &[l_lhs, l_rhs] = a_pairs.begin()[i];
+
+        if (!PL_put_term(l_base + 2 * i, l_lhs) || !PL_put_term(l_base + 2 * i + 1, l_rhs))
+        {
+            PL_reset_term_refs(l_base);
+            return false;
+        }
+
+        l_pending.push_back(l_base + 2 * i);
     }
 
-    if (PL_is_list(a_lhs) && PL_is_list(a_rhs))
+    /////////////////////////////////////////
+    // the bijection between the variables seen on each side. nothing is
+    //     ever bound, so the terms are left as they were.
+    /////////////////////////////////////////
+    std::map<term_t, term_t, variable_order> l_lhs_to_rhs;
+    std::map<term_t, term_t, variable_order> l_rhs_to_lhs;
+
+    bool l_result = true;
+
+    while (l_result && !l_pending.empty())
     {
-        term_t l_lhs_car = PL_new_term_ref();
-        term_t l_lhs_cdr = PL_new_term_ref();
-        if (!PL_get_list(a_lhs, l_lhs_car, l_lhs_cdr))
-            return false;
+        term_t l_lhs = l_pending.back();
+        term_t l_rhs = l_lhs + 1;
 
-        term_t l_rhs_car = PL_new_term_ref();
-        term_t l_rhs_cdr = PL_new_term_ref();
-        if (!PL_get_list(a_rhs, l_rhs_car, l_rhs_cdr))
-            return false;
+        if (PL_get_nil(l_lhs) && PL_get_nil(l_rhs))
+        {
+            /////////////////////////////////////////
+            // nil is universal
+            /////////////////////////////////////////
+        }
+        else if (PL_is_atom(l_lhs) && PL_is_atom(l_rhs))
+        {
+            /////////////////////////////////////////
+            // simply compare the atoms
+            /////////////////////////////////////////
+            l_result = PL_compare(l_lhs, l_rhs) == 0;
+        }
+        else if (PL_is_list(l_lhs) && PL_is_list(l_rhs))
+        {
+            /////////////////////////////////////////
+            // compare the cars next, then come back to the cdrs
+            /////////////////////////////////////////
+            term_t l_cars;
+
+            if (l_free.empty())
+            {
+                l_cars = PL_new_term_refs(2);
+            }
+            else
+            {
+                l_cars = l_free.back();
+                l_free.pop_back();
+            }
+
+            l_result = PL_get_list(l_lhs, l_cars, l_lhs) &&
+                       PL_get_list(l_rhs, l_cars + 1, l_rhs);
+
+            l_pending.push_back(l_cars);
+            continue;
+        }
+        else if (PL_is_variable(l_lhs) && PL_is_variable(l_rhs))
+        {
+            auto l_lhs_entry = l_lhs_to_rhs.find(l_lhs);
+            auto l_rhs_entry = l_rhs_to_lhs.find(l_rhs);
+
+            if (l_lhs_entry == l_lhs_to_rhs.end() && l_rhs_entry == l_rhs_to_lhs.end())
+            {
+                /////////////////////////////////////////
+                // neither has been seen, so they now correspond
+                /////////////////////////////////////////
+                term_t l_pair = PL_new_term_refs(2);
+
+                l_result = PL_put_term(l_pair, l_lhs) &&
+                           PL_put_term(l_pair + 1, l_rhs);
+
+                l_lhs_to_rhs.emplace(l_pair, l_pair + 1);
+                l_rhs_to_lhs.emplace(l_pair + 1, l_pair);
+            }
+            else
+            {
+                /////////////////////////////////////////
+                // otherwise, each must be the other's counterpart
+                /////////////////////////////////////////
+                l_result = l_lhs_entry != l_lhs_to_rhs.end() &&
+                           l_rhs_entry != l_rhs_to_lhs.end() &&
+                           PL_compare(l_lhs_entry->second, l_rhs) == 0;
+            }
+        }
+        else
+        {
+            l_result = false;
+        }
 
         /////////////////////////////////////////
-        // ensure both the cars and cdrs are formally equivalent
+        // this pair is done, and its refs free for the next
         /////////////////////////////////////////
-        return equal_forms(l_lhs_car, l_rhs_car) &&
-               equal_forms(l_lhs_cdr, l_rhs_cdr);
+        l_free.push_back(l_lhs);
+        l_pending.pop_back();
     }
 
-    if (PL_is_variable(a_lhs) && PL_is_variable(a_rhs))
+    PL_reset_term_refs(l_base);
+
+    return l_result;
+}
+
+/////////////////////////////////////////
+// canonical hashing: a term is hashed as the sequence of its nodes in
+//     prefix order, which determines the term, fed through a 64-bit mixer
+/////////////////////////////////////////
+
+enum class hash_node : uint64_t
+{
+    nil = 1,
+    atom,
+    variable,
+    cons,
+    integer,
+};
+
+static uint64_t mix_hash(uint64_t a_hash, uint64_t a_value)
+{
+    // the splitmix64 finalizer
+    uint64_t l_result = (a_hash ^ a_value) + 0x9e3779b97f4a7c15ull;
+
+    l_result = (l_result ^ (l_result >> 30)) * 0xbf58476d1ce4e5b9ull;
+    l_result = (l_result ^ (l_result >> 27)) * 0x94d049bb133111ebull;
+
+    return l_result ^ (l_result >> 31);
+}
+
+// fnv-1a, so that an atom hashes the same in every process
+static uint64_t hash_text(const char *a_text, size_t a_length)
+{
+    uint64_t l_result = 0xcbf29ce484222325ull;
+
+    for (size_t i = 0; i < a_length; ++i)
+        l_result = (l_result ^ (unsigned char)a_text[i]) * 0x100000001b3ull;
+
+    return l_result;
+}
+
+uint64_t canonical_hash(term_t a_term)
+{
+    /////////////////////////////////////////
+    // terms still to hash. list spines are walked in place, so a cons
+    //     leaves its ref to the tail, under the head pushed above it.
+    //     refs of terms already hashed are reused.
+    /////////////////////////////////////////
+    term_t l_base = PL_copy_term_ref(a_term);
+
+    std::vector<term_t> l_pending = {l_base};
+    std::vector<term_t> l_free;
+
+    // variables, numbered by first occurrence
+    std::map<term_t, uint64_t, variable_order> l_variables;
+
+    uint64_t l_result = 0;
+
+    while (!l_pending.empty())
     {
-        constexpr int VAR_RANDOM_BIND_LEN = 50;
+        term_t l_term = l_pending.back();
 
-        /////////////////////////////////////////
-        // generate a random binding string.
-        // the purpose of this is the ensure that
-        // all instances of this variable assume this new value,
-        // which will reveal the difference in distribution
-        // of the lhs variable and rhs variable.
-        /////////////////////////////////////////
-        std::string l_random_string = random_string(VAR_RANDOM_BIND_LEN);
+        char *l_text;
+        size_t l_length;
+        int64_t l_integer;
 
-        /////////////////////////////////////////
-        // construct random atom
-        /////////////////////////////////////////
-        term_t l_random_atom = PL_new_term_ref();
-        if (!PL_put_atom_chars(l_random_atom, l_random_string.c_str()))
-            return false;
+        if (PL_get_nil(l_term))
+        {
+            l_result = mix_hash(l_result, (uint64_t)hash_node::nil);
+        }
+        else if (PL_get_atom_nchars(l_term, &l_length, &l_text))
+        {
+            l_result = mix_hash(l_result, (uint64_t)hash_node::atom);
+            l_result = mix_hash(l_result, hash_text(l_text, l_length));
+        }
+        else if (PL_is_pair(l_term))
+        {
+            term_t l_head;
 
-        /////////////////////////////////////////
-        // unify random atom into both vars
-        /////////////////////////////////////////
-        if (!PL_unify(l_random_atom, a_lhs))
-            return false;
-        if (!PL_unify(l_random_atom, a_rhs))
-            return false;
+            if (l_free.empty())
+            {
+                l_head = PL_new_term_ref();
+            }
+            else
+            {
+                l_head = l_free.back();
+                l_free.pop_back();
+            }
+
+            PL_get_list(l_term, l_head, l_term);
+
+            l_result = mix_hash(l_result, (uint64_t)hash_node::cons);
+
+            l_pending.push_back(l_head);
+            continue;
+        }
+        else if (PL_is_variable(l_term))
+        {
+            auto l_entry = l_variables.find(l_term);
+
+            if (l_entry == l_variables.end())
+                l_entry = l_variables.emplace(PL_copy_term_ref(l_term), l_variables.size()).first;
+
+            l_result = mix_hash(l_result, (uint64_t)hash_node::variable);
+            l_result = mix_hash(l_result, l_entry->second);
+        }
+        else if (PL_get_int64(l_term, &l_integer))
+        {
+            l_result = mix_hash(l_result, (uint64_t)hash_node::integer);
+            l_result = mix_hash(l_result, (uint64_t)l_integer);
+        }
+        else
+        {
+            PL_reset_term_refs(l_base);
+            throw std::runtime_error(ERR_MSG_HASH_TERM);
+        }
 
-        return true;
+        l_free.push_back(l_term);
+        l_pending.pop_back();
+    }
+
+    PL_reset_term_refs(l_base);
+
+    return l_result;
+}
+
+// canonical_hash(+Term, -Hash), with the hash as a signed 64-bit integer.
+//     a term which cannot be hashed raises a type error, rather than
+//     failing as though it hashed otherwise.
+static foreign_t pl_canonical_hash(term_t a_term, term_t a_hash)
+{
+    uint64_t l_hash;
+
+    try
+    {
+        l_hash = canonical_hash(a_term);
+    }
+    catch (const std::runtime_error &)
+    {
+        return PL_type_error("list_or_atom", a_term);
     }
 
-    return false;
+    return PL_unify_int64(a_hash, (int64_t)l_hash);
+}
+
+void register_foreign_predicates()
+{
+    PL_register_foreign("canonical_hash", 2, (pl_function_t)pl_canonical_hash, 0);
 }
 
 #ifdef UNIT_TEST
 
 #include <fstream>
+#include <sstream>
 #include <iterator>
 #include "test_utils.hpp"
 
@@ -685,7 +904,7 @@ static void test_make_variable()
 
     // distinct singletons
     {
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
         term_t l_var_0 = make_var("_", l_var_alist);
         term_t l_var_1 = make_var("_", l_var_alist);
         assert(PL_compare(l_var_0, l_var_1) != 0);
@@ -694,7 +913,7 @@ static void test_make_variable()
 
     // distinct singleton, named
     {
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
         term_t l_var_0 = make_var("_", l_var_alist);
         term_t l_var_1 = make_var("A", l_var_alist);
         assert(PL_compare(l_var_0, l_var_1) != 0);
@@ -704,7 +923,7 @@ static void test_make_variable()
 
     // same-name vars contract
     {
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
         term_t l_var_0 = make_var("A", l_var_alist);
         term_t l_var_1 = make_var("A", l_var_alist);
         assert(PL_compare(l_var_0, l_var_1) == 0);
@@ -714,7 +933,7 @@ static void test_make_variable()
 
     // eq and inequal vars
     {
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
         term_t l_var_0 = make_var("A", l_var_alist);
         term_t l_var_1 = make_var("B", l_var_alist);
         term_t l_var_2 = make_var("A", l_var_alist);
@@ -728,51 +947,13 @@ static void test_make_variable()
     PL_discard_foreign_frame(l_frame_id);
 }
 
-static void test_random_string()
-{
-    // check outputs different value each time
-    {
-        std::string l_lhs = random_string(30);
-        std::string l_rhs = random_string(30);
-        assert(l_lhs != l_rhs);
-    };
-
-    // check size is correct
-    {
-        constexpr size_t STR_SZ = 30;
-        std::string l_str = random_string(STR_SZ);
-        assert(l_str.size() == STR_SZ);
-    };
-
-    // check size is correct
-    {
-        constexpr size_t STR_SZ = 10;
-        std::string l_str = random_string(STR_SZ);
-        assert(l_str.size() == STR_SZ);
-    };
-
-    // check size is correct
-    {
-        constexpr size_t STR_SZ = 1;
-        std::string l_str = random_string(STR_SZ);
-        assert(l_str.size() == STR_SZ);
-    };
-
-    // check size is correct
-    {
-        constexpr size_t STR_SZ = 12;
-        std::string l_str = random_string(STR_SZ);
-        assert(l_str.size() == STR_SZ);
-    };
-}
-
 static void test_equal_forms()
 {
     // nil == nil
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({});
         term_t l_rhs = make_list({});
@@ -809,7 +990,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_atom("abc");
         term_t l_rhs = make_var("A", l_var_alist);
@@ -825,7 +1006,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_var("A", l_var_alist);
         term_t l_rhs = make_var("B", l_var_alist);
@@ -833,8 +1014,8 @@ static void test_equal_forms()
         assert(PL_is_variable(l_lhs));
         assert(PL_is_variable(l_rhs));
         assert(equal_forms(l_lhs, l_rhs));
-        assert(!PL_is_variable(l_lhs)); // vars will be bound to random atoms
-        assert(!PL_is_variable(l_rhs)); // vars will be bound to random atoms
+        assert(PL_is_variable(l_lhs)); // nothing is bound
+        assert(PL_is_variable(l_rhs)); // nothing is bound
 
         PL_discard_foreign_frame(l_frame);
     };
@@ -843,7 +1024,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")});
         term_t l_rhs = make_list({make_atom("a")});
@@ -857,7 +1038,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")});
         term_t l_rhs = make_list({make_atom("b")});
@@ -871,7 +1052,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")});
         term_t l_rhs = make_list({make_var("A", l_var_alist)});
@@ -885,7 +1066,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")}, make_atom("b"));
         term_t l_rhs = make_list({make_atom("a")}, make_atom("b"));
@@ -899,7 +1080,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")}, make_atom("b"));
         term_t l_rhs = make_list({make_atom("a"), make_atom("b")});
@@ -913,7 +1094,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")}, make_atom("b"));
         term_t l_rhs = make_list({make_atom("a")});
@@ -927,7 +1108,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_nil();
         term_t l_rhs = make_list({make_atom("a")});
@@ -941,7 +1122,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a"), make_atom("b")});
         term_t l_rhs = make_list({make_atom("a"), make_atom("b")});
@@ -955,7 +1136,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a"), make_atom("b")});
         term_t l_rhs = make_list({make_atom("a"), make_atom("c")});
@@ -969,7 +1150,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_atom("a")});
         term_t l_rhs = make_var("X", l_var_alist);
@@ -984,7 +1165,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
                                      make_list({
@@ -1014,7 +1195,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
                                      make_list({
@@ -1044,7 +1225,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
                                      make_list({
@@ -1074,7 +1255,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
                                      make_list({
@@ -1104,7 +1285,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
                                      make_list({
@@ -1134,7 +1315,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("Y", l_var_alist)});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("W", l_var_alist)});
@@ -1148,7 +1329,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist)});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("W", l_var_alist)});
@@ -1162,7 +1343,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist)});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("Z", l_var_alist)});
@@ -1176,7 +1357,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist), make_atom("a")});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("Z", l_var_alist)});
@@ -1190,7 +1371,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist), make_atom("a")});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("Z", l_var_alist), make_atom("a")});
@@ -1204,7 +1385,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist), make_atom("a"), make_var("X", l_var_alist)});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("Z", l_var_alist), make_atom("a"), make_var("Z", l_var_alist)});
@@ -1218,7 +1399,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({make_var("X", l_var_alist), make_var("X", l_var_alist), make_atom("a"), make_var("X", l_var_alist)});
         term_t l_rhs = make_list({make_var("Z", l_var_alist), make_var("Z", l_var_alist), make_atom("a"), make_var("Y", l_var_alist)});
@@ -1232,7 +1413,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
             make_atom("abc"),
@@ -1264,7 +1445,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
             make_atom("abc"),
@@ -1296,7 +1477,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
             make_atom("abc"),
@@ -1330,7 +1511,7 @@ static void test_equal_forms()
     {
         fid_t l_frame = PL_open_foreign_frame();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         term_t l_lhs = make_list({
             make_atom("abc"),
@@ -1356,17 +1537,166 @@ static void test_equal_forms()
         });
 
         assert(!equal_forms(l_lhs, l_rhs));
-        assert(!PL_is_variable(make_var("X", l_var_alist)));
-        assert(!PL_is_variable(make_var("Y", l_var_alist)));
-        assert(!PL_is_variable(make_var("A", l_var_alist)));
-        assert(!PL_is_variable(make_var("B", l_var_alist)));
-        assert(PL_is_variable(make_var("T", l_var_alist))); // T should STILL be var since counterpart was atom and form eq fails.
-        assert(PL_is_variable(make_var("C", l_var_alist))); // form eq does not make it to checking C thus it remains var.
+
+        // no variable was bound, whether or not it was compared
+        for (const char *l_name : {"X", "Y", "T", "A", "B", "C"})
+            assert(PL_is_variable(make_var(l_name, l_var_alist)));
+
+        PL_discard_foreign_frame(l_frame);
+    };
+
+    // variables must correspond one to one, in both directions
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::variable_table<term_t> l_var_alist;
+
+        term_t l_x = make_var("X", l_var_alist);
+        term_t l_y = make_var("Y", l_var_alist);
+        term_t l_a = make_var("A", l_var_alist);
+
+        assert(!equal_forms(make_list({l_x, l_y}), make_list({l_a, l_a})));
+        assert(!equal_forms(make_list({l_a, l_a}), make_list({l_x, l_y})));
+        assert(equal_forms(make_list({l_x, l_y, l_x}), make_list({l_a, l_x, l_a})));
+
+        // variables occurring on both sides
+        assert(equal_forms(make_list({l_x, l_y}), make_list({l_y, l_x})));
+        assert(!equal_forms(make_list({l_x, l_y, l_x}), make_list({l_y, l_x, l_x})));
+
+        // pairs compared together share one correspondence
+        assert(equal_forms(l_x, l_y) && equal_forms(l_x, l_a));
+        assert(!equal_forms({{l_x, l_y}, {l_x, l_a}}));
+        assert(equal_forms({{l_x, l_a}, {make_list({l_x}), make_list({l_a})}}));
+
+        // the same term is a variant of itself
+        term_t l_term = make_list({l_x, make_list({l_y, l_x}), make_atom("a")}, l_y);
+        assert(equal_forms(l_term, l_term));
+
+        PL_discard_foreign_frame(l_frame);
+    };
+
+    // comparing is repeatable, and releases every term ref it used
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::variable_table<term_t> l_var_alist;
+
+        std::list<term_t> l_lhs_elements;
+        std::list<term_t> l_rhs_elements;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            std::string l_suffix = std::to_string(i % 37);
+
+            l_lhs_elements.push_back(make_list({make_var("X" + l_suffix, l_var_alist), make_atom("a")}));
+            l_rhs_elements.push_back(make_list({make_var("A" + l_suffix, l_var_alist), make_atom("a")}));
+        }
+
+        term_t l_lhs = make_list(l_lhs_elements);
+        term_t l_rhs = make_list(l_rhs_elements);
+
+        term_t l_before = PL_new_term_ref();
+
+        for (int i = 0; i < 3; ++i)
+            assert(equal_forms(l_lhs, l_rhs));
+
+        assert(PL_new_term_ref() == l_before + 1);
 
         PL_discard_foreign_frame(l_frame);
     };
 }
 
+static void test_canonical_hash()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    /////////////////////////////////////////
+    // variants hash the same, and these other forms do not
+    /////////////////////////////////////////
+    std::vector<std::string> l_texts =
+        {
+            "a",
+            "b",
+            "[]",
+            "A",
+            "[a]",
+            "[a b]",
+            "[[a] b]",
+            "[a [b]]",
+            "[a | b]",
+            "[X]",
+            "[X X]",
+            "[A A]",
+            "[X Y]",
+            "[A B]",
+            "[X Y X]",
+            "[X Y Y]",
+            "[X [X a] b]",
+            "[A [A a] b]",
+            "[A [B a] b]",
+            "[X | X]",
+            "[X | Y]",
+            "[_ _]",
+            "[A B]",
+            "'a b'",
+        };
+
+    std::vector<term_t> l_terms;
+
+    for (const std::string &l_text : l_texts)
+    {
+        std::stringstream l_ss(l_text);
+        unilog::variable_table<term_t> l_var_alist;
+        term_t l_term = PL_new_term_ref();
+
+        assert(unilog::extract_term_t(l_ss, l_var_alist, l_term));
+
+        l_terms.push_back(l_term);
+    }
+
+    for (term_t l_lhs : l_terms)
+        for (term_t l_rhs : l_terms)
+            assert(equal_forms(l_lhs, l_rhs) == (canonical_hash(l_lhs) == canonical_hash(l_rhs)));
+
+    /////////////////////////////////////////
+    // hashing binds nothing, and releases every term ref it used
+    /////////////////////////////////////////
+    unilog::variable_table<term_t> l_var_alist;
+
+    term_t l_term = make_list({make_var("X", l_var_alist), make_list({make_var("Y", l_var_alist)}), make_atom("a")});
+
+    term_t l_before = PL_new_term_ref();
+
+    uint64_t l_hash = canonical_hash(l_term);
+    assert(canonical_hash(l_term) == l_hash);
+
+    assert(PL_new_term_ref() == l_before + 1);
+    assert(PL_is_variable(make_var("X", l_var_alist)));
+    assert(PL_is_variable(make_var("Y", l_var_alist)));
+
+    /////////////////////////////////////////
+    // atoms hash by their text, so hashes are fixed from run to run
+    /////////////////////////////////////////
+    assert(canonical_hash(make_atom("a")) == canonical_hash(make_atom(std::string("a"))));
+    assert(canonical_hash(make_atom("a")) == 0x61a3d655a2f249c0ull);
+
+    /////////////////////////////////////////
+    // from prolog, a term which cannot be hashed is a type error, not a failure
+    /////////////////////////////////////////
+    term_t l_compound = PL_new_term_ref();
+    assert(PL_cons_functor(l_compound, PL_new_functor(PL_new_atom("f"), 1), make_atom("a")));
+
+    assert(!pl_canonical_hash(l_compound, PL_new_term_ref()));
+    assert(PL_exception(0) != 0);
+
+    PL_clear_exception();
+
+    // and the tests of it in unilog.pl, which can only run once it is registered
+    assert(PL_call_predicate(NULL, PL_Q_NORMAL, PL_predicate("test_canonical_hash", 0, NULL), 0));
+
+    PL_discard_foreign_frame(l_frame);
+}
+
 static void test_axiom_statement_equal()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
@@ -1376,7 +1706,7 @@ static void test_axiom_statement_equal()
     using unilog::axiom_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::pair<axiom_statement, axiom_statement>, bool> l_data_points =
         {
@@ -1591,7 +1921,7 @@ static void test_redir_statement_equal()
     using unilog::redir_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::pair<redir_statement, redir_statement>, bool> l_data_points =
         {
@@ -1811,7 +2141,7 @@ static void test_infer_statement_equal()
     using unilog::infer_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::pair<infer_statement, infer_statement>, bool> l_data_points =
         {
@@ -2089,7 +2419,7 @@ static void test_refer_statement_equal()
     using unilog::refer_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::pair<refer_statement, refer_statement>, bool> l_data_points =
         {
@@ -2164,7 +2494,7 @@ static void test_parser_extract_prolog_expression()
 
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
-    std::map<std::string, term_t> l_data_points_var_alist;
+    unilog::variable_table<term_t> l_data_points_var_alist;
 
     data_points<std::string, term_t>
         l_test_cases =
@@ -2568,7 +2898,7 @@ static void test_parser_extract_prolog_expression()
 
         term_t l_exp = PL_new_term_ref();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         unilog::extract_term_t(l_ss, l_var_alist, l_exp);
 
@@ -2608,7 +2938,7 @@ static void test_parser_extract_prolog_expression()
 
         term_t l_exp = PL_new_term_ref();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         try
         {
@@ -2641,7 +2971,7 @@ static void test_parser_extract_prolog_expression()
 
         term_t l_exp = PL_new_term_ref();
 
-        std::map<std::string, term_t> l_var_alist;
+        unilog::variable_table<term_t> l_var_alist;
 
         unilog::extract_term_t(l_ss, l_var_alist, l_exp);
 
@@ -2665,7 +2995,7 @@ static void test_parser_extract_axiom_statement()
     using unilog::axiom_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::string, statement> l_test_cases =
         {
@@ -2888,7 +3218,7 @@ static void test_parser_extract_redir_statement()
     using unilog::redir_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::string, statement> l_test_cases =
         {
@@ -3116,7 +3446,7 @@ static void test_parser_extract_infer_statement()
     using unilog::infer_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::string, statement> l_test_cases =
         {
@@ -3292,7 +3622,7 @@ static void test_parser_extract_refer_statement()
     using unilog::refer_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::string, statement> l_test_cases =
         {
@@ -3419,6 +3749,214 @@ static void test_parser_extract_refer_statement()
     PL_discard_foreign_frame(l_frame);
 }
 
+static void test_parser_statement_spans()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    std::string l_text = "# header\naxiom a0 [if y x];\n  infer i0 [mp [t a0]\n[t a1]]; # trailing\n";
+
+    unilog::lexer l_lexer(l_text);
+    unilog::statement l_statement;
+
+    /////////////////////////////////////////
+    // a statement spans from its command through its ';',
+    //     leaving out whitespace and comments around it
+    /////////////////////////////////////////
+    assert(l_lexer >> l_statement);
+    assert(unilog::get_span(l_statement).m_begin == 9);
+    assert(unilog::get_span(l_statement).m_end == 27);
+
+    assert(l_lexer >> l_statement);
+    assert(unilog::get_span(l_statement).m_begin == 30);
+    assert(unilog::get_span(l_statement).m_end == 58);
+
+    assert(!(l_lexer >> l_statement));
+
+    /////////////////////////////////////////
+    // the same, through the stream adapter
+    /////////////////////////////////////////
+    std::stringstream l_ss(l_text);
+
+    assert(l_ss >> l_statement);
+    assert(unilog::get_span(l_statement).m_begin == 9);
+
+    assert(l_ss >> l_statement);
+    assert(unilog::get_span(l_statement).m_begin == 30);
+    assert(unilog::get_span(l_statement).m_end == 58);
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+static void test_parser_long_list_term_refs()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    constexpr size_t LENGTH = 10000;
+    constexpr size_t DEPTH = 100;
+
+    /////////////////////////////////////////
+    // a long flat list, and a deeply nested one
+    /////////////////////////////////////////
+    std::string l_text = "axiom t [and";
+
+    for (size_t i = 0; i < LENGTH; ++i)
+        l_text += " a" + std::to_string(i);
+
+    l_text += " X];\naxiom n ";
+
+    for (size_t i = 0; i < DEPTH; ++i)
+        l_text += "[b" + std::to_string(i) + " ";
+
+    l_text += std::string(DEPTH, ']') + ";\n";
+
+    unilog::lexer l_lexer(l_text);
+    unilog::statement l_statement;
+
+    /////////////////////////////////////////
+    // term refs held after parsing do not grow with the list length
+    /////////////////////////////////////////
+    term_t l_before = PL_new_term_ref();
+    assert(l_lexer >> l_statement);
+    term_t l_after = PL_new_term_ref();
+
+    assert(l_after - l_before < 8);
+
+    term_t l_list = PL_copy_term_ref(std::get<unilog::axiom_statement>(l_statement).m_theorem);
+    term_t l_head = PL_new_term_ref();
+
+    size_t l_length = 0;
+
+    while (PL_get_list(l_list, l_head, l_list))
+        ++l_length;
+
+    // and, the atoms, then the variable tail element
+    assert(l_length == LENGTH + 2);
+    assert(PL_get_nil(l_list));
+
+    /////////////////////////////////////////
+    // nor with the depth of the input, once built
+    /////////////////////////////////////////
+    l_before = PL_new_term_ref();
+    assert(l_lexer >> l_statement);
+    l_after = PL_new_term_ref();
+
+    assert(l_after - l_before < 8);
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+static void test_parser_deep_nesting()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    constexpr size_t DEPTH = 100000;
+
+    /////////////////////////////////////////
+    // a guide nested far deeper than the call stack could recurse
+    /////////////////////////////////////////
+    std::string l_chain;
+
+    for (size_t i = 0; i < DEPTH; i++)
+        l_chain += "[mp ";
+
+    l_chain += "x" + std::string(DEPTH, ']');
+
+    std::string l_text = "infer i0 " + l_chain + ";\ninfer i1 " + l_chain + ";\n";
+    l_text += "infer i2 " + l_chain.replace(l_chain.find('x'), 1, "y") + ";\n";
+
+    unilog::lexer l_lexer(l_text);
+
+    unilog::statement l_first;
+    unilog::statement l_second;
+    unilog::statement l_third;
+
+    assert(l_lexer >> l_first);
+    assert(l_lexer >> l_second);
+    assert(l_lexer >> l_third);
+
+    term_t l_guide = std::get<unilog::infer_statement>(l_first).m_guide;
+
+    assert(equal_forms(l_guide, std::get<unilog::infer_statement>(l_second).m_guide));
+    assert(!equal_forms(l_guide, std::get<unilog::infer_statement>(l_third).m_guide));
+
+    assert(canonical_hash(l_guide) == canonical_hash(std::get<unilog::infer_statement>(l_second).m_guide));
+    assert(canonical_hash(l_guide) != canonical_hash(std::get<unilog::infer_statement>(l_third).m_guide));
+
+    /////////////////////////////////////////
+    // walk down the chain: each level is [mp <next>]
+    /////////////////////////////////////////
+    term_t l_level = PL_copy_term_ref(l_guide);
+    term_t l_head = PL_new_term_ref();
+    term_t l_rest = PL_new_term_ref();
+
+    for (size_t i = 0; i < DEPTH; i++)
+    {
+        assert(PL_get_list(l_level, l_head, l_rest));
+        assert(PL_get_list(l_rest, l_level, l_rest));
+        assert(PL_get_nil(l_rest));
+    }
+
+    char *l_chars = nullptr;
+    assert(PL_get_atom_chars(l_level, &l_chars));
+    assert(std::string(l_chars) == "x");
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+static void test_parser_shared_ground_lists()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    /////////////////////////////////////////
+    // statements with repeated ground lists: as heads, as tails of
+    //     other lists, nested in each other, and beside variables
+    /////////////////////////////////////////
+    std::string l_text =
+        "axiom a0 [if [and p [not q]] [and p [not q]]];\n"
+        "axiom a1 [[p q] [r p q] [s | [p q]] | [p q]];\n"
+        "redir r0 [[and X [p q]] [or X [p q]] Y [p q] Y];\n"
+        "axiom a2 [and p [not q]];\n";
+
+    unilog::ast_pool l_pool;
+
+    unilog::lexer l_shared(l_text);
+    unilog::lexer l_plain(l_text);
+
+    unilog::statement l_shared_statement;
+    unilog::statement l_plain_statement;
+
+    /////////////////////////////////////////
+    // sharing makes no difference to the terms built
+    /////////////////////////////////////////
+    for (int i = 0; i < 4; ++i)
+    {
+        assert(unilog::extract_statement(l_shared, l_shared_statement, l_pool));
+        assert(l_plain >> l_plain_statement);
+
+        assert(l_shared_statement.index() == l_plain_statement.index());
+
+        std::visit(
+            [&l_plain_statement](const auto &a_shared)
+            {
+                const auto &l_plain = std::get<std::decay_t<decltype(a_shared)>>(l_plain_statement);
+                assert(a_shared == l_plain);
+            },
+            l_shared_statement);
+    }
+
+    assert(!unilog::extract_statement(l_shared, l_shared_statement, l_pool));
+
+    /////////////////////////////////////////
+    // the last statement was pooled already, so nothing new was held
+    /////////////////////////////////////////
+    const unilog::pool_statistics &l_statistics = l_pool.statistics();
+
+    assert(l_statistics.m_ground_cells > l_statistics.m_pooled_cells);
+    assert(l_statistics.m_cells > l_statistics.m_distinct_cells);
+
+    PL_discard_foreign_frame(l_frame);
+}
+
 static void test_parse_file_examples()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
@@ -3430,7 +3968,7 @@ static void test_parse_file_examples()
     using unilog::refer_statement;
     using unilog::statement;
 
-    std::map<std::string, term_t> l_var_alist;
+    unilog::variable_table<term_t> l_var_alist;
 
     data_points<std::string, std::list<statement>> l_data_points =
         {
@@ -3691,8 +4229,8 @@ void test_parser_main()
     TEST(test_make_atom);
     TEST(test_make_list);
     TEST(test_make_variable);
-    TEST(test_random_string);
     TEST(test_equal_forms);
+    TEST(test_canonical_hash);
     TEST(test_axiom_statement_equal);
     TEST(test_redir_statement_equal);
     TEST(test_infer_statement_equal);
@@ -3702,6 +4240,10 @@ void test_parser_main()
     TEST(test_parser_extract_redir_statement);
     TEST(test_parser_extract_infer_statement);
     TEST(test_parser_extract_refer_statement);
+    TEST(test_parser_statement_spans);
+    TEST(test_parser_long_list_term_refs);
+    TEST(test_parser_deep_nesting);
+    TEST(test_parser_shared_ground_lists);
     TEST(test_parse_file_examples);
 }
 
@@ -5,35 +5,45 @@
 #include <variant>
 #include <istream>
 #include <string>
-#include <map>
 #include <list>
+#include <utility>
+#include <initializer_list>
+#include <cstdint>
 #include <SWI-Prolog.h>
+#include "lexer.hpp"
+#include "ast.hpp"
+#include "variable_table.hpp"
 
 namespace unilog
 {
 
+    // each statement spans from its command through its ';'. spans are not compared.
     struct axiom_statement
     {
         term_t m_tag;
         term_t m_theorem;
+        span m_span;
     };
 
     struct redir_statement
     {
         term_t m_tag;
         term_t m_guide;
+        span m_span;
     };
 
     struct infer_statement
     {
         term_t m_tag;
         term_t m_guide;
+        span m_span;
     };
 
     struct refer_statement
     {
         term_t m_tag;
         term_t m_file_path;
+        span m_span;
     };
 
     bool operator==(const axiom_statement &a_lhs, const axiom_statement &a_rhs);
@@ -47,16 +57,53 @@ namespace unilog
         infer_statement,
         refer_statement>;
 
+    inline span get_span(const statement &a_statement)
+    {
+        return std::visit([](const auto &a_alternative)
+                          { return a_alternative.m_span; }, a_statement);
+    }
+
+    // builds the prolog terms of a natively parsed statement, in one pass,
+    //     on the current prolog frame
+    statement make_statement(const ast_statement &a_statement);
+
     std::istream &operator>>(std::istream &a_istream, statement &a_statement);
+    lexer &operator>>(lexer &a_lexer, statement &a_statement);
+
+    // extracts the next statement like operator>>, but shares its ground
+    //     lists with every other statement extracted through a_pool. lists
+    //     repeated within the statement are built as prolog terms once.
+    lexer &extract_statement(lexer &a_lexer, statement &a_statement, ast_pool &a_pool);
 
 }
 
-// determines if the two terms share the same form. consult function definition for more details.
-// this WILL MODIFY these terms, on the current prolog frame.
+// orders unbound variables, by address. nothing done while comparing
+//     terms can move them, so the order holds for the whole comparison.
+struct variable_order
+{
+    bool operator()(term_t a_lhs, term_t a_rhs) const
+    {
+        return PL_compare(a_lhs, a_rhs) < 0;
+    }
+};
+
+// determines if the two terms share the same form (are variants of each other).
+//     consult function definition for more details. neither term is modified,
+//     and every term ref used is released, so no frame is needed around it.
 bool equal_forms(term_t a_lhs, term_t a_rhs);
+// the same, for several pairs at once. their variables must correspond
+//     alike in every pair, as if each side were one term.
+bool equal_forms(std::initializer_list<std::pair<term_t, term_t>> a_pairs);
+// a 64-bit fingerprint of the term's structure. variables are numbered by
+//     first occurrence, so terms which are equal_forms hash the same. atoms
+//     are hashed by their text, so hashes agree across processes.
+uint64_t canonical_hash(term_t a_term);
+// registers the foreign predicates (canonical_hash/2) with prolog. must be
+//     called before PL_initialise.
+void register_foreign_predicates();
 term_t make_nil();
 term_t make_atom(const std::string &a_text);
 term_t make_list(const std::list<term_t> &a_elements, term_t a_tail = make_nil());
-term_t make_var(const std::string &a_identifier, std::map<std::string, term_t> &a_var_alist);
+term_t make_var(const std::string &a_identifier, unilog::variable_table<term_t> &a_var_alist);
 
 #endif
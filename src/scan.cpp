@@ -0,0 +1,357 @@
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+#include "scan.hpp"
+#include "char_class.hpp"
+
+////////////////////////////////
+//// SCALAR KERNELS
+////////////////////////////////
+
+static const char *skip_whitespace_scalar(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && unilog::is_whitespace(*a_pos))
+        ++a_pos;
+
+    return a_pos;
+}
+
+static const char *skip_identifier_scalar(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && unilog::is_identifier(*a_pos))
+        ++a_pos;
+
+    return a_pos;
+}
+
+static const char *find_newline_scalar(const char *a_pos, const char *a_end)
+{
+    while (a_pos != a_end && *a_pos != '\n')
+        ++a_pos;
+
+    return a_pos;
+}
+
+#ifdef SCAN_X86
+
+////////////////////////////////
+//// SSE2 KERNELS
+////////////////////////////////
+
+// NOTE:
+//     the class tests below rely on the character ranges being contiguous.
+//     an unsigned (c - low) <= (high - low) is a range check, and sse/avx
+//     only offer unsigned comparison through min: min(x, b) == x  <=>  x <= b.
+//     whitespace is ' ' or '\t' through '\r'. identifier chars are
+//     '0' through '9', '_', or ('a' through 'z' after folding case with | 0x20).
+
+__attribute__((target("sse2"))) static inline __m128i less_equal_sse2(__m128i a_lhs, __m128i a_rhs)
+{
+    return _mm_cmpeq_epi8(_mm_min_epu8(a_lhs, a_rhs), a_lhs);
+}
+
+__attribute__((target("sse2"))) static const char *skip_whitespace_sse2(const char *a_pos, const char *a_end)
+{
+    const __m128i l_space = _mm_set1_epi8(' ');
+    const __m128i l_tab = _mm_set1_epi8('\t');
+    const __m128i l_control_span = _mm_set1_epi8('\r' - '\t');
+
+    for (; a_end - a_pos >= 16; a_pos += 16)
+    {
+        __m128i l_chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_pos));
+
+        __m128i l_whitespace = _mm_or_si128(
+            _mm_cmpeq_epi8(l_chars, l_space),
+            less_equal_sse2(_mm_sub_epi8(l_chars, l_tab), l_control_span));
+
+        unsigned l_mask = ~(unsigned)_mm_movemask_epi8(l_whitespace) & 0xFFFFu;
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return skip_whitespace_scalar(a_pos, a_end);
+}
+
+__attribute__((target("sse2"))) static const char *skip_identifier_sse2(const char *a_pos, const char *a_end)
+{
+    const __m128i l_case_bit = _mm_set1_epi8(0x20);
+    const __m128i l_lower_a = _mm_set1_epi8('a');
+    const __m128i l_alpha_span = _mm_set1_epi8('z' - 'a');
+    const __m128i l_zero = _mm_set1_epi8('0');
+    const __m128i l_digit_span = _mm_set1_epi8('9' - '0');
+    const __m128i l_underscore = _mm_set1_epi8('_');
+
+    for (; a_end - a_pos >= 16; a_pos += 16)
+    {
+        __m128i l_chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_pos));
+
+        __m128i l_alpha = less_equal_sse2(_mm_sub_epi8(_mm_or_si128(l_chars, l_case_bit), l_lower_a), l_alpha_span);
+        __m128i l_digit = less_equal_sse2(_mm_sub_epi8(l_chars, l_zero), l_digit_span);
+        __m128i l_identifier = _mm_or_si128(_mm_or_si128(l_alpha, l_digit), _mm_cmpeq_epi8(l_chars, l_underscore));
+
+        unsigned l_mask = ~(unsigned)_mm_movemask_epi8(l_identifier) & 0xFFFFu;
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return skip_identifier_scalar(a_pos, a_end);
+}
+
+__attribute__((target("sse2"))) static const char *find_newline_sse2(const char *a_pos, const char *a_end)
+{
+    const __m128i l_newline = _mm_set1_epi8('\n');
+
+    for (; a_end - a_pos >= 16; a_pos += 16)
+    {
+        __m128i l_chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_pos));
+
+        unsigned l_mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(l_chars, l_newline));
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return find_newline_scalar(a_pos, a_end);
+}
+
+////////////////////////////////
+//// AVX2 KERNELS
+////////////////////////////////
+
+__attribute__((target("avx2"))) static inline __m256i less_equal_avx2(__m256i a_lhs, __m256i a_rhs)
+{
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(a_lhs, a_rhs), a_lhs);
+}
+
+__attribute__((target("avx2"))) static const char *skip_whitespace_avx2(const char *a_pos, const char *a_end)
+{
+    const __m256i l_space = _mm256_set1_epi8(' ');
+    const __m256i l_tab = _mm256_set1_epi8('\t');
+    const __m256i l_control_span = _mm256_set1_epi8('\r' - '\t');
+
+    for (; a_end - a_pos >= 32; a_pos += 32)
+    {
+        __m256i l_chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a_pos));
+
+        __m256i l_whitespace = _mm256_or_si256(
+            _mm256_cmpeq_epi8(l_chars, l_space),
+            less_equal_avx2(_mm256_sub_epi8(l_chars, l_tab), l_control_span));
+
+        unsigned l_mask = ~(unsigned)_mm256_movemask_epi8(l_whitespace);
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return skip_whitespace_sse2(a_pos, a_end);
+}
+
+__attribute__((target("avx2"))) static const char *skip_identifier_avx2(const char *a_pos, const char *a_end)
+{
+    const __m256i l_case_bit = _mm256_set1_epi8(0x20);
+    const __m256i l_lower_a = _mm256_set1_epi8('a');
+    const __m256i l_alpha_span = _mm256_set1_epi8('z' - 'a');
+    const __m256i l_zero = _mm256_set1_epi8('0');
+    const __m256i l_digit_span = _mm256_set1_epi8('9' - '0');
+    const __m256i l_underscore = _mm256_set1_epi8('_');
+
+    for (; a_end - a_pos >= 32; a_pos += 32)
+    {
+        __m256i l_chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a_pos));
+
+        __m256i l_alpha = less_equal_avx2(_mm256_sub_epi8(_mm256_or_si256(l_chars, l_case_bit), l_lower_a), l_alpha_span);
+        __m256i l_digit = less_equal_avx2(_mm256_sub_epi8(l_chars, l_zero), l_digit_span);
+        __m256i l_identifier = _mm256_or_si256(_mm256_or_si256(l_alpha, l_digit), _mm256_cmpeq_epi8(l_chars, l_underscore));
+
+        unsigned l_mask = ~(unsigned)_mm256_movemask_epi8(l_identifier);
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return skip_identifier_sse2(a_pos, a_end);
+}
+
+__attribute__((target("avx2"))) static const char *find_newline_avx2(const char *a_pos, const char *a_end)
+{
+    const __m256i l_newline = _mm256_set1_epi8('\n');
+
+    for (; a_end - a_pos >= 32; a_pos += 32)
+    {
+        __m256i l_chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a_pos));
+
+        unsigned l_mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(l_chars, l_newline));
+
+        if (l_mask != 0)
+            return a_pos + __builtin_ctz(l_mask);
+    }
+
+    return find_newline_sse2(a_pos, a_end);
+}
+
+#endif
+
+namespace unilog
+{
+
+    const scan_kernels *get_scan_kernels(scan_isa a_isa)
+    {
+        static const scan_kernels s_scalar{
+            .m_skip_whitespace = skip_whitespace_scalar,
+            .m_skip_identifier = skip_identifier_scalar,
+            .m_find_newline = find_newline_scalar,
+        };
+
+#ifdef SCAN_X86
+        static const scan_kernels s_sse2{
+            .m_skip_whitespace = skip_whitespace_sse2,
+            .m_skip_identifier = skip_identifier_sse2,
+            .m_find_newline = find_newline_sse2,
+        };
+
+        static const scan_kernels s_avx2{
+            .m_skip_whitespace = skip_whitespace_avx2,
+            .m_skip_identifier = skip_identifier_avx2,
+            .m_find_newline = find_newline_avx2,
+        };
+#endif
+
+        switch (a_isa)
+        {
+        case scan_isa::scalar:
+            return &s_scalar;
+#ifdef SCAN_X86
+        case scan_isa::sse2:
+            return __builtin_cpu_supports("sse2") ? &s_sse2 : nullptr;
+        case scan_isa::avx2:
+            return __builtin_cpu_supports("avx2") ? &s_avx2 : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    const scan_kernels &best_scan_kernels()
+    {
+        static const scan_kernels &s_best = []() -> const scan_kernels &
+        {
+            for (scan_isa l_isa : {scan_isa::avx2, scan_isa::sse2})
+                if (const scan_kernels *l_kernels = get_scan_kernels(l_isa))
+                    return *l_kernels;
+
+            return *get_scan_kernels(scan_isa::scalar);
+        }();
+
+        return s_best;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <string>
+#include <tuple>
+#include <random>
+#include "test_utils.hpp"
+
+static void test_scan_kernels_examples()
+{
+    using unilog::get_scan_kernels;
+    using unilog::scan_isa;
+    using unilog::scan_kernels;
+
+    // expected offsets of (whitespace end, identifier end, newline)
+    using offsets = std::tuple<size_t, size_t, size_t>;
+
+    data_points<std::string, offsets> l_data_points =
+        {
+            {"", {0, 0, 0}},
+            {"abc", {0, 3, 3}},
+            {"   abc", {3, 0, 6}},
+            {" \t\r\n\v\fx", {6, 0, 3}},
+            {"abc_DEF_123 ", {0, 11, 12}},
+            {"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_[", {0, 63, 64}},
+            {"                                                  #", {50, 0, 51}},
+            {"_@_", {0, 1, 3}},
+            {"az`{AZ@[09/:", {0, 2, 12}},
+            {"long_identifier_which_spans_more_than_thirty_two_bytes\n", {0, 54, 54}},
+            {"\x80\xff abc", {0, 0, 6}},
+        };
+
+    for (scan_isa l_isa : {scan_isa::scalar, scan_isa::sse2, scan_isa::avx2})
+    {
+        const scan_kernels *l_kernels = get_scan_kernels(l_isa);
+
+        // this cpu does not support the instruction set
+        if (l_kernels == nullptr)
+            continue;
+
+        for (const auto &[l_input, l_expected] : l_data_points)
+        {
+            const char *l_begin = l_input.data();
+            const char *l_end = l_begin + l_input.size();
+
+            assert((size_t)(l_kernels->m_skip_whitespace(l_begin, l_end) - l_begin) == std::get<0>(l_expected));
+            assert((size_t)(l_kernels->m_skip_identifier(l_begin, l_end) - l_begin) == std::get<1>(l_expected));
+            assert((size_t)(l_kernels->m_find_newline(l_begin, l_end) - l_begin) == std::get<2>(l_expected));
+        }
+    }
+}
+
+static void test_scan_kernels_agree()
+{
+    using unilog::get_scan_kernels;
+    using unilog::scan_isa;
+    using unilog::scan_kernels;
+
+    const scan_kernels *l_scalar = get_scan_kernels(scan_isa::scalar);
+
+    // characters from every class, including ones adjacent to the class ranges
+    const std::string l_alphabet = " \t\n\v\f\r\b\x0e_azAZ09@[`{/:#;|'\"\x80\xff";
+
+    std::mt19937 l_generator(42);
+    std::uniform_int_distribution<size_t> l_char_distribution(0, l_alphabet.size() - 1);
+    std::uniform_int_distribution<size_t> l_run_distribution(0, 40);
+
+    for (scan_isa l_isa : {scan_isa::sse2, scan_isa::avx2})
+    {
+        const scan_kernels *l_kernels = get_scan_kernels(l_isa);
+
+        if (l_kernels == nullptr)
+            continue;
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            // long runs of a single char, with occasional interruptions
+            std::string l_input;
+
+            while (l_input.size() < 96)
+                l_input.append(l_run_distribution(l_generator), l_alphabet[l_char_distribution(l_generator)]);
+
+            const char *l_end = l_input.data() + l_input.size();
+
+            for (const char *l_pos = l_input.data(); l_pos != l_end; ++l_pos)
+            {
+                assert(l_kernels->m_skip_whitespace(l_pos, l_end) == l_scalar->m_skip_whitespace(l_pos, l_end));
+                assert(l_kernels->m_skip_identifier(l_pos, l_end) == l_scalar->m_skip_identifier(l_pos, l_end));
+                assert(l_kernels->m_find_newline(l_pos, l_end) == l_scalar->m_find_newline(l_pos, l_end));
+            }
+        }
+    }
+}
+
+void test_scan_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_scan_kernels_examples);
+    TEST(test_scan_kernels_agree);
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+namespace unilog
+{
+
+    // scanning kernels used by the lexer. each returns the position in
+    //     [a_pos, a_end) at which its run ends, or a_end if it never does.
+    struct scan_kernels
+    {
+        // first char that is not whitespace (see unilog::is_whitespace)
+        const char *(*m_skip_whitespace)(const char *a_pos, const char *a_end);
+
+        // first char that is not alphanumeric or an underscore
+        const char *(*m_skip_identifier)(const char *a_pos, const char *a_end);
+
+        // first newline
+        const char *(*m_find_newline)(const char *a_pos, const char *a_end);
+    };
+
+    enum class scan_isa
+    {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    // kernels for a specific instruction set, or nullptr if this cpu lacks it.
+    const scan_kernels *get_scan_kernels(scan_isa a_isa);
+
+    // the widest kernels this cpu supports, chosen once at runtime.
+    const scan_kernels &best_scan_kernels();
+
+    inline const char *skip_whitespace(const char *a_pos, const char *a_end)
+    {
+        return best_scan_kernels().m_skip_whitespace(a_pos, a_end);
+    }
+
+    inline const char *skip_identifier(const char *a_pos, const char *a_end)
+    {
+        return best_scan_kernels().m_skip_identifier(a_pos, a_end);
+    }
+
+    inline const char *find_newline(const char *a_pos, const char *a_end)
+    {
+        return best_scan_kernels().m_find_newline(a_pos, a_end);
+    }
+
+}
+
+#endif
@@ -0,0 +1,543 @@
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+#include "serializer.hpp"
+#include "char_class.hpp"
+#include "scan.hpp"
+#include "err_msg.hpp"
+
+// the char written after a backslash for each char which quoted text
+//     cannot hold as it is, or 0. the rest are written as they are.
+static constexpr std::array<char, 256> make_escapes()
+{
+    std::array<char, 256> l_result{};
+
+    l_result['\''] = '\'';
+    l_result['\\'] = '\\';
+
+    // quoted text may not span lines
+    l_result['\n'] = 'n';
+    l_result['\r'] = 'r';
+
+    // kept out of the output, so that it stays text
+    l_result['\0'] = '0';
+
+    return l_result;
+}
+
+static constexpr std::array<char, 256> ESCAPES = make_escapes();
+
+// whether a_text lexes as an atom without quotes
+static bool is_unquoted_atom(std::string_view a_text)
+{
+    const char *l_begin = a_text.data();
+    const char *l_end = l_begin + a_text.size();
+
+    return l_begin != l_end &&
+           unilog::get_char_class(*l_begin) == unilog::char_class::atom_start &&
+           unilog::skip_identifier(l_begin + 1, l_end) == l_end;
+}
+
+namespace unilog
+{
+
+    serializer::serializer(std::ostream &a_ostream, size_t a_buffer_size)
+        : m_ostream(a_ostream),
+          m_buffer_size(a_buffer_size)
+    {
+        m_buffer.reserve(a_buffer_size);
+    }
+
+    serializer::~serializer()
+    {
+        flush();
+    }
+
+    void serializer::flush()
+    {
+        m_ostream.write(m_buffer.data(), m_buffer.size());
+        m_ostream.flush();
+
+        m_buffer.clear();
+    }
+
+    void serializer::write_atom(std::string_view a_text)
+    {
+        if (is_unquoted_atom(a_text))
+        {
+            m_buffer.append(a_text);
+            return;
+        }
+
+        m_buffer.push_back('\'');
+
+        /////////////////////////////////////////
+        // append runs of plain chars whole, escaping the char ending each
+        /////////////////////////////////////////
+        const char *l_pos = a_text.data();
+        const char *l_end = l_pos + a_text.size();
+
+        while (l_pos != l_end)
+        {
+            const char *l_run = l_pos;
+
+            while (l_pos != l_end && ESCAPES[(unsigned char)*l_pos] == 0)
+                ++l_pos;
+
+            m_buffer.append(l_run, l_pos);
+
+            if (l_pos == l_end)
+                break;
+
+            m_buffer.push_back('\\');
+            m_buffer.push_back(ESCAPES[(unsigned char)*l_pos++]);
+        }
+
+        m_buffer.push_back('\'');
+    }
+
+    void serializer::write_leaf(term_t a_term)
+    {
+        char *l_text;
+        size_t l_length;
+
+        if (PL_get_nil(a_term))
+        {
+            m_buffer.append("[]");
+        }
+        else if (PL_get_atom_nchars(a_term, &l_length, &l_text))
+        {
+            write_atom(std::string_view(l_text, l_length));
+        }
+        else if (PL_is_variable(a_term))
+        {
+            auto l_entry = std::lower_bound(m_variables.begin(), m_variables.end(), a_term,
+                                            [](const std::pair<term_t, size_t> &a_entry, term_t a_variable)
+                                            { return variable_order()(a_entry.first, a_variable); });
+
+            if (l_entry == m_variables.end() || PL_compare(l_entry->first, a_term) != 0)
+                l_entry = m_variables.insert(l_entry, {PL_copy_term_ref(a_term), m_variables.size()});
+
+            char l_digits[24];
+            char *l_digits_end = std::to_chars(l_digits, l_digits + sizeof(l_digits), l_entry->second).ptr;
+
+            m_buffer.push_back('V');
+            m_buffer.append(l_digits, l_digits_end);
+        }
+        else
+        {
+            throw std::runtime_error(ERR_MSG_SERIALIZE_TERM);
+        }
+    }
+
+    void serializer::write_term(term_t a_term)
+    {
+        /////////////////////////////////////////
+        // lists are written without recursion: an open list keeps the rest
+        //     of its spine in m_open, and is returned to once the element
+        //     being written is done. refs in m_open are reused.
+        /////////////////////////////////////////
+        term_t l_head = PL_new_term_ref();
+        term_t l_next = a_term;
+
+        size_t l_open = 0;
+
+        for (;;)
+        {
+            if (PL_is_pair(l_next))
+            {
+                if (l_open == m_open.size())
+                    m_open.push_back(PL_new_term_ref());
+
+                term_t l_spine = m_open[l_open++];
+
+                PL_put_term(l_spine, l_next);
+                PL_get_list(l_spine, l_head, l_spine);
+
+                m_buffer.push_back('[');
+
+                l_next = l_head;
+                continue;
+            }
+
+            write_leaf(l_next);
+
+            /////////////////////////////////////////
+            // on to the next element, closing every list which has none left
+            /////////////////////////////////////////
+            for (;;)
+            {
+                if (l_open == 0)
+                    return;
+
+                term_t l_spine = m_open[l_open - 1];
+
+                if (PL_get_list(l_spine, l_head, l_spine))
+                {
+                    m_buffer.push_back(' ');
+                    l_next = l_head;
+                    break;
+                }
+
+                if (!PL_get_nil(l_spine))
+                {
+                    m_buffer.append(" | ");
+                    write_leaf(l_spine);
+                }
+
+                m_buffer.push_back(']');
+                --l_open;
+            }
+        }
+    }
+
+    void serializer::write_statement(std::string_view a_command, term_t a_first, term_t a_second)
+    {
+        // refs made while writing the statement, released after it
+        term_t l_base = PL_new_term_ref();
+
+        try
+        {
+            m_buffer.append(a_command);
+            m_buffer.push_back(' ');
+            write_term(a_first);
+            m_buffer.push_back(' ');
+            write_term(a_second);
+            m_buffer.append(";\n");
+        }
+        catch (...)
+        {
+            m_variables.clear();
+            m_open.clear();
+            PL_reset_term_refs(l_base);
+            throw;
+        }
+
+        m_variables.clear();
+        m_open.clear();
+        PL_reset_term_refs(l_base);
+
+        if (m_buffer.size() >= m_buffer_size)
+        {
+            m_ostream.write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+
+    void serializer::write(const statement &a_statement)
+    {
+        if (const axiom_statement *l_axiom = std::get_if<axiom_statement>(&a_statement))
+            write_statement("axiom", l_axiom->m_tag, l_axiom->m_theorem);
+        else if (const redir_statement *l_redir = std::get_if<redir_statement>(&a_statement))
+            write_statement("redir", l_redir->m_tag, l_redir->m_guide);
+        else if (const infer_statement *l_infer = std::get_if<infer_statement>(&a_statement))
+            write_statement("infer", l_infer->m_tag, l_infer->m_guide);
+        else if (const refer_statement *l_refer = std::get_if<refer_statement>(&a_statement))
+            write_statement("refer", l_refer->m_tag, l_refer->m_file_path);
+    }
+
+    void serializer::write_axiom(term_t a_tag, term_t a_theorem)
+    {
+        write_statement("axiom", a_tag, a_theorem);
+    }
+
+    size_t export_theorems(term_t a_module_path, std::ostream &a_ostream)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        term_t l_args = PL_new_term_refs(3);
+        PL_put_term(l_args, a_module_path);
+
+        serializer l_serializer(a_ostream);
+
+        size_t l_result = 0;
+
+        /////////////////////////////////////////
+        // theorem/3 yields clauses in the order they were asserted
+        /////////////////////////////////////////
+        qid_t l_query = PL_open_query(NULL, PL_Q_NORMAL, PL_predicate("theorem", 3, NULL), l_args);
+
+        try
+        {
+            for (; PL_next_solution(l_query); ++l_result)
+                l_serializer.write_axiom(l_args + 1, l_args + 2);
+        }
+        catch (...)
+        {
+            PL_close_query(l_query);
+            PL_discard_foreign_frame(l_frame);
+            throw;
+        }
+
+        PL_close_query(l_query);
+        PL_discard_foreign_frame(l_frame);
+
+        l_serializer.flush();
+
+        return l_result;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <sstream>
+#include "executor.hpp"
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+static unilog::statement read_statement(const std::string &a_text)
+{
+    std::stringstream l_ss(a_text);
+
+    unilog::statement l_result;
+    assert(l_ss >> l_result);
+
+    return l_result;
+}
+
+static std::string write_statement(const unilog::statement &a_statement, size_t a_buffer_size = 1 << 16)
+{
+    std::stringstream l_ss;
+
+    {
+        unilog::serializer l_serializer(l_ss, a_buffer_size);
+        l_serializer.write(a_statement);
+    }
+
+    return l_ss.str();
+}
+
+////////////////////////////////
+//// TESTS
+////////////////////////////////
+
+static void test_serializer_quoting()
+{
+    data_points<std::string, std::string> l_data_points =
+        {
+            {"axiom a x;", "axiom a x;\n"},
+            {"axiom a_0 \"x\";", "axiom a_0 x;\n"},
+            {"redir r [t a];", "redir r [t a];\n"},
+            {"infer i [mp [t a] [t b]];", "infer i [mp [t a] [t b]];\n"},
+            {"refer m './m.u';", "refer m './m.u';\n"},
+
+            // atoms which would not lex unquoted
+            {"axiom a 'X';", "axiom a 'X';\n"},
+            {"axiom a '_x';", "axiom a '_x';\n"},
+            {"axiom a '0x';", "axiom a '0x';\n"},
+            {"axiom a '';", "axiom a '';\n"},
+            {"axiom a 'x y';", "axiom a 'x y';\n"},
+            {"axiom a 'x;#|';", "axiom a 'x;#|';\n"},
+
+            // only what quoted text cannot hold is escaped
+            {"axiom a \"it's\";", "axiom a 'it\\'s';\n"},
+            {"axiom a 'a\\\\b';", "axiom a 'a\\\\b';\n"},
+            {"axiom a 'a\\nb\\rc';", "axiom a 'a\\nb\\rc';\n"},
+            {"axiom a 'a\\tb\"';", "axiom a 'a\tb\"';\n"},
+            {"axiom a '\\x00\\x41';", "axiom a '\\0A';\n"},
+
+            // nil, and improper tails
+            {"axiom a [];", "axiom a [];\n"},
+            {"axiom a [[] [[]]];", "axiom a [[] [[]]];\n"},
+            {"axiom a [x | y];", "axiom a [x | y];\n"},
+            {"axiom a [x y | []];", "axiom a [x y];\n"},
+
+            // variables are named by first occurrence, tag and body alike
+            {"axiom a [Y X | Y];", "axiom a [V0 V1 | V0];\n"},
+            {"axiom T [X T];", "axiom V0 [V1 V0];\n"},
+            {"axiom a [_ _ X];", "axiom a [V0 V1 V2];\n"},
+        };
+
+    for (const auto &[l_key, l_value] : l_data_points)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        assert(write_statement(read_statement(l_key)) == l_value);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+}
+
+static void test_serializer_round_trip()
+{
+    std::vector<std::string> l_texts =
+        {
+            "axiom a [if [and X Y] [or Y X]];",
+            "redir r [mp [t a] [r q] | Rest];",
+            "infer i [mp [[V] 'W w'] [_ '' [] | Tail]];",
+            "refer 'Module' '/tmp/a b/c.u';",
+        };
+
+    /////////////////////////////////////////
+    // every byte, in atoms
+    /////////////////////////////////////////
+    std::string l_bytes;
+
+    for (int i = 0; i < 256; ++i)
+        l_bytes.push_back((char)i);
+
+    /////////////////////////////////////////
+    // nesting deeper than recursion would survive
+    /////////////////////////////////////////
+    std::string l_deep = "infer i ";
+
+    for (size_t i = 0; i < 100000; ++i)
+        l_deep += "[mp X ";
+
+    l_deep += "x";
+    l_deep.append(100000, ']');
+    l_deep += ";";
+
+    l_texts.push_back(l_deep);
+
+    for (const std::string &l_text : l_texts)
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::statement l_statement = read_statement(l_text);
+        std::string l_written = write_statement(l_statement);
+
+        assert(read_statement(l_written) == l_statement);
+
+        // written text is a fixed point
+        assert(write_statement(read_statement(l_written)) == l_written);
+
+        PL_discard_foreign_frame(l_frame);
+    }
+
+    {
+        fid_t l_frame = PL_open_foreign_frame();
+
+        unilog::axiom_statement l_statement{
+            .m_tag = make_atom(l_bytes),
+            .m_theorem = make_list({make_atom(l_bytes.substr(0, 128)), make_atom(l_bytes.substr(128))}),
+        };
+
+        std::string l_written = write_statement(l_statement);
+
+        // the output stays on one line
+        assert(l_written.find('\n') == l_written.size() - 1);
+
+        assert(read_statement(l_written) == unilog::statement(l_statement));
+
+        PL_discard_foreign_frame(l_frame);
+    }
+}
+
+static void test_serializer_buffering()
+{
+    fid_t l_frame = PL_open_foreign_frame();
+
+    unilog::statement l_statement = read_statement("axiom a [x 'y z' [W | W]];");
+
+    /////////////////////////////////////////
+    // output reaches the stream once the buffer fills, or when flushed
+    /////////////////////////////////////////
+    std::stringstream l_ss;
+    unilog::serializer l_serializer(l_ss, 64);
+
+    l_serializer.write(l_statement);
+    assert(l_ss.str().empty());
+
+    for (int i = 0; i < 100; ++i)
+        l_serializer.write(l_statement);
+
+    assert(!l_ss.str().empty());
+
+    l_serializer.flush();
+
+    std::string l_expected;
+
+    for (int i = 0; i < 101; ++i)
+        l_expected += "axiom a [x 'y z' [V0 | V0]];\n";
+
+    assert(l_ss.str() == l_expected);
+
+    /////////////////////////////////////////
+    // a term that cannot be written leaves nothing of its statement
+    /////////////////////////////////////////
+    term_t l_integer = PL_new_term_ref();
+    assert(PL_put_int64(l_integer, 7));
+
+    bool l_thrown = false;
+
+    try
+    {
+        l_serializer.write_axiom(make_atom("b"), l_integer);
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        l_thrown = true;
+        assert(std::string(l_err.what()) == ERR_MSG_SERIALIZE_TERM);
+    }
+
+    assert(l_thrown);
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+static void test_export_theorems()
+{
+    using unilog::execute;
+
+    fid_t l_frame = PL_open_foreign_frame();
+
+    term_t l_module_path = make_list({make_atom("root")});
+
+    execute(std::get<unilog::axiom_statement>(read_statement("axiom a0 [if [p X] [q X]];")), l_module_path);
+    execute(std::get<unilog::axiom_statement>(read_statement("axiom a1 'p\\'';")), l_module_path);
+    execute(std::get<unilog::redir_statement>(read_statement("redir r0 [t a0];")), l_module_path);
+    execute(std::get<unilog::infer_statement>(read_statement("infer i0 [r r0];")), l_module_path);
+
+    // declared elsewhere, so not exported
+    execute(std::get<unilog::axiom_statement>(read_statement("axiom b0 x;")), make_list({make_atom("other")}));
+
+    std::stringstream l_ss;
+
+    assert(unilog::export_theorems(l_module_path, l_ss) == 3);
+
+    assert(l_ss.str() ==
+           "axiom a0 [if [p V0] [q V0]];\n"
+           "axiom a1 'p\\'';\n"
+           "axiom i0 [if [p V0] [q V0]];\n");
+
+    /////////////////////////////////////////
+    // the export loads back as plain axioms, into an empty database
+    /////////////////////////////////////////
+    wipe_database();
+
+    unilog::statement l_statement;
+
+    while (l_ss >> l_statement)
+        std::visit([l_module_path](const auto &a_statement)
+                   { execute(a_statement, l_module_path); }, l_statement);
+
+    term_t l_args = PL_new_term_refs(3);
+    PL_put_term(l_args, l_module_path);
+    PL_put_atom_chars(l_args + 1, "i0");
+
+    assert(PL_call_predicate(NULL, PL_Q_NORMAL, PL_predicate("theorem", 3, NULL), l_args));
+    assert(equal_forms(l_args + 2, std::get<unilog::axiom_statement>(read_statement("axiom t [if [p X] [q X]];")).m_theorem));
+
+    wipe_database();
+
+    PL_discard_foreign_frame(l_frame);
+}
+
+void test_serializer_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_serializer_quoting);
+    TEST(test_serializer_round_trip);
+    TEST(test_serializer_buffering);
+    TEST(test_export_theorems);
+}
+
+#endif
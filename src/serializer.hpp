@@ -0,0 +1,65 @@
+#ifndef SERIALIZER_HPP
+#define SERIALIZER_HPP
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <SWI-Prolog.h>
+#include "parser.hpp"
+
+namespace unilog
+{
+
+    // writes statements as .u text, which reads back through
+    //     operator>>(std::istream &, statement &) as statements of the same
+    //     form. atoms are quoted only when they would not lex unquoted, and
+    //     variables are named by first occurrence within each statement.
+    //     output is gathered in a buffer, and handed to the stream in blocks.
+    class serializer
+    {
+    private:
+        std::ostream &m_ostream;
+        std::string m_buffer;
+        size_t m_buffer_size;
+
+        // variables of the statement being written, with their numbers,
+        //     kept sorted by variable_order. the storage is reused.
+        std::vector<std::pair<term_t, size_t>> m_variables;
+
+        // lists being written, innermost last. each ref holds the part of
+        //     its list's spine not yet written.
+        std::vector<term_t> m_open;
+
+        void write_atom(std::string_view a_text);
+        void write_leaf(term_t a_term);
+        void write_term(term_t a_term);
+
+        // writes "command a_first a_second;"
+        void write_statement(std::string_view a_command, term_t a_first, term_t a_second);
+
+    public:
+        explicit serializer(std::ostream &a_ostream, size_t a_buffer_size = 1 << 16);
+        ~serializer();
+
+        serializer(const serializer &) = delete;
+        serializer &operator=(const serializer &) = delete;
+
+        void write(const statement &a_statement);
+        void write_axiom(term_t a_tag, term_t a_theorem);
+
+        // hands everything buffered to the stream, and flushes it
+        void flush();
+    };
+
+    // writes every theorem declared in a_module_path, axioms and inferred
+    //     alike, as axioms, in the order they were declared. theorems of the
+    //     modules it refers, declared in submodules of it, are not written.
+    //     returns how many were written.
+    size_t export_theorems(term_t a_module_path, std::ostream &a_ostream);
+
+}
+
+#endif
@@ -0,0 +1,292 @@
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "source_file.hpp"
+#include "lexer.hpp"
+#include "err_msg.hpp"
+
+// files smaller than this are read(), since mapping them costs more than copying.
+static constexpr size_t MMAP_MIN_SIZE = 16 * 1024;
+
+// granularity of read() for files which are not mapped
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+// closes the descriptor when leaving scope
+struct fd_guard
+{
+    int m_fd;
+    ~fd_guard() { ::close(m_fd); }
+};
+
+namespace unilog
+{
+
+    source_file::source_file(const std::filesystem::path &a_path) : m_path(a_path)
+    {
+        fd_guard l_fd{::open(a_path.c_str(), O_RDONLY | O_CLOEXEC)};
+
+        struct stat l_stat;
+
+        if (l_fd.m_fd < 0 || ::fstat(l_fd.m_fd, &l_stat) != 0)
+            throw std::runtime_error(std::string(ERR_MSG_FILE_OPEN) + ": " + a_path.string());
+
+        // spans could not address all of it
+        if (S_ISREG(l_stat.st_mode) && (size_t)l_stat.st_size > MAX_INPUT_SIZE)
+            throw std::runtime_error(std::string(ERR_MSG_INPUT_TOO_LARGE) + ": " + a_path.string());
+
+        /////////////////////////////////////////
+        // map regular files that are large enough to benefit
+        /////////////////////////////////////////
+        if (S_ISREG(l_stat.st_mode) && (size_t)l_stat.st_size >= MMAP_MIN_SIZE)
+        {
+            void *l_mapping = ::mmap(nullptr, l_stat.st_size, PROT_READ, MAP_PRIVATE, l_fd.m_fd, 0);
+
+            if (l_mapping != MAP_FAILED)
+            {
+                // the lexer reads front to back, so let the kernel read ahead aggressively
+                ::madvise(l_mapping, l_stat.st_size, MADV_SEQUENTIAL);
+
+                m_mapping = l_mapping;
+                m_mapping_size = l_stat.st_size;
+                m_text = std::string_view(static_cast<const char *>(l_mapping), m_mapping_size);
+
+                return;
+            }
+        }
+
+        /////////////////////////////////////////
+        // pipes, tiny files, or a failed mapping: read until eof
+        /////////////////////////////////////////
+        if (S_ISREG(l_stat.st_mode))
+            m_buffer.reserve(l_stat.st_size);
+
+        for (;;)
+        {
+            size_t l_size = m_buffer.size();
+
+            m_buffer.resize(l_size + READ_CHUNK_SIZE);
+
+            ssize_t l_read = ::read(l_fd.m_fd, m_buffer.data() + l_size, READ_CHUNK_SIZE);
+
+            m_buffer.resize(l_size + std::max<ssize_t>(l_read, 0));
+
+            if (l_read == 0)
+                break;
+
+            if (l_read < 0 && errno != EINTR)
+                throw std::runtime_error(std::string(ERR_MSG_FILE_READ) + ": " + a_path.string());
+
+            if (m_buffer.size() > MAX_INPUT_SIZE)
+                throw std::runtime_error(std::string(ERR_MSG_INPUT_TOO_LARGE) + ": " + a_path.string());
+        }
+
+        m_text = m_buffer;
+    }
+
+    source_file::~source_file()
+    {
+        if (m_mapping != nullptr)
+            ::munmap(m_mapping, m_mapping_size);
+    }
+
+    std::shared_ptr<const source_file> load_source_file(const std::filesystem::path &a_canonical_path)
+    {
+        // identifies the contents of a file on disk: device, inode, size, mtime
+        using file_version = std::tuple<dev_t, ino_t, off_t, time_t, long>;
+
+        // the cache does not own its files, so it holds only those still in use
+        struct cache_entry
+        {
+            file_version m_version;
+            std::weak_ptr<const source_file> m_file;
+        };
+
+        static std::mutex s_mutex;
+        static std::map<std::filesystem::path, cache_entry> s_cache;
+
+        struct stat l_stat;
+
+        /////////////////////////////////////////
+        // pipes (and anything which cannot be stat'd) are never shared
+        /////////////////////////////////////////
+        if (::stat(a_canonical_path.c_str(), &l_stat) != 0 || !S_ISREG(l_stat.st_mode))
+            return std::make_shared<const source_file>(a_canonical_path);
+
+        file_version l_version{
+            l_stat.st_dev,
+            l_stat.st_ino,
+            l_stat.st_size,
+            l_stat.st_mtim.tv_sec,
+            l_stat.st_mtim.tv_nsec,
+        };
+
+        std::lock_guard l_lock(s_mutex);
+
+        auto l_entry = s_cache.find(a_canonical_path);
+
+        if (l_entry != s_cache.end() && l_entry->second.m_version == l_version)
+            if (std::shared_ptr<const source_file> l_file = l_entry->second.m_file.lock())
+                return l_file;
+
+        /////////////////////////////////////////
+        // (re)load if not in use, or changed since. entries of files no
+        //     longer in use are dropped meanwhile.
+        /////////////////////////////////////////
+        std::erase_if(s_cache, [](const auto &a_entry)
+                      { return a_entry.second.m_file.expired(); });
+
+        std::shared_ptr<const source_file> l_file = std::make_shared<const source_file>(a_canonical_path);
+
+        s_cache[a_canonical_path] = {l_version, l_file};
+
+        return l_file;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <fstream>
+#include "test_utils.hpp"
+
+static void write_file(const std::filesystem::path &a_path, const std::string &a_contents)
+{
+    std::ofstream l_ofs(a_path, std::ios::binary | std::ios::trunc);
+    l_ofs << a_contents;
+}
+
+static void test_source_file_read()
+{
+    namespace fs = std::filesystem;
+
+    fs::path l_path = fs::canonical("./src/test_input_files/executor_example_0/test.u");
+
+    unilog::source_file l_file(l_path);
+
+    // tiny files are read, not mapped
+    assert(!l_file.mapped());
+
+    std::ifstream l_ifs(l_path, std::ios::binary);
+    std::string l_expected((std::istreambuf_iterator<char>(l_ifs)), std::istreambuf_iterator<char>());
+
+    assert(l_file.text() == l_expected);
+    assert(l_file.path() == l_path);
+}
+
+static void test_source_file_mapped()
+{
+    namespace fs = std::filesystem;
+
+    fs::path l_path = fs::temp_directory_path() / "unilog_test_source_file_mapped.u";
+
+    std::string l_contents;
+
+    while (l_contents.size() < 4 * MMAP_MIN_SIZE)
+        l_contents += "axiom a" + std::to_string(l_contents.size()) + " [if y x];\n";
+
+    write_file(l_path, l_contents);
+
+    {
+        unilog::source_file l_file(l_path);
+
+        // large regular files are mapped
+        assert(l_file.mapped());
+        assert(l_file.text() == l_contents);
+    };
+
+    fs::remove(l_path);
+}
+
+static void test_source_file_empty()
+{
+    namespace fs = std::filesystem;
+
+    fs::path l_path = fs::temp_directory_path() / "unilog_test_source_file_empty.u";
+
+    write_file(l_path, "");
+
+    unilog::source_file l_file(l_path);
+    assert(l_file.text().empty());
+
+    fs::remove(l_path);
+}
+
+static void test_source_file_missing()
+{
+    try
+    {
+        unilog::source_file l_file("./src/test_input_files/does_not_exist.u");
+        throw std::runtime_error("Failed test case: expected throw");
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        assert(std::string(l_err.what()).starts_with(ERR_MSG_FILE_OPEN));
+    }
+}
+
+static void test_load_source_file_shares()
+{
+    namespace fs = std::filesystem;
+
+    fs::path l_path = fs::temp_directory_path() / "unilog_test_load_source_file.u";
+    fs::path l_replacement = fs::temp_directory_path() / "unilog_test_load_source_file.u.new";
+
+    std::string l_contents;
+
+    while (l_contents.size() < MMAP_MIN_SIZE)
+        l_contents += "axiom a" + std::to_string(l_contents.size()) + " x;\n";
+
+    write_file(l_path, l_contents);
+
+    auto l_first = unilog::load_source_file(l_path);
+    auto l_second = unilog::load_source_file(l_path);
+
+    // unchanged files share the loaded contents
+    assert(l_first->mapped());
+    assert(l_first == l_second);
+
+    /////////////////////////////////////////
+    // replaced files are loaded again, while old views stay valid
+    /////////////////////////////////////////
+    write_file(l_replacement, l_contents + "axiom b0 y;\n");
+    fs::rename(l_replacement, l_path);
+
+    auto l_third = unilog::load_source_file(l_path);
+
+    assert(l_third != l_first);
+    assert(l_third->mapped());
+    assert(l_third->text() == l_contents + "axiom b0 y;\n");
+    assert(l_first->text() == l_contents);
+
+    /////////////////////////////////////////
+    // a file no longer in use is not kept
+    /////////////////////////////////////////
+    std::weak_ptr<const unilog::source_file> l_released = l_third;
+
+    l_third.reset();
+
+    assert(l_released.expired());
+
+    fs::remove(l_path);
+}
+
+void test_source_file_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_source_file_read);
+    TEST(test_source_file_mapped);
+    TEST(test_source_file_empty);
+    TEST(test_source_file_missing);
+    TEST(test_load_source_file_shares);
+}
+
+#endif
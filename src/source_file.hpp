@@ -0,0 +1,54 @@
+#ifndef SOURCE_FILE_HPP
+#define SOURCE_FILE_HPP
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+namespace unilog
+{
+
+    // read-only, contiguous contents of a source file.
+    //     regular files are memory-mapped, so they are never copied into
+    //     user-space buffers. pipes and tiny files are read() instead.
+    //
+    // a mapping follows the file on disk: replacing the file (writing a new
+    //     one and renaming it over the old, as editors do) leaves it intact,
+    //     but truncating the file in place makes reads of the lost pages
+    //     raise SIGBUS. so the text of a mapped file is read only while it
+    //     is being lexed, and not held onto afterwards.
+    class source_file
+    {
+    private:
+        std::filesystem::path m_path;
+
+        // set when the contents are mapped
+        void *m_mapping = nullptr;
+        size_t m_mapping_size = 0;
+
+        // set when the contents were read
+        std::string m_buffer;
+
+        std::string_view m_text;
+
+    public:
+        source_file(const std::filesystem::path &a_path);
+        ~source_file();
+
+        source_file(const source_file &) = delete;
+        source_file &operator=(const source_file &) = delete;
+
+        const std::filesystem::path &path() const { return m_path; }
+        std::string_view text() const { return m_text; }
+        bool mapped() const { return m_mapping != nullptr; }
+    };
+
+    // loads a source file by its canonical path. a file which is loaded
+    //     again while still in use (and has not changed on disk) shares
+    //     its mapping. files no longer in use are not kept.
+    std::shared_ptr<const source_file> load_source_file(const std::filesystem::path &a_canonical_path);
+
+}
+
+#endif
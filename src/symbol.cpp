@@ -0,0 +1,194 @@
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "symbol.hpp"
+
+// the process-wide table of interned texts. lookups of existing text
+//     (by far the common case) only take the lock shared, so that
+//     several lexers may intern concurrently.
+struct symbol_table
+{
+    std::shared_mutex m_mutex;
+
+    // a deque never moves its elements, so views of them stay valid
+    std::deque<std::string> m_texts;
+
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+
+    symbol_table()
+    {
+        // reserve id 0 for the empty text
+        m_ids.emplace(m_texts.emplace_back(), 0);
+    }
+};
+
+static symbol_table &get_symbol_table()
+{
+    static symbol_table s_table;
+    return s_table;
+}
+
+namespace unilog
+{
+
+    symbol::symbol(std::string_view a_text)
+    {
+        symbol_table &l_table = get_symbol_table();
+
+        /////////////////////////////////////////
+        // each thread remembers what it has interned, so that threads
+        //     parsing in parallel rarely touch the shared lock. the keys
+        //     view the table's texts, which are never freed.
+        /////////////////////////////////////////
+        static thread_local std::unordered_map<std::string_view, uint32_t> s_seen;
+
+        auto l_seen = s_seen.find(a_text);
+
+        if (l_seen != s_seen.end())
+        {
+            m_id = l_seen->second;
+            return;
+        }
+
+        /////////////////////////////////////////
+        // the text is usually interned already
+        /////////////////////////////////////////
+        {
+            std::shared_lock l_lock(l_table.m_mutex);
+
+            auto l_entry = l_table.m_ids.find(a_text);
+
+            if (l_entry != l_table.m_ids.end())
+            {
+                m_id = l_entry->second;
+                s_seen.emplace(l_entry->first, m_id);
+                return;
+            }
+        }
+
+        /////////////////////////////////////////
+        // otherwise, intern it. another thread may have beaten us to it.
+        /////////////////////////////////////////
+        std::unique_lock l_lock(l_table.m_mutex);
+
+        auto l_entry = l_table.m_ids.find(a_text);
+
+        if (l_entry == l_table.m_ids.end())
+        {
+            const std::string &l_text = l_table.m_texts.emplace_back(a_text);
+            l_entry = l_table.m_ids.emplace(l_text, l_table.m_texts.size() - 1).first;
+        }
+
+        m_id = l_entry->second;
+        s_seen.emplace(l_entry->first, m_id);
+    }
+
+    std::string_view symbol::text() const
+    {
+        symbol_table &l_table = get_symbol_table();
+
+        std::shared_lock l_lock(l_table.m_mutex);
+
+        return l_table.m_texts[m_id];
+    }
+
+    size_t symbol_count()
+    {
+        symbol_table &l_table = get_symbol_table();
+
+        std::shared_lock l_lock(l_table.m_mutex);
+
+        return l_table.m_texts.size();
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <thread>
+#include <vector>
+#include "test_utils.hpp"
+
+static void test_symbol_intern()
+{
+    using unilog::symbol;
+
+    // the empty text is the default symbol
+    assert(symbol() == symbol(""));
+    assert(symbol().id() == 0);
+    assert(symbol().text().empty());
+
+    symbol l_if("if");
+    symbol l_and("and");
+
+    // equal text, equal symbol
+    assert(symbol("if") == l_if);
+    assert(symbol(std::string("if")) == l_if);
+    assert(symbol(std::string_view("iff", 2)) == l_if);
+
+    // distinct text, distinct symbol
+    assert(l_if != l_and);
+    assert(l_if.id() != l_and.id());
+
+    // text round-trips, including embedded nulls and escapes
+    assert(l_if.text() == "if");
+    assert(symbol(std::string_view("a\0b", 3)).text() == std::string_view("a\0b", 3));
+    assert(symbol(std::string_view("a\0b", 3)) != symbol("a"));
+
+    // interning known text does not grow the table
+    size_t l_count = unilog::symbol_count();
+    symbol("if");
+    symbol("and");
+    assert(unilog::symbol_count() == l_count);
+
+    // hashing follows equality
+    assert(std::hash<symbol>()(symbol("and")) == std::hash<symbol>()(l_and));
+}
+
+static void test_symbol_concurrent_intern()
+{
+    using unilog::symbol;
+
+    constexpr size_t THREAD_COUNT = 8;
+    constexpr size_t TEXT_COUNT = 2048;
+
+    std::vector<std::vector<symbol>> l_results(THREAD_COUNT);
+    std::vector<std::thread> l_threads;
+
+    // every thread interns the same texts, in a different order.
+    //     odd strides are permutations, since TEXT_COUNT is a power of two.
+    for (size_t i = 0; i < THREAD_COUNT; i++)
+        l_threads.emplace_back(
+            [&l_results, i]
+            {
+                l_results[i].resize(TEXT_COUNT);
+
+                for (size_t j = 0; j < TEXT_COUNT; j++)
+                {
+                    size_t l_index = (j * (2 * i + 1)) % TEXT_COUNT;
+                    l_results[i][l_index] = symbol("concurrent_" + std::to_string(l_index));
+                }
+            });
+
+    for (std::thread &l_thread : l_threads)
+        l_thread.join();
+
+    // all threads agree on every id
+    for (size_t i = 1; i < THREAD_COUNT; i++)
+        assert(l_results[i] == l_results[0]);
+
+    for (size_t j = 0; j < TEXT_COUNT; j++)
+        assert(l_results[0][j].text() == "concurrent_" + std::to_string(j));
+}
+
+void test_symbol_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_symbol_intern);
+    TEST(test_symbol_concurrent_intern);
+}
+
+#endif
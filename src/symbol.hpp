@@ -0,0 +1,61 @@
+#ifndef SYMBOL_HPP
+#define SYMBOL_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace unilog
+{
+
+    // interned text. symbols with equal text share a compact id, so
+    //     comparing, hashing and caching by symbol is integer work.
+    //     interned text lives until the process exits.
+    class symbol
+    {
+    private:
+        // id 0 is always the empty text
+        uint32_t m_id = 0;
+
+    public:
+        symbol() = default;
+        symbol(std::string_view a_text);
+        symbol(const std::string &a_text) : symbol(std::string_view(a_text)) {}
+        symbol(const char *a_text) : symbol(std::string_view(a_text)) {}
+
+        // ids are dense, in order of first interning
+        uint32_t id() const { return m_id; }
+
+        // the symbol of an id previously returned by id()
+        static symbol from_id(uint32_t a_id)
+        {
+            symbol l_result;
+            l_result.m_id = a_id;
+            return l_result;
+        }
+
+        std::string_view text() const;
+
+        bool operator==(const symbol &a_rhs) const = default;
+
+        // orders by id, not by text
+        auto operator<=>(const symbol &a_rhs) const = default;
+    };
+
+    // number of distinct texts interned so far
+    size_t symbol_count();
+
+}
+
+template <>
+struct std::hash<unilog::symbol>
+{
+    size_t operator()(const unilog::symbol &a_symbol) const noexcept
+    {
+        return std::hash<uint32_t>()(a_symbol.id());
+    }
+};
+
+#endif
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+#include "syntax_check.hpp"
+#include "source_file.hpp"
+#include "line_index.hpp"
+#include "lexer.hpp"
+#include "ast.hpp"
+#include "err_msg.hpp"
+
+namespace fs = std::filesystem;
+
+// what checking a single file found
+struct file_check
+{
+    std::vector<unilog::syntax_diagnostic> m_diagnostics;
+
+    // canonical paths of the files it refers to
+    std::vector<fs::path> m_referred;
+
+    size_t m_statements = 0;
+    size_t m_bytes = 0;
+};
+
+// the canonical path of a_path, or a diagnostic saying why there is none
+static std::optional<fs::path> resolve(const fs::path &a_path, std::string &a_message)
+{
+    std::error_code l_error;
+
+    std::string l_shown = a_path.lexically_normal().string();
+
+    fs::path l_result = fs::canonical(a_path, l_error);
+
+    if (l_error)
+    {
+        a_message = std::string(ERR_MSG_FILE_OPEN) + ": " + l_shown;
+        return std::nullopt;
+    }
+
+    if (fs::is_directory(l_result, l_error))
+    {
+        a_message = std::string(ERR_MSG_NOT_A_FILE) + ": " + l_shown;
+        return std::nullopt;
+    }
+
+    return l_result;
+}
+
+static file_check check_file(const fs::path &a_path)
+{
+    file_check l_result;
+
+    std::optional<unilog::source_file> l_file;
+
+    try
+    {
+        l_file.emplace(a_path);
+    }
+    catch (const std::runtime_error &l_err)
+    {
+        l_result.m_diagnostics.push_back({.m_path = a_path, .m_message = l_err.what()});
+        return l_result;
+    }
+
+    std::string_view l_text = l_file->text();
+
+    l_result.m_bytes = l_text.size();
+
+    // lines are only indexed once a position is needed
+    std::optional<unilog::line_index> l_lines;
+
+    auto l_report = [&](size_t a_offset, std::string a_message)
+    {
+        if (!l_lines)
+            l_lines.emplace(l_text);
+
+        auto [l_line, l_column] = l_lines->position(a_offset);
+
+        l_result.m_diagnostics.push_back({
+            .m_path = a_path,
+            .m_line = l_line,
+            .m_column = l_column,
+            .m_message = std::move(a_message),
+        });
+    };
+
+    unilog::lexer l_lexer(l_text);
+    unilog::ast_arena l_arena;
+    unilog::ast_statement l_statement;
+
+    for (;; l_arena.clear())
+    {
+        size_t l_begin = l_lexer.offset();
+
+        try
+        {
+            if (!unilog::parse_statement(l_lexer, l_arena, l_statement))
+                break;
+        }
+        catch (const std::exception &l_err)
+        {
+            l_report(l_lexer.offset(), l_err.what());
+
+            /////////////////////////////////////////
+            // go on from just past the ';' ending the statement that failed
+            /////////////////////////////////////////
+            size_t l_next = unilog::find_statement_end(l_text.data() + l_begin, l_text.data() + l_text.size()) - l_text.data();
+
+            l_lexer.assign(l_text.substr(l_next), l_next);
+            continue;
+        }
+
+        ++l_result.m_statements;
+
+        /////////////////////////////////////////
+        // a refer names its file relative to the file it is in. a file path
+        //     which is not an atom fails only when executed.
+        /////////////////////////////////////////
+        if (l_statement.m_kind != unilog::ast_statement::kind::refer ||
+            l_statement.m_body.m_kind != unilog::ast_term::kind::atom)
+            continue;
+
+        std::string l_message;
+
+        std::optional<fs::path> l_referred =
+            resolve(a_path.parent_path() / l_statement.m_body.text().text(), l_message);
+
+        if (l_referred)
+            l_result.m_referred.push_back(*l_referred);
+        else
+            l_report(l_statement.m_span.m_begin, l_message);
+    }
+
+    return l_result;
+}
+
+namespace unilog
+{
+
+    std::ostream &operator<<(std::ostream &a_ostream, const syntax_diagnostic &a_diagnostic)
+    {
+        a_ostream << a_diagnostic.m_path.string();
+
+        if (a_diagnostic.m_line != 0)
+            a_ostream << ':' << a_diagnostic.m_line << ':' << a_diagnostic.m_column;
+
+        return a_ostream << ": " << a_diagnostic.m_message;
+    }
+
+    syntax_check_result check_syntax(const std::vector<std::string> &a_files, size_t a_threads)
+    {
+        syntax_check_result l_result;
+
+        std::mutex l_mutex;
+        std::condition_variable l_changed;
+
+        // files waiting to be checked, and how many are being checked
+        std::deque<fs::path> l_queue;
+        size_t l_busy = 0;
+
+        // every file ever queued, so that each is checked once
+        std::set<fs::path> l_queued;
+
+        for (const std::string &l_file : a_files)
+        {
+            std::string l_message;
+
+            if (std::optional<fs::path> l_path = resolve(l_file, l_message))
+            {
+                if (l_queued.insert(*l_path).second)
+                    l_queue.push_back(*l_path);
+            }
+            else
+            {
+                l_result.m_diagnostics.push_back({.m_path = l_file, .m_message = l_message});
+            }
+        }
+
+        /////////////////////////////////////////
+        // workers take files until none are queued and none are being
+        //     checked, which could still queue the files they refer to
+        /////////////////////////////////////////
+        auto l_work = [&]()
+        {
+            for (;;)
+            {
+                fs::path l_path;
+
+                {
+                    std::unique_lock l_lock(l_mutex);
+
+                    l_changed.wait(l_lock, [&]()
+                                   { return !l_queue.empty() || l_busy == 0; });
+
+                    if (l_queue.empty())
+                        return;
+
+                    l_path = std::move(l_queue.front());
+                    l_queue.pop_front();
+
+                    ++l_busy;
+                }
+
+                file_check l_check = check_file(l_path);
+
+                {
+                    std::lock_guard l_lock(l_mutex);
+
+                    for (const fs::path &l_referred : l_check.m_referred)
+                        if (l_queued.insert(l_referred).second)
+                            l_queue.push_back(l_referred);
+
+                    std::move(l_check.m_diagnostics.begin(), l_check.m_diagnostics.end(),
+                              std::back_inserter(l_result.m_diagnostics));
+
+                    ++l_result.m_files;
+                    l_result.m_statements += l_check.m_statements;
+                    l_result.m_bytes += l_check.m_bytes;
+
+                    --l_busy;
+                }
+
+                l_changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> l_workers;
+
+        for (size_t i = 1; i < a_threads; ++i)
+            l_workers.emplace_back(l_work);
+
+        l_work();
+
+        for (std::thread &l_worker : l_workers)
+            l_worker.join();
+
+        /////////////////////////////////////////
+        // the order files were checked in varies from run to run
+        /////////////////////////////////////////
+        std::stable_sort(l_result.m_diagnostics.begin(), l_result.m_diagnostics.end(),
+                         [](const syntax_diagnostic &a_lhs, const syntax_diagnostic &a_rhs)
+                         {
+                             return std::tie(a_lhs.m_path, a_lhs.m_line, a_lhs.m_column) <
+                                    std::tie(a_rhs.m_path, a_rhs.m_line, a_rhs.m_column);
+                         });
+
+        return l_result;
+    }
+
+}
+
+#ifdef UNIT_TEST
+
+#include <fstream>
+#include <sstream>
+#include "test_utils.hpp"
+
+////////////////////////////////
+//// HELPER FUNCTIONS
+////////////////////////////////
+
+static void write_file(const fs::path &a_path, const std::string &a_contents)
+{
+    std::ofstream l_ofs(a_path, std::ios::binary | std::ios::trunc);
+    l_ofs << a_contents;
+}
+
+static std::vector<std::string> format_diagnostics(const unilog::syntax_check_result &a_result, const fs::path &a_directory)
+{
+    std::vector<std::string> l_result;
+
+    for (unilog::syntax_diagnostic l_diagnostic : a_result.m_diagnostics)
+    {
+        l_diagnostic.m_path = l_diagnostic.m_path.lexically_relative(a_directory);
+
+        std::stringstream l_ss;
+        l_ss << l_diagnostic;
+        l_result.push_back(l_ss.str());
+    }
+
+    return l_result;
+}
+
+////////////////////////////////
+//// TESTS
+////////////////////////////////
+
+static void test_check_syntax()
+{
+    fs::path l_directory = fs::canonical(fs::temp_directory_path()) / "unilog_syntax_check";
+
+    fs::remove_all(l_directory);
+    fs::create_directories(l_directory / "sub");
+
+    write_file(l_directory / "main.u",
+               "axiom a x;\n"
+               "refer s './sub/s.u';\n"
+               "refer m './missing.u';\n"
+               "refer d './sub';\n"
+               "refer again './main.u';\n");
+
+    // refers are relative to the referring file, and cycles are checked once
+    write_file(l_directory / "sub" / "s.u",
+               "refer b '../bad.u';\n"
+               "refer main '../main.u';\n");
+
+    // checking goes on past each bad statement
+    write_file(l_directory / "bad.u",
+               "axiom a [x;\n"
+               "axiom b y;\n"
+               "  axiom c 'z\n"
+               ";\n"
+               "axiom d y;\n"
+               "axiom e");
+
+    std::vector<std::string> l_expected =
+        {
+            "bad.u:1:12: " ERR_MSG_MALFORMED_TERM,
+            "bad.u:3:11: " ERR_MSG_CLOSING_QUOTE,
+            "bad.u:6:8: " ERR_MSG_MALFORMED_STMT,
+            "main.u:3:1: " ERR_MSG_FILE_OPEN ": " + (l_directory / "missing.u").string(),
+            "main.u:4:1: " ERR_MSG_NOT_A_FILE ": " + (l_directory / "sub").string(),
+            "missing_root.u: " ERR_MSG_FILE_OPEN ": " + (l_directory / "missing_root.u").string(),
+        };
+
+    for (size_t l_threads : {1, 2, 8})
+    {
+        unilog::syntax_check_result l_result = unilog::check_syntax(
+            {
+                (l_directory / "main.u").string(),
+                (l_directory / "sub" / "s.u").string(),
+                (l_directory / "missing_root.u").string(),
+            },
+            l_threads);
+
+        std::vector<std::string> l_diagnostics = format_diagnostics(l_result, l_directory);
+
+        if (l_diagnostics != l_expected)
+        {
+            for (const std::string &l_diagnostic : l_diagnostics)
+                std::cerr << l_diagnostic << std::endl;
+        }
+
+        assert(l_diagnostics == l_expected);
+        assert(l_result.m_files == 3);
+        assert(l_result.m_statements == 5 + 2 + 2);
+    }
+
+    fs::remove_all(l_directory);
+}
+
+void test_syntax_check_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_check_syntax);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SYNTAX_CHECK_HPP
+#define SYNTAX_CHECK_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+namespace unilog
+{
+
+    // a problem found while checking the syntax of a file
+    struct syntax_diagnostic
+    {
+        std::filesystem::path m_path;
+
+        // one-based, as line_index::position gives them. 0 when the
+        //     problem is with the file as a whole.
+        size_t m_line = 0;
+        size_t m_column = 0;
+
+        std::string m_message;
+    };
+
+    // written as "path:line:column: message", one per line
+    std::ostream &operator<<(std::ostream &a_ostream, const syntax_diagnostic &a_diagnostic);
+
+    struct syntax_check_result
+    {
+        // ordered by path, then by position
+        std::vector<syntax_diagnostic> m_diagnostics;
+
+        size_t m_files = 0;
+        size_t m_statements = 0;
+        size_t m_bytes = 0;
+    };
+
+    // lexes and parses a_files, and every file they refer to, without
+    //     prolog. referred paths are resolved against the directory of the
+    //     file referring them, as executing would. each file is checked
+    //     once, however often it is referred, by one of a_threads workers.
+    //     a statement which fails to parse is reported, and checking goes
+    //     on from the next one.
+    syntax_check_result check_syntax(const std::vector<std::string> &a_files, size_t a_threads);
+
+}
+
+#endif
@@ -3,6 +3,10 @@
 %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 % Helper
 
+% canonical_hash(+Term, -Hash) is foreign (src/parser.cpp): a 64-bit hash
+% of Term's form, equal for terms which differ only in variable names.
+% Compounds other than lists, floats and strings raise a type error.
+
 scope([claim, S, Internal], [S|NextBScope], Descoped) :-
     scope(Internal, NextBScope, Descoped),
     !.
@@ -176,6 +180,33 @@ wipe_database :-
     retractall(redir(_, _, _)),
     !.
 
+% undo a single declaration, so that its statement may be executed again
+retract_theorem(ModulePath, Tag) :-
+    retractall(theorem(ModulePath, Tag, _)),
+    !.
+
+retract_redir(ModulePath, Tag) :-
+    retractall(redir(ModulePath, Tag, _)),
+    !.
+
+% undo every declaration inside a module, including its submodules
+%     (whose paths end with the module's path)
+retract_module(ModulePath) :-
+    forall(
+        (theorem(Path, Tag, _), append(_, ModulePath, Path)),
+        retractall(theorem(Path, Tag, _))
+    ),
+    forall(
+        (redir(Path, Tag, _), append(_, ModulePath, Path)),
+        retractall(redir(Path, Tag, _))
+    ),
+    !.
+
+module_declared(ModulePath) :-
+    (theorem(Path, _, _) ; redir(Path, _, _)),
+    append(_, ModulePath, Path),
+    !.
+
 test(Predicate) :-
     write(">>>> TEST STARTING: "),
     write(Predicate),
@@ -211,6 +242,37 @@ test_wipe_database :-
     test_case(tc_wipe_database_0),
     test_case(tc_wipe_database_1).
 
+    % only the named theorem is retracted
+    tc_retract_theorem_0 :-
+        decl_theorem([], a0, x),
+        decl_theorem([], a1, y),
+        retract_theorem([], a0),
+        \+ theorem([], a0, _),
+        theorem([], a1, _).
+
+    % the same tag in another module is left alone
+    tc_retract_redir_0 :-
+        decl_redir([], r0, x),
+        decl_redir([m], r0, x),
+        retract_redir([], r0),
+        \+ redir([], r0, _),
+        redir([m], r0, _).
+
+    % submodules are retracted along with the module
+    tc_retract_module_0 :-
+        decl_theorem([m, root], a0, x),
+        decl_redir([sub, m, root], r0, x),
+        decl_theorem([root], a0, x),
+        module_declared([m, root]),
+        retract_module([m, root]),
+        \+ module_declared([m, root]),
+        theorem([root], a0, _).
+
+test_retract :-
+    test_case(tc_retract_theorem_0),
+    test_case(tc_retract_redir_0),
+    test_case(tc_retract_module_0).
+
     % make sure decl_theorem calls assertz
     tc_decl_theorem_0 :-
         decl_theorem([], a0, x),
@@ -1153,8 +1215,42 @@ test_discharge_assume :-
     test_case(tc_discharge_assume_27),
     test_case(tc_discharge_assume_28).
 
+    % variants hash equal, and other forms do not
+    tc_canonical_hash_0 :-
+        canonical_hash([if, X, [and, X, Y]], H0),
+        canonical_hash([if, A, [and, A, B]], H1),
+        canonical_hash([if, X, [and, Y, X]], H2),
+        H0 == H1,
+        H0 \== H2,
+        var(X), var(Y), var(A), var(B).
+
+    % atoms and integers hash too
+    tc_canonical_hash_1 :-
+        canonical_hash(a0, H0),
+        canonical_hash(a0, H1),
+        canonical_hash(7, H2),
+        integer(H0),
+        H0 == H1,
+        H0 \== H2.
+
+    % anything else is a type error, not a failure
+    tc_canonical_hash_2 :-
+        catch(
+            (canonical_hash(f(x), _), fail),
+            error(type_error(list_or_atom, _), _),
+            true
+        ).
+
+% canonical_hash/2 is foreign, so this runs where it is registered
+%     (the unit tests), and is skipped when this file is only compiled
+test_canonical_hash :-
+    test_case(tc_canonical_hash_0),
+    test_case(tc_canonical_hash_1),
+    test_case(tc_canonical_hash_2).
+
 :-
     test(test_wipe_database),
+    test(test_retract),
     test(test_decl_theorem),
     test(test_decl_redir),
     %test(test_infer),
@@ -1178,4 +1274,5 @@ test_discharge_assume :-
     test(test_bout),
     test(test_dout),
     test(test_discharge_assume),
+    (current_predicate(canonical_hash/2) -> test(test_canonical_hash) ; true),
     wipe_database. % do a terminal db wipe
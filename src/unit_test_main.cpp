@@ -3,18 +3,45 @@
 #include <iostream>
 #include <SWI-Prolog.h>
 #include "test_utils.hpp"
+#include "parser.hpp"
 
+extern void test_scan_main();
+extern void test_symbol_main();
+extern void test_line_index_main();
 extern void test_lexer_main();
+extern void test_variable_table_main();
+extern void test_ast_main();
 extern void test_parser_main();
+extern void test_parallel_parser_main();
+extern void test_compiled_module_main();
+extern void test_serializer_main();
+extern void test_syntax_check_main();
+extern void test_source_file_main();
 extern void test_executor_main();
+extern void test_json_main();
+extern void test_document_main();
+extern void test_language_server_main();
 
 void unit_test_main()
 {
     constexpr bool ENABLE_DEBUG_LOGS = true;
 
+    TEST(test_scan_main);
+    TEST(test_symbol_main);
+    TEST(test_line_index_main);
     TEST(test_lexer_main);
+    TEST(test_variable_table_main);
+    TEST(test_ast_main);
     TEST(test_parser_main);
+    TEST(test_parallel_parser_main);
+    TEST(test_compiled_module_main);
+    TEST(test_serializer_main);
+    TEST(test_syntax_check_main);
+    TEST(test_source_file_main);
     TEST(test_executor_main);
+    TEST(test_json_main);
+    TEST(test_document_main);
+    TEST(test_language_server_main);
 }
 
 int main(int argc, char **argv)
@@ -23,6 +50,9 @@ int main(int argc, char **argv)
 
     const char *plav[] = {argv[0], "--quiet", "--nosignals"};
 
+    /* register foreign predicates, before Prolog starts */
+    register_foreign_predicates();
+
     /* initialise Prolog */
     if (!PL_initialise(3, const_cast<char **>(plav)))
         PL_halt(1);
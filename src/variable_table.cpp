@@ -0,0 +1,109 @@
+#include "variable_table.hpp"
+
+#ifdef UNIT_TEST
+
+#include <map>
+#include <string>
+#include "test_utils.hpp"
+
+static void test_variable_table_inline()
+{
+    unilog::variable_table<int, 4> l_table;
+
+    assert(l_table.size() == 0);
+    assert(l_table.find("A") == nullptr);
+
+    /////////////////////////////////////////
+    // the first occurrence inserts, later ones find the entry
+    /////////////////////////////////////////
+    auto [l_a, l_a_inserted] = l_table.try_emplace("A", 10);
+    assert(l_a_inserted && *l_a == 10);
+
+    auto [l_b, l_b_inserted] = l_table.try_emplace("B", 20);
+    assert(l_b_inserted && *l_b == 20);
+
+    auto [l_again, l_again_inserted] = l_table.try_emplace("A", 30);
+    assert(!l_again_inserted && *l_again == 10);
+
+    assert(l_table.size() == 2);
+    assert(l_table.contains("A"));
+    assert(l_table.contains("B"));
+    assert(!l_table.contains("C"));
+
+    /////////////////////////////////////////
+    // entries are visited in order of insertion while inline
+    /////////////////////////////////////////
+    std::string l_order;
+
+    l_table.for_each([&l_order](unilog::symbol a_name, int)
+                     { l_order += a_name.text(); });
+
+    assert(l_order == "AB");
+}
+
+static void test_variable_table_overflow()
+{
+    unilog::variable_table<int, 4> l_table;
+
+    /////////////////////////////////////////
+    // more entries than fit inline move to the hash map
+    /////////////////////////////////////////
+    for (int i = 0; i < 100; ++i)
+    {
+        auto [l_value, l_inserted] = l_table.try_emplace("V" + std::to_string(i), i);
+        assert(l_inserted && *l_value == i);
+    }
+
+    assert(l_table.size() == 100);
+
+    for (int i = 0; i < 100; ++i)
+        assert(*l_table.find("V" + std::to_string(i)) == i);
+
+    auto [l_value, l_inserted] = l_table.try_emplace("V3", -1);
+    assert(!l_inserted && *l_value == 3);
+
+    std::map<std::string, int> l_visited;
+
+    l_table.for_each([&l_visited](unilog::symbol a_name, int a_value)
+                     { l_visited.emplace(a_name.text(), a_value); });
+
+    assert(l_visited.size() == 100);
+    assert(l_visited.at("V42") == 42);
+}
+
+static void test_variable_table_clear()
+{
+    unilog::variable_table<int, 4> l_table;
+
+    /////////////////////////////////////////
+    // a cleared table is empty, both after inline use and after overflow
+    /////////////////////////////////////////
+    for (int l_count : {3, 10, 2})
+    {
+        for (int i = 0; i < l_count; ++i)
+            l_table.try_emplace("V" + std::to_string(i), i);
+
+        assert((int)l_table.size() == l_count);
+
+        l_table.clear();
+
+        assert(l_table.size() == 0);
+        assert(!l_table.contains("V0"));
+    }
+
+    // and is usable again
+    l_table.try_emplace("X", 7);
+    assert(*l_table.find("X") == 7);
+    assert(l_table.size() == 1);
+}
+
+void test_variable_table_main()
+{
+    constexpr bool ENABLE_DEBUG_LOGS = true;
+
+    TEST(test_variable_table_inline);
+    TEST(test_variable_table_overflow);
+    TEST(test_variable_table_clear);
+}
+
+#endif
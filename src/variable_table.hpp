@@ -0,0 +1,108 @@
+#ifndef VARIABLE_TABLE_HPP
+#define VARIABLE_TABLE_HPP
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <unordered_map>
+#include "symbol.hpp"
+
+namespace unilog
+{
+
+    // the variables of one statement, keyed by name. statements rarely have
+    //     more than a handful of variables, so the first InlineCapacity are
+    //     kept in place and found by a linear scan of their ids. past that,
+    //     every entry moves into a hash map. clearing keeps all storage, so
+    //     one table can be reused statement after statement.
+    template <typename Value, size_t InlineCapacity = 16>
+    class variable_table
+    {
+    private:
+        // the entries, in order of insertion, while there are few enough
+        std::array<symbol, InlineCapacity> m_inline_names;
+        std::array<Value, InlineCapacity> m_inline_values;
+        size_t m_inline_size = 0;
+
+        // every entry, once there are more than InlineCapacity of them
+        std::unordered_map<symbol, Value> m_overflow;
+
+        bool overflowed() const { return !m_overflow.empty(); }
+
+    public:
+        // the value of a_name, or nullptr. valid until the next insertion.
+        Value *find(symbol a_name)
+        {
+            if (overflowed())
+            {
+                auto l_entry = m_overflow.find(a_name);
+                return l_entry == m_overflow.end() ? nullptr : &l_entry->second;
+            }
+
+            for (size_t i = 0; i < m_inline_size; ++i)
+                if (m_inline_names[i] == a_name)
+                    return &m_inline_values[i];
+
+            return nullptr;
+        }
+
+        bool contains(symbol a_name) { return find(a_name) != nullptr; }
+
+        // inserts a_value for a_name, unless a_name has an entry already.
+        //     returns the entry's value, and whether it was inserted.
+        std::pair<Value *, bool> try_emplace(symbol a_name, const Value &a_value)
+        {
+            if (Value *l_value = find(a_name))
+                return {l_value, false};
+
+            if (!overflowed())
+            {
+                if (m_inline_size < InlineCapacity)
+                {
+                    m_inline_names[m_inline_size] = a_name;
+                    m_inline_values[m_inline_size] = a_value;
+
+                    return {&m_inline_values[m_inline_size++], true};
+                }
+
+                /////////////////////////////////////////
+                // out of inline room, so move every entry to the hash map
+                /////////////////////////////////////////
+                for (size_t i = 0; i < m_inline_size; ++i)
+                    m_overflow.emplace(m_inline_names[i], m_inline_values[i]);
+
+                m_inline_size = 0;
+            }
+
+            return {&m_overflow.emplace(a_name, a_value).first->second, true};
+        }
+
+        size_t size() const { return overflowed() ? m_overflow.size() : m_inline_size; }
+
+        // calls a_visit(name, value) for every entry
+        template <typename Visit>
+        void for_each(Visit &&a_visit) const
+        {
+            if (overflowed())
+            {
+                for (const auto &[l_name, l_value] : m_overflow)
+                    a_visit(l_name, l_value);
+
+                return;
+            }
+
+            for (size_t i = 0; i < m_inline_size; ++i)
+                a_visit(m_inline_names[i], m_inline_values[i]);
+        }
+
+        // removes every entry, keeping the storage
+        void clear()
+        {
+            m_inline_size = 0;
+            m_overflow.clear();
+        }
+    };
+
+}
+
+#endif